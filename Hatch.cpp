@@ -10,15 +10,41 @@
 #include <string>
 #include <functional>
 #include <map>
+#include <thread>
 
 #include "stb_image.h"
 #include "shader.h"
 #include "camera.h"
+#include "mesh.h"
+#include "skinning.h"
+#include "animation.h"
+#include "timing.h"
+#include "inputrecord.h"
+#include "profiler.h"
+#include "gputimer.h"
+#include "flightrecorder.h"
+#include "metricsserver.h"
+#include "hud.h"
+#include "scenario.h"
+#include "microbench.h"
+#include "framearena.h"
+#include "allocationhook.h"
+#include "jobs.h"
+#include "renderthread.h"
+#include "streambuffer.h"
+#include "modelimport.h"
+#include "gltf.h"
+#include "geometry.h"
+#include "meshlod.h"
+#include "meshregistry.h"
+#include "meshlet.h"
+#include "impostor.h"
+#include "staticbatch.h"
 
 struct Node {
 	std::string object;
 	glm::mat4 model;
-	std::vector< std::reference_wrapper<Node>> children;
+	FrameVector< std::reference_wrapper<Node>> children; // nodes are rebuilt for every pose, so only live for a frame
 
 	void updateTranslate(glm::vec3 translation) {
 		model = glm::translate(model, translation);
@@ -53,6 +79,124 @@ enum LampState
 	Other2
 };
 
+// lamp parts in bone order, used by both the per part and the skinned renderer
+enum LampBone
+{
+	LampBase,
+	LampLowerarm,
+	LampHinge,
+	LampTail,
+	LampUpperarm,
+	LampHead,
+	LampBulb,
+	LampHorn,
+	LampHorn2,
+	LAMP_BONES
+};
+
+// the lamp parts drawn with the sphere mesh, the rest are cubes
+const int LAMP_SPHERE_BONES[] = { LampHinge, LampTail, LampHorn, LampHorn2 };
+
+struct LampPose {
+	glm::mat4 bones[LAMP_BONES];
+	glm::vec3 lightPosition;
+	glm::vec3 lightDirection;
+};
+
+// blends from one lamp pose to the next when the state changes
+struct LampAnimation {
+	LampState from;
+	LampState to;
+	float transitionTime;
+};
+
+const float LAMP_TRANSITION_TIME = 0.5f; // seconds to move between poses
+
+const int CLOUD_COUNT = 3;
+const int STATIC_BATCHES = 4; // room shell materials: floor, walls, right and left window
+const int IMPORTED_MODEL_DRAWS = 16; // placed nodes of the --model asset, each with its own transform
+
+// everything that moves on its own, advanced in fixed steps by the frame graph
+struct SimulationState {
+	bool eggAnimating;
+	float eggTime; // time into the current jump
+	float nextJump; // time until the next jump starts
+	glm::vec3 clouds[CLOUD_COUNT];
+	LampAnimation lamp1;
+	LampAnimation lamp2;
+};
+
+// Every draw made with room.frag, each one's index in the frame's draw table.
+enum DrawId {
+	DrawStatic, // STATIC_BATCHES room shell batches, already in world space and set once at load
+	DrawTable = DrawStatic + STATIC_BATCHES, // base, 4 legs and the egg base
+	DrawEgg = DrawTable + 6,
+	DrawClouds, // the visible clouds first
+	DrawLampParts = DrawClouds + CLOUD_COUNT, // LAMP_BONES per lamp
+	DrawSkinnedLamps = DrawLampParts + 2 * LAMP_BONES, // material only, skinned.vert ignores the model
+	DrawImportedModel, // IMPORTED_MODEL_DRAWS nodes of the --model asset
+	DRAW_COUNT = DrawImportedModel + IMPORTED_MODEL_DRAWS
+};
+
+// One draw's constants, the std140 layout of the Draw block in room.vert and room.frag.
+struct DrawConstants {
+	glm::mat4 model;
+	glm::mat4 normalModel; // inverse transpose of model, so no vertex has to invert it
+	float shininess;
+	float padding[3];
+};
+
+const GLuint DRAW_BLOCK_BINDING = 0;
+
+// One draw of the --model asset, whichever file it came from.
+struct ModelPart {
+	unsigned int vertexArray;
+	GLenum indexType; // 0 to draw the vertices in order
+	int lodCount;
+	MeshLod lods[MAX_MESH_LODS]; // in indices of indexType, or vertices
+	unsigned int diffuse;
+	unsigned int specular;
+	int node; // draw slot after DrawImportedModel
+	MeshletSet* meshlets[MAX_MESH_LODS]; // cooked meshes only, culled just before the draw
+};
+
+// Inputs and results of the frame task graph. The tasks fill it in, then it is
+// copied into the render thread's snapshot.
+struct FrameData {
+	int steps; // simulation steps to take this frame
+	float step;
+	float alpha;
+	glm::mat4 projection;
+	glm::mat4 view;
+	SimulationState state; // blended between the last two steps
+	LampPose lamps[2];
+	bool lampVisible[2];
+	bool tableVisible;
+	int lampLods[2]; // sphere level of detail of each lamp
+	int eggLod;
+	float importedPixelsPerUnit[IMPORTED_MODEL_DRAWS]; // each part picks its own level from these
+	DrawConstants draws[DRAW_COUNT];
+	int cloudDraws;
+};
+
+// Everything the render thread needs for one frame. The main thread fills it in and
+// publishes it, after which nothing writes to it until the render thread is done.
+struct RenderSnapshot {
+	int64_t frameNumber;
+	FrameData frame;
+	glm::vec3 viewPos;
+	int framebufferWidth;
+	int framebufferHeight;
+	bool dirLightOn;
+	bool lamp1On;
+	bool lamp2On;
+	bool skinnedLamps;
+	bool sphereImpostors;
+	bool hudVisible;
+	bool reportPrinting;
+	int64_t mainAllocations; // heap allocations the main thread and the job workers made building it
+};
+
 void processInput(GLFWwindow* window);
 void mouse_callback(GLFWwindow* window, double xposIn, double yposIn);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
@@ -60,10 +204,37 @@ void framebuffer_resize(GLFWwindow* window, int width, int height);
 unsigned int loadTexture(char const* path);
 unsigned int loadSkybox(std::vector<std::string> faces);
 void renderCube();
-void renderTable(Shader& tableShader);
-void renderSphere();
-void renderLamp(Shader lampShader, glm::vec3 pos, glm::vec3 scale, float angle, glm::vec3 axis, LampState state, int lampNum);
-void renderNode(Shader& shader, Node node);
+void renderTable(int eggLod, bool egg = true);
+void renderEggImpostor(EllipsoidImpostors& impostors, Shader& shader, const glm::mat4& model);
+unsigned int loadTextureFromMemory(const unsigned char* bytes, size_t size, const char* name);
+unsigned int textureFromPixels(unsigned char* data, int width, int height, int nrComponents, const char* path);
+void renderImportedModel(const std::vector<ModelPart>& parts, const FrameData& frame);
+bool loadGltfModel(GltfModel& model, const std::string& path, std::vector<ModelPart>& parts);
+glm::mat4 eggModelMatrix(const SimulationState& state);
+void updateEgg(SimulationState& state, float dt);
+void updateClouds(SimulationState& state, float dt);
+void buildFrameGraph(TaskGraph& graph, FrameData& frame, const std::vector<AnimationClip>& lampClips, const AnimationEvaluator& lampEvaluator);
+void setDraw(DrawConstants& draw, const glm::mat4& model, float shininess = 32.0f);
+void buildRoomDraws(FrameData& frame);
+void writeDraws(const DrawConstants* draws, int64_t frame);
+void bindDraw(int draw);
+SimulationState interpolateSimulation(const SimulationState& previous, const SimulationState& current, float alpha);
+bool keyToggled(int key, bool& keyDown);
+void mouseMoved(double xposIn, double yposIn);
+void renderSphere(int lod = 0);
+LampPose evaluateLamp(glm::vec3 pos, glm::vec3 scale, float angle, glm::vec3 axis, LampState state);
+Skeleton lampSkeleton();
+std::vector<AnimationClip> buildLampClips();
+std::vector<AnimationClip> buildLampTransitionClips(const std::vector<AnimationClip>& poses);
+void updateLampAnimation(LampAnimation& animation, LampState state, float dt);
+RigInstance lampRigInstance(const std::vector<AnimationClip>& clips, const LampAnimation& animation, glm::vec3 pos, float scale, float angle, glm::vec3 axis);
+LampPose lampPoseFromBones(const glm::mat4* bones, const LampAnimation& animation);
+void setLampLight(Shader& lampShader, const LampPose& pose, int lampNum);
+void renderLamp(int lampNum, int lod, bool spheres = true);
+void setLightingUniforms(Shader& shader, const RenderSnapshot& snapshot);
+void applyScenarioEvent(const ScenarioEvent& event);
+bool runHotPathBenchmarks(const std::string& out, const std::string& filter);
+bool runSphereBenchmark(Shader& meshShader, Shader& impostorShader, int count);
 
 
 
@@ -75,8 +246,19 @@ bool firstMouse = true; // Keeps track of if mouse has been used yet
 float lastX = WIDTH / 2; // Keeps track of mouse since last frame
 float lastY = HEIGHT / 2;  // Keeps track of mouse since last frame
 
-float deltaTime = 0.0f; // Time between current frame and last frame
-float lastFrame = 0.0f; // Time of last frame
+float deltaTime = 0.0f; // Real time between current frame and last frame, used for camera movement
+FixedStepTimer simulationTimer; // Fixed steps for everything in SimulationState
+InputFrame frameInput; // frame time, keys and mouse events of the frame being processed
+bool replayingInput = false; // input comes from a recording, live glfw events are ignored
+bool pauseKey = false;
+bool profileKey = false;
+bool reportKey = false;
+bool hudKey = false;
+bool hudVisible = false;
+FrameReport frameReport; // cpu and gpu time of every render pass, owned by the render thread
+bool reportPrinting = false;
+bool slowerKey = false;
+bool fasterKey = false;
 
 unsigned int floorTexture, floorTextureSpec, wallTexture, wallTextureSpec, windowTextureLeft, windowTextureRight, eggTexture, eggSpec, skyboxTexture, cloudTexture, tableTexture, tableSpec, lampTexture;
 LampState currentLamp1State = Default;
@@ -89,14 +271,142 @@ bool lamp1On = true;
 bool lamp2On = true; 
 bool dirLightKey = false;
 bool dirLightOn = true;  
+bool skinnedLampsKey = false;
+bool skinnedLamps = true; // draw every lamp with one instanced skinned draw
+bool sphereImpostorsKey = false;
+bool sphereImpostors = false; // spheres as ray traced quads (impostor.h) instead of meshes
+StreamBuffer* drawBuffer = nullptr; // per draw constants, one region a frame
+GLintptr drawStride = 0; // bytes between draws, a multiple of the uniform buffer offset alignment
+glm::mat4 importedModelMatrix = glm::mat4(1.0f); // where the --model asset stands
+glm::mat4 importedDequantize = glm::mat4(1.0f); // quantized cooked positions to model space
+glm::mat4 importedNodes[IMPORTED_MODEL_DRAWS]; // node transforms inside the asset
+int importedNodeCount = 0;
+glm::vec3 importedCenter = glm::vec3(0.0f); // middle of its bounds, in the asset's space
+bool meshletCulling = true; // --no-meshlet-culling draws whole levels, to compare against
+MeshRegistry meshRegistry; // every generated mesh, optimised once at startup
+const RegisteredMesh* cubeMesh = nullptr;
+const RegisteredMesh* sphereMesh = nullptr; // every sphere drawn, the icosphere levels
+
+SimulationState simulation = {
+	false, 0.0f, 10.0f,
+	{
+		glm::vec3(35.0f, 10.0f, 0.0f),
+		glm::vec3(35.0f, 5.0f, -10.0f),
+		glm::vec3(35.0f, 7.5f,  20.0f),
+	},
+	{ Default, Default, LAMP_TRANSITION_TIME },
+	{ Default, Default, LAMP_TRANSITION_TIME },
+};
+SimulationState previousSimulation = simulation;
 
-
-bool eggAnimating = false; 
-float animationCounter = 0.0f;
-float nextJump = 10.0f; 
-
-int main()
+int main(int argc, char** argv)
 {
+	// benchmark modes run without a window
+	if (argc > 1 && std::string(argv[1]) == "--bench-animation") {
+		int rigs = argc > 2 ? std::stoi(argv[2]) : 100000;
+		std::vector<AnimationClip> clips = buildLampClips();
+		std::vector<AnimationClip> transitions = buildLampTransitionClips(clips);
+		clips.insert(clips.end(), transitions.begin(), transitions.end());
+		return runAnimationBenchmark(lampSkeleton(), clips, rigs) ? 0 : 1;
+	}
+	if (argc > 1 && std::string(argv[1]) == "--bench-profiler") {
+		runProfilerBenchmark();
+		return 0;
+	}
+	if (argc > 1 && std::string(argv[1]) == "--bench-jobs") {
+		return runJobBenchmark(argc > 2 ? std::stoi(argv[2]) : 200000) ? 0 : 1;
+	}
+	if (argc > 1 && std::string(argv[1]) == "--bench-micro") {
+		return runHotPathBenchmarks(argc > 2 ? argv[2] : "microbench.json", argc > 3 ? argv[3] : "") ? 0 : 1;
+	}
+	if (argc > 1 && std::string(argv[1]) == "--import-model") {
+		std::string layout = argc > 4 ? argv[4] : "compact";
+		if (argc < 4 || (layout != "float" && layout != "compact" && layout != "quantized")) {
+			std::cout << "usage: --import-model source.fbx out.mesh [float|compact|quantized]" << std::endl;
+			return 1;
+		}
+		return importModel(argv[2], argv[3], layout == "float" ? CookedFloatVertices : layout == "compact" ? CookedCompactVertices : CookedQuantizedVertices) ? 0 : 1;
+	}
+	if (argc > 1 && std::string(argv[1]) == "--clip-report") {
+		std::vector<AnimationClip> clips = buildLampClips();
+		std::vector<AnimationClip> transitions = buildLampTransitionClips(clips);
+		clips.insert(clips.end(), transitions.begin(), transitions.end());
+		return runClipReport(clips, ClipTolerance(), argc > 2 ? argv[2] : "") ? 0 : 1;
+	}
+
+	// record the input of this run, or replay a recorded one
+	InputRecorder recorder;
+	InputPlayback playback;
+	bool fastReplay = false;
+	FlightRecorder flightRecorder;
+	int metricsPort = 0;
+	// scripted benchmark run, see scenario.h
+	Scenario scenario;
+	bool runningScenario = false;
+	std::string benchmarkOut = "benchmark.json";
+	std::string modelPath;
+	std::string benchmarkBaseline;
+	double regressionTolerance = 0.1;
+	AllocationCheck allocationCheck;
+	int jobWorkers = (int)std::thread::hardware_concurrency() - 1;
+	int framesInFlight = 2;
+	int sphereBenchmark = 0; // spheres to draw each way, --bench-spheres
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--record" && i + 1 < argc) {
+			if (!recorder.open(argv[++i]))
+				return -1;
+		}
+		else if (arg == "--replay" && i + 1 < argc) {
+			if (!playback.open(argv[++i]))
+				return -1;
+			replayingInput = true;
+		}
+		else if (arg == "--fast") {
+			fastReplay = true;
+		}
+		else if (arg == "--stutter-budget" && i + 1 < argc) {
+			flightRecorder.budget = std::stof(argv[++i]);
+		}
+		else if (arg == "--metrics-port" && i + 1 < argc) {
+			metricsPort = std::stoi(argv[++i]);
+		}
+		else if (arg == "--scenario" && i + 1 < argc) {
+			if (!scenario.load(argv[++i]))
+				return -1;
+			runningScenario = true;
+		}
+		else if (arg == "--model" && i + 1 < argc) {
+			modelPath = argv[++i];
+		}
+		else if (arg == "--out" && i + 1 < argc) {
+			benchmarkOut = argv[++i];
+		}
+		else if (arg == "--baseline" && i + 1 < argc) {
+			benchmarkBaseline = argv[++i];
+		}
+		else if (arg == "--tolerance" && i + 1 < argc) {
+			regressionTolerance = std::stod(argv[++i]);
+		}
+		else if (arg == "--check-allocations") {
+			allocationCheck.enabled = true;
+		}
+		else if (arg == "--jobs" && i + 1 < argc) {
+			jobWorkers = std::stoi(argv[++i]);
+		}
+		else if (arg == "--frames-in-flight" && i + 1 < argc) {
+			framesInFlight = std::stoi(argv[++i]);
+		}
+		else if (arg == "--no-meshlet-culling") {
+			meshletCulling = false;
+		}
+		else if (arg == "--sphere-impostors") {
+			sphereImpostors = true;
+		}
+		else if (arg == "--bench-spheres") {
+			sphereBenchmark = i + 1 < argc && argv[i + 1][0] != '-' ? std::stoi(argv[++i]) : 4096;
+		}
+	}
 
 	// initialization and setup 
 
@@ -104,6 +414,8 @@ int main()
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	if (runningScenario || sphereBenchmark > 0)
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE); // benchmarks run without showing a window
 
 	GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Scene View", NULL, NULL);
 	if (window == NULL)
@@ -117,6 +429,8 @@ int main()
 	glfwSetFramebufferSizeCallback(window, framebuffer_resize); // Sets resizing function
 	glfwSetCursorPosCallback(window, mouse_callback);
 	glfwSetScrollCallback(window, scroll_callback);
+	if ((replayingInput && fastReplay) || runningScenario || sphereBenchmark > 0)
+		glfwSwapInterval(0); // as fast as possible, no waiting for vsync
 	glfwWindowHint(GLFW_SAMPLES, 8); // multisample buffer (4 Samples)
 
 	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
@@ -124,6 +438,7 @@ int main()
 		std::cout << "GLAD failed to load" << std::endl;
 		return -1;
 	}
+	PROFILE_INSTALL_SIGNAL();
 
 	stbi_set_flip_vertically_on_load(false);
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -146,21 +461,6 @@ int main()
 	   -10.0f, -0.0f, -10.0f, 0.0f, 1.0f, 0.0f,  0.0f, 2.0f,
 	    10.0f, -0.0f, -10.0f, 0.0f, 1.0f, 0.0f, 2.0f, 2.0f
 	};
-    
-	unsigned int floorVAO, floorVBO;
-	glGenVertexArrays(1, &floorVAO);
-	glGenBuffers(1, &floorVBO);
-	glBindVertexArray(floorVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, floorVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(floorVertices), floorVertices, GL_STATIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-	glBindVertexArray(0);
-
 
 	// wall setup
 
@@ -174,20 +474,6 @@ int main()
 		-5.0f,  5.0f,  5.0f, -5.0f,  0.0f,  0.0f, 2.0f, 0.0f, 
 	};
 
-	unsigned int wallVAO, wallVBO;
-	glGenVertexArrays(1, &wallVAO);
-	glGenBuffers(1, &wallVBO);
-	glBindVertexArray(wallVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, wallVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(wallVertices), wallVertices, GL_STATIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-	glBindVertexArray(0);
-
 	// window setup
 
 	float windowVertices[] = {
@@ -200,18 +486,15 @@ int main()
 		-5.0f,  5.0f,  5.0f, -5.0f,  0.0f,  0.0f, 1.0f, 0.0f,
 	};
 
+	// the clouds use the window quad too
 	unsigned int winVAO, winVBO;
 	glGenVertexArrays(1, &winVAO);
 	glGenBuffers(1, &winVBO);
 	glBindVertexArray(winVAO);
 	glBindBuffer(GL_ARRAY_BUFFER, winVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(windowVertices), windowVertices, GL_STATIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+	countBufferMemory(sizeof(windowVertices));
+	MeshVertexFormat::setup();
 	glBindVertexArray(0);
 
 	// skybox setup 
@@ -267,8 +550,8 @@ int main()
 	glBindVertexArray(skyVAO);
 	glBindBuffer(GL_ARRAY_BUFFER, skyVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+	countBufferMemory(sizeof(skyboxVertices));
+	PositionVertexFormat::setup();
 
 	// shaders and textures
 	// 
@@ -307,300 +590,887 @@ int main()
 	skyboxShader.setInt("skybox", 0);
 	roomShader.setInt("material.diffuse", 0);
 	roomShader.setInt("material.specular", 1);
-
-	std::vector<glm::vec3> cloudPositions = {
-		glm::vec3(35.0f, 10.0f, 0.0f),
-		glm::vec3(35.0f, 5.0f, -10.0f),
-		glm::vec3(35.0f, 7.5f,  20.0f),
+	Shader skinnedShader("Shaders/skinned.vert", "Shaders/room.frag");
+	skinnedShader.use();
+	skinnedShader.setInt("material.diffuse", 0);
+	skinnedShader.setInt("material.specular", 1);
+	Shader impostorShader("Shaders/impostor.vert", "Shaders/impostor.frag");
+	impostorShader.use();
+	impostorShader.setInt("material.diffuse", 0);
+	impostorShader.setInt("material.specular", 1);
+	roomShader.setBlockBinding("Draw", DRAW_BLOCK_BINDING);
+	skinnedShader.setBlockBinding("Draw", DRAW_BLOCK_BINDING);
+	impostorShader.setBlockBinding("Draw", DRAW_BLOCK_BINDING);
+
+	// model matrices and materials go through a stream buffer instead of a glUniform call per draw
+	GLint uniformAlignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+	drawStride = ((GLintptr)sizeof(DrawConstants) + uniformAlignment - 1) / uniformAlignment * uniformAlignment;
+	StreamBuffer drawStream(GL_UNIFORM_BUFFER, DRAW_COUNT * drawStride, (GLADloadproc)glfwGetProcAddress);
+	drawBuffer = &drawStream;
+
+	// The room shell never moves, so the floor, walls and windows go into world space once
+	// and draw as one batch per material instead of a draw each with its own model matrix.
+	// The windows used to take whichever specular map the table left bound, now the wall's.
+	StaticBatcher roomShell;
+	const StaticMaterial wallMaterial = { wallTexture, wallTextureSpec, 32.0f };
+	MeshData wallQuad = unindexedMesh(wallVertices, sizeof(wallVertices) / sizeof(float));
+	MeshData windowQuad = unindexedMesh(windowVertices, sizeof(windowVertices) / sizeof(float));
+	const int floorBatch = roomShell.add(unindexedMesh(floorVertices, sizeof(floorVertices) / sizeof(float)), glm::mat4(1.0f),
+		{ floorTexture, floorTextureSpec, 32.0f });
+	// walls: bottom left, top left, bottom right, top right
+	glm::mat4 shellModel = glm::translate(glm::mat4(1.0f), glm::vec3(-5.0f, 5.0f, 5.0f));
+	shellModel = glm::rotate(shellModel, glm::radians(180.0f), glm::vec3(0.0, 1.0, 0.0));
+	const int wallBatch = roomShell.add(wallQuad, glm::translate(shellModel, glm::vec3(10.0f, 0.0f, 0.0f)), wallMaterial);
+	shellModel = glm::translate(glm::mat4(1.0f), glm::vec3(-5.0f, 5.0f, -5.0f));
+	shellModel = glm::rotate(shellModel, glm::radians(180.0f), glm::vec3(0.0, 1.0, 0.0));
+	roomShell.add(wallQuad, glm::translate(shellModel, glm::vec3(10.0f, 0.0f, 0.0f)), wallMaterial);
+	roomShell.add(wallQuad, glm::translate(glm::mat4(1.0f), glm::vec3(15.0f, 5.0f, 5.0f)), wallMaterial);
+	roomShell.add(wallQuad, glm::translate(glm::mat4(1.0f), glm::vec3(15.0f, 5.0f, -5.0f)), wallMaterial);
+	// windows: back right, back left
+	shellModel = glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(0.0, 1.0, 0.0));
+	shellModel = glm::rotate(shellModel, glm::radians(90.0f), glm::vec3(1.0, 0.0, 0.0));
+	const int windowBatches[2] = {
+		roomShell.add(windowQuad, glm::translate(shellModel, glm::vec3(15.0f, 5.0f, -5.0f)), { windowTextureRight, wallTextureSpec, 32.0f }),
+		roomShell.add(windowQuad, glm::translate(shellModel, glm::vec3(15.0f, -5.0f, -5.0f)), { windowTextureLeft, wallTextureSpec, 32.0f }),
 	};
-
-	while (!glfwWindowShouldClose(window))
-	{
-		float currentFrame = static_cast<float>(glfwGetTime());
-		deltaTime = currentFrame - lastFrame;
-		lastFrame = currentFrame;
-
-		processInput(window);
-
-		glClearColor(0.53f, 0.81f, 0.92f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-
-		// egg animation
-		if (nextJump <= 0) {
-			eggAnimating = true;
-		} else {
-			nextJump -= deltaTime;
+	roomShell.build();
+	if (roomShell.batchCount() > STATIC_BATCHES)
+		std::cout << "ERROR::STATICBATCH::TOO_MANY_BATCHES: " << roomShell.batchCount() << " materials, draw slots for " << STATIC_BATCHES << std::endl;
+
+	// lamp rig, every part merged into one mesh with its bone index, once per sphere level of detail
+	cubeMesh = meshRegistry.add("cube", makeCube());
+	sphereMesh = meshRegistry.add("sphere", icosphereLodChain(4, 4));
+	const MeshData& cubeData = cubeMesh->chain.mesh;
+	std::vector<SkinnedRig> lampRigs;
+	lampRigs.reserve(MAX_MESH_LODS);
+	for (int lod = 0; lod < sphereMesh->chain.lodCount; lod++) {
+		MeshData sphereData = sphereMesh->chain.level(lod);
+		lampRigs.emplace_back(std::vector<SkinnedPart>{
+			{ &cubeData, LampBase },
+			{ &cubeData, LampLowerarm },
+			{ &sphereData, LampHinge },
+			{ &sphereData, LampTail },
+			{ &cubeData, LampUpperarm },
+			{ &cubeData, LampHead },
+			{ &cubeData, LampBulb },
+			{ &sphereData, LampHorn },
+			{ &sphereData, LampHorn2 },
+		}, LAMP_BONES);
+	}
+	// the cubes alone, for when the spheres are impostors
+	SkinnedRig lampFrameRig(std::vector<SkinnedPart>{
+		{ &cubeData, LampBase },
+		{ &cubeData, LampLowerarm },
+		{ &cubeData, LampUpperarm },
+		{ &cubeData, LampHead },
+		{ &cubeData, LampBulb },
+	}, LAMP_BONES);
+	EllipsoidImpostors lampImpostors(2 * sizeof(LAMP_SPHERE_BONES) / sizeof(LAMP_SPHERE_BONES[0]));
+	EllipsoidImpostors eggImpostor(1);
+
+	if (sphereBenchmark > 0)
+		return runSphereBenchmark(skinnedShader, impostorShader, sphereBenchmark) ? 0 : 1;
+
+	// the --model asset stood on the floor in the corner, a cooked mesh (--import-model) or a
+	// glTF binary, either way uploaded straight from the file mapping
+	CookedMesh importedModel;
+	Mesh importedMesh;
+	std::vector<MeshletSet> importedMeshlets;
+	GltfModel gltfModel;
+	std::vector<ModelPart> importedParts;
+	glm::vec3 low(0.0f), high(0.0f);
+	bool glb = modelPath.size() > 4 && modelPath.compare(modelPath.size() - 4, 4, ".glb") == 0;
+	if (glb && loadGltfModel(gltfModel, modelPath, importedParts)) {
+		gltfModel.bounds(low, high);
+	}
+	else if (!glb && !modelPath.empty() && importedModel.open(modelPath)) {
+		const CookedMeshHeader& header = importedModel.header();
+		importedMesh = importedModel.upload();
+		importedDequantize = importedModel.dequantize();
+		importedMeshlets.reserve(header.submeshCount * MAX_MESH_LODS); // parts point into it
+		for (uint32_t i = 0; i < header.submeshCount; i++) {
+			const CookedSubmesh& submesh = importedModel.submesh(i);
+			unsigned int diffuse = submesh.diffuse[0] != 0 ? loadTexture(submesh.diffuse) : tableTexture;
+			unsigned int specular = submesh.specular[0] != 0 ? loadTexture(submesh.specular) : tableSpec;
+			ModelPart part = { importedMesh.VAO, GL_UNSIGNED_INT, (int)submesh.lodCount, {}, diffuse, specular, 0 };
+			std::copy(submesh.lods, submesh.lods + submesh.lodCount, part.lods);
+			for (uint32_t lod = 0; lod < submesh.lodCount; lod++) {
+				importedMeshlets.emplace_back(importedModel.meshlets() + submesh.firstMeshlet[lod], submesh.meshletCount[lod]);
+				part.meshlets[lod] = &importedMeshlets.back();
+			}
+			importedParts.push_back(part);
 		}
+		importedNodes[0] = glm::mat4(1.0f); // the node hierarchy is baked in on import
+		importedNodeCount = 1;
+		low = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+		high = glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+	}
+	if (!importedParts.empty()) {
+		importedCenter = (low + high) * 0.5f;
+		glm::vec3 extent = high - low;
+		float scale = 3.0f / glm::max(glm::max(extent.x, extent.y), glm::max(extent.z, 0.001f)); // 3 units at its largest
+		importedModelMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(6.0f, 0.0f, -6.0f));
+		importedModelMatrix = glm::scale(importedModelMatrix, glm::vec3(scale));
+		importedModelMatrix = glm::translate(importedModelMatrix, -glm::vec3((low.x + high.x) * 0.5f, low.y, (low.z + high.z) * 0.5f));
+	}
 
-		// rendering commands
-		glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)WIDTH / (float)HEIGHT, 0.1f, 50.0f);
-		glm::mat4 view = camera.GetViewMatrix();
-		glm::mat4 model = glm::mat4(1.0f);
-
-		roomShader.use();
-
-		// lamps
-
-		renderLamp(roomShader, glm::vec3(-5.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f), 0.0f, glm::vec3(1.0f, 0.0f, 0.0f), currentLamp1State, 1);
-		renderLamp(roomShader, glm::vec3(-4.0f, 0.0f, 0.0f), glm::vec3(0.75f, 0.75f, 0.75f), 180.0f, glm::vec3(0.0f, 1.0f, 0.0f), currentLamp2State, 2);
+	Hud hud;
+
+	// lamp poses as clips, evaluated for every lamp in one batch
+	std::vector<AnimationClip> lampClips = buildLampClips();
+	AnimationEvaluator lampEvaluator(lampSkeleton());
+
+	// simulation, lamp poses, culling and command building run as tasks
+	JobSystem jobs(jobWorkers, threadHeapAllocations); // the workers' allocations count towards the frame
+	FrameData frameData;
+	for (int i = 0; i < roomShell.batchCount() && i < STATIC_BATCHES; i++)
+		setDraw(frameData.draws[DrawStatic + i], glm::mat4(1.0f), roomShell.batch(i).material.shininess); // never rebuilt
+	TaskGraph frameGraph;
+	buildFrameGraph(frameGraph, frameData, lampClips, lampEvaluator);
+
+	Clock clock;
+	int64_t lastFrameTime = clock.elapsed();
+	int64_t replayedFrames = 0;
+	GpuTimer gpuTimer;
+	int64_t frameNumber = 0;
+	renderStats() = RenderStats(); // loading uploads are not part of any frame
+
+	// prometheus endpoint for unattended runs
+	LiveMetrics liveMetrics;
+	MetricsServer metricsServer(liveMetrics);
+	if (metricsPort > 0)
+		metricsServer.start(metricsPort);
+
+	ScenarioRun scenarioRun(scenario);
+
+	// The render thread owns the gl context from here on. It submits frame N from a snapshot
+	// while this thread takes input and simulates frame N+1 into the other one.
+	SnapshotBuffer<RenderSnapshot> snapshots;
+	glfwMakeContextCurrent(NULL);
+	std::thread renderThread([&]() {
+		glfwMakeContextCurrent(window);
+		FrameFences fences(framesInFlight);
+		int64_t lastFrameEnd = Clock::now();
+		for (;;) {
+			const RenderSnapshot* next = snapshots.beginRead();
+			if (next == nullptr)
+				break;
+			const RenderSnapshot& snapshot = *next;
+			const FrameData& frame = snapshot.frame;
+			int64_t frameStart = Clock::now();
+			int64_t frameAllocations = threadHeapAllocations();
+			frameArena().reset();
+			frameReport.printing = snapshot.reportPrinting;
+			frameReport.beginFrame(snapshot.frameNumber);
+			gpuTimer.beginFrame(snapshot.frameNumber, frameReport);
+			fences.wait(snapshot.frameNumber);
+
+			writeDraws(frame.draws, snapshot.frameNumber);
+			const LampPose& lamp1Pose = frame.lamps[0];
+			const LampPose& lamp2Pose = frame.lamps[1];
+
+			glClearColor(0.53f, 0.81f, 0.92f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			// lamps
+
+			if (snapshot.sphereImpostors) {
+				impostorShader.use();
+				setLightingUniforms(impostorShader, snapshot);
+				setLampLight(impostorShader, lamp1Pose, 1);
+				setLampLight(impostorShader, lamp2Pose, 2);
+			}
+			roomShader.use();
+			setLightingUniforms(roomShader, snapshot);
+			setLampLight(roomShader, lamp1Pose, 1);
+			setLampLight(roomShader, lamp2Pose, 2);
+
+			{
+				RENDER_PASS(gpuTimer, frameReport, PassLamps);
+				if (snapshot.skinnedLamps) {
+					PROFILE_ZONE("skinned lamps");
+					skinnedShader.use();
+					setLightingUniforms(skinnedShader, snapshot);
+					setLampLight(skinnedShader, lamp1Pose, 1);
+					setLampLight(skinnedShader, lamp2Pose, 2);
+
+					glActiveTexture(GL_TEXTURE0);
+					glBindTexture(GL_TEXTURE_2D, lampTexture);
+					countStateChange();
+					if (frame.lampVisible[0])
+						(snapshot.sphereImpostors ? lampFrameRig : lampRigs[frame.lampLods[0]]).addInstance(lamp1Pose.bones);
+					if (frame.lampVisible[1])
+						(snapshot.sphereImpostors ? lampFrameRig : lampRigs[frame.lampLods[1]]).addInstance(lamp2Pose.bones);
+					bindDraw(DrawSkinnedLamps);
+					for (SkinnedRig& rig : lampRigs)
+						rig.draw(skinnedShader); // one instanced draw per level in use
+					lampFrameRig.draw(skinnedShader);
+					roomShader.use();
+				} else {
+					if (frame.lampVisible[0])
+						renderLamp(1, frame.lampLods[0], !snapshot.sphereImpostors);
+					if (frame.lampVisible[1])
+						renderLamp(2, frame.lampLods[1], !snapshot.sphereImpostors);
+				}
+				if (snapshot.sphereImpostors) {
+					// every sphere of both lamps in one draw, lampTexture is still bound
+					for (int lamp = 0; lamp < 2; lamp++) {
+						for (int bone : LAMP_SPHERE_BONES) {
+							if (frame.lampVisible[lamp])
+								lampImpostors.add(frame.lamps[lamp].bones[bone]);
+						}
+					}
+					bindDraw(DrawSkinnedLamps);
+					lampImpostors.draw(impostorShader);
+					roomShader.use();
+				}
+			}
 
-		// floor
+			// floor
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, floorTexture);
+			{
+				RENDER_PASS(gpuTimer, frameReport, PassFloor);
+				bindDraw(DrawStatic + floorBatch);
+				roomShell.draw(floorBatch);
+			}
 
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, floorTextureSpec);
+			// walls
 
+			{
+				RENDER_PASS(gpuTimer, frameReport, PassWalls);
+				bindDraw(DrawStatic + wallBatch); // all 4
+				roomShell.draw(wallBatch);
+			}
 
-		model = glm::mat4(1.0f);
+			// Room Items
+
+			{
+				RENDER_PASS(gpuTimer, frameReport, PassTable);
+				if (frame.tableVisible) {
+					renderTable(frame.eggLod, !snapshot.sphereImpostors);
+					if (snapshot.sphereImpostors) {
+						renderEggImpostor(eggImpostor, impostorShader, frame.draws[DrawEgg].model);
+						roomShader.use();
+					}
+				}
+				if (!importedParts.empty())
+					renderImportedModel(importedParts, frame);
+			}
 
-		roomShader.use();
-		roomShader.setMat4("projection", projection);
-		roomShader.setMat4("view", view);
-		roomShader.setMat4("model", model);
+			// window
 
-		roomShader.setVec3("viewPos", camera.Position);
-		roomShader.setFloat("material.shininess", 32.0f);
-		roomShader.setBool("dirLightOn", dirLightOn); // handle directional lighting on/off
-		roomShader.setBool("lightingOn", true);
-		roomShader.setBool("lamp1On", lamp1On);
-		roomShader.setBool("lamp2On", lamp2On);
+			{
+				RENDER_PASS(gpuTimer, frameReport, PassWindows);
+				for (int batch : windowBatches) {
+					bindDraw(DrawStatic + batch);
+					roomShell.draw(batch);
+				}
+			}
 
-		// directionalLight
-		roomShader.setVec3("dirLights[0].direction", -10.0f, -10.0f, 0.0f);
-		roomShader.setVec3("dirLights[0].ambient", 0.05f, 0.05f, 0.05f);
-		roomShader.setVec3("dirLights[0].diffuse", 0.8f, 0.8f, 0.8f);
-		roomShader.setVec3("dirLights[0].specular", 0.5f, 0.5f, 0.5f);
+			// skybox
+			{
+				RENDER_PASS(gpuTimer, frameReport, PassSkybox);
+				glDepthFunc(GL_LEQUAL);
+				glEnable(GL_DEPTH_CLAMP);
+				skyboxShader.use();
+				glm::mat4 view = glm::mat4(glm::mat3(frame.view));
+				skyboxShader.setMat4("view", view);
+				skyboxShader.setMat4("projection", frame.projection);
+				glBindVertexArray(skyVAO);
+				countStateChange();
+				glActiveTexture(GL_TEXTURE0);
+				glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxTexture);
+				countStateChange();
+				glDrawArrays(GL_TRIANGLES, 0, 36);
+				countDraw(36);
+				glBindVertexArray(0);
+				glDisable(GL_DEPTH_CLAMP);
+				glDepthFunc(GL_LESS);
+			}
 
-		roomShader.setVec3("dirLights[1].direction", 10.0f, 10.0f, -5.0f);
-		roomShader.setVec3("dirLights[1].ambient", 0.05f, 0.05f, 0.05f);
-		roomShader.setVec3("dirLights[1].diffuse", 0.8f, 0.8f, 0.8f);
-		roomShader.setVec3("dirLights[1].specular", 0.5f, 0.5f, 0.5f);
+			// clouds
+			{
+				RENDER_PASS(gpuTimer, frameReport, PassClouds);
+				roomShader.use();
+				roomShader.setBool("lightingOn", false);
+				glActiveTexture(GL_TEXTURE0);
+				glBindTexture(GL_TEXTURE_2D, cloudTexture);
+				countStateChange();
+
+				for (int i = 0; i < frame.cloudDraws; i++) {
+					bindDraw(DrawClouds + i);
+					glBindVertexArray(winVAO);
+					countStateChange();
+					glDrawArrays(GL_TRIANGLES, 0, 6);
+					countDraw(6);
+				}
+				roomShader.setBool("lightingOn", true);
+			}
 
+			// performance overlay, timed as its own pass so its cost is not hidden in the others
+			if (snapshot.hudVisible) {
+				RENDER_PASS(gpuTimer, frameReport, PassHud);
+				hud.draw(snapshot.framebufferWidth, snapshot.framebufferHeight, frameReport);
+			}
 
-		glBindVertexArray(floorVAO);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
-		
-		// walls
+			int64_t swapStart = Clock::now();
+			{
+				PROFILE_ZONE("swap buffers");
+				glfwSwapBuffers(window);
+			}
+			fences.signal(snapshot.frameNumber);
+			drawBuffer->endFrame();
+			int64_t frameEnd = Clock::now();
+			int64_t frameNanoseconds = frameEnd - lastFrameEnd; // time between presents, what the viewer sees
+			lastFrameEnd = frameEnd;
+			allocationCheck.endFrame(snapshot.frameNumber, snapshot.mainAllocations + threadHeapAllocations() - frameAllocations);
+			snapshots.endRead();
+			frameReport.endFrame((float)(frameNanoseconds / 1.0e6), (float)((swapStart - frameStart) / 1.0e6), renderStats());
+			liveMetrics.recordFrame(frameNanoseconds, renderStats());
+			hud.addFrame((float)(frameNanoseconds / 1.0e6));
+			renderStats() = RenderStats();
+			if (frameReport.complete() != nullptr)
+				flightRecorder.record(*frameReport.complete());
+		}
+		fences.clear();
+		// main terminates glfw before its locals are destroyed, so their gl objects go here
+		gpuTimer.release();
+		drawBuffer->release();
+		glfwMakeContextCurrent(NULL);
+	});
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, wallTexture);
+	while (!glfwWindowShouldClose(window))
+	{
+		int64_t frameStart = Clock::now();
+		int64_t frameAllocations = threadHeapAllocations() + jobs.workerAllocations();
+		frameArena().reset();
+
+		// frame time and input come from the scenario or the recording, otherwise from the clock and glfw
+		if (runningScenario) {
+			if (scenarioRun.finished())
+				break;
+			frameInput.frameNanoseconds = scenario.frameNanoseconds();
+			frameInput.keys = 0;
+			frameInput.events.clear();
+			for (const ScenarioEvent& event : scenarioRun.beginFrame(camera))
+				applyScenarioEvent(event);
+		}
+		else if (replayingInput) {
+			if (!playback.next(frameInput))
+				break;
+			replayedFrames++;
+			int64_t ahead = playback.elapsed() - clock.elapsed();
+			if (!fastReplay && ahead > 0)
+				std::this_thread::sleep_for(std::chrono::nanoseconds(ahead));
+		}
+		else {
+			int64_t frameTime = clock.elapsed();
+			frameInput.frameNanoseconds = frameTime - lastFrameTime;
+			lastFrameTime = frameTime;
+			frameInput.keys = pollRecordedKeys(window);
+			if (recorder.isOpen())
+				recorder.record(frameInput);
+		}
+		int64_t frameNanoseconds = frameInput.frameNanoseconds;
+		deltaTime = (float)Clock::toSeconds(frameNanoseconds);
 
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, wallTextureSpec);
-
-		// bottom left
-		model = glm::mat4(1.0f);
-	    model = glm::translate(model, glm::vec3(-5.0f, 5.0f, 5.0f));
-		model = glm::rotate(model, glm::radians(180.0f), glm::vec3(0.0, 1.0, 0.0)); 
-		model = glm::translate(model, glm::vec3(10.0f, 0.0f, 0.0f));
-		roomShader.use();
-		roomShader.setMat4("model", model);
-		glBindVertexArray(wallVAO);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
-
-		// top left
-		model = glm::mat4(1.0f);
-		model = glm::translate(model, glm::vec3(-5.0f, 5.0f, -5.0f));
-		model = glm::rotate(model, glm::radians(180.0f), glm::vec3(0.0, 1.0, 0.0));
-		model = glm::translate(model, glm::vec3(10.0f, 0.0f, 0.0f));
-		roomShader.use();
-		roomShader.setMat4("model", model);
-		glBindVertexArray(wallVAO);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
-
-		// bottom right
-		model = glm::mat4(1.0f);
-		model = glm::translate(model, glm::vec3(15.0f, 5.0f, 5.0f));
-		roomShader.use();
-		roomShader.setMat4("model", model);
-		glBindVertexArray(wallVAO);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
-
-		// top right
-		model = glm::mat4(1.0f);
-		model = glm::translate(model, glm::vec3(15.0f, 5.0f, -5.0f));
-		roomShader.use();
-		roomShader.setMat4("model", model);
-		glBindVertexArray(wallVAO);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
-
-		// Room Items
-
-		renderTable(roomShader);
-
-		// window
+		processInput(window);
+		frameInput.events.clear(); // callbacks during glfwPollEvents fill the next frame
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, windowTextureRight);
-
-		// back right
-		model = glm::mat4(1.0f);
-		model = glm::rotate(model, glm::radians(90.0f), glm::vec3(0.0, 1.0, 0.0));
-		model = glm::rotate(model, glm::radians(90.0f), glm::vec3(1.0, 0.0, 0.0));
-		model = glm::translate(model, glm::vec3(15.0f, 5.0f, -5.0f));
-		roomShader.use();
-		roomShader.setMat4("model", model);
-		glBindVertexArray(winVAO);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
+		// simulation runs in fixed steps, rendering blends the last two steps
+		frameData.steps = simulationTimer.advance(frameNanoseconds);
+		frameData.step = simulationTimer.step();
+		frameData.alpha = simulationTimer.alpha();
+		PROFILE_COUNTER("simulation steps", frameData.steps);
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, windowTextureLeft);
-
-		// back left
-		model = glm::mat4(1.0f);
-		model = glm::rotate(model, glm::radians(90.0f), glm::vec3(0.0, 1.0, 0.0));
-		model = glm::rotate(model, glm::radians(90.0f), glm::vec3(1.0, 0.0, 0.0));
-		model = glm::translate(model, glm::vec3(15.0f, -5.0f, -5.0f));
-		roomShader.use();
-		roomShader.setMat4("model", model);
-		glBindVertexArray(winVAO);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
-
-		// skybox
-		glDepthFunc(GL_LEQUAL);
-		glEnable(GL_DEPTH_CLAMP);
-		skyboxShader.use();
-		view = glm::mat4(glm::mat3(camera.GetViewMatrix()));
-		skyboxShader.setMat4("view", view);
-		skyboxShader.setMat4("projection", projection);
-		glBindVertexArray(skyVAO);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxTexture);
-		glDrawArrays(GL_TRIANGLES, 0, 36);
-		glBindVertexArray(0);
-		glDisable(GL_DEPTH_CLAMP);
-		glDepthFunc(GL_LESS);
-
-		// clouds
-		roomShader.use();
-		roomShader.setBool("lightingOn", false);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, cloudTexture);
+		// camera for the frame, culled against on the job threads
+		frameData.projection = glm::perspective(glm::radians(camera.Zoom), (float)WIDTH / (float)HEIGHT, 0.1f, 50.0f);
+		frameData.view = camera.GetViewMatrix();
+		jobs.run(frameGraph);
 
-		for (int i = 0; i < cloudPositions.size(); i++) {
-			model = glm::mat4(1.0f);
-			model = glm::rotate(model, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-			if (cloudPositions[i].z < -40.0f) {
-				cloudPositions[i].z += 80.0f;
-			}
-			model = glm::translate(model, glm::vec3(cloudPositions[i].x, cloudPositions[i].y, cloudPositions[i].z -= (deltaTime * 3.0f)));
-			roomShader.setMat4("model", model);
-			glBindVertexArray(winVAO);
-			glDrawArrays(GL_TRIANGLES, 0, 6);
+		// waits only when the render thread is still on the frame before last
+		RenderSnapshot* snapshot;
+		{
+			PROFILE_ZONE("wait for render thread");
+			snapshot = &snapshots.beginWrite();
 		}
-		roomShader.setBool("lightingOn", true);
+		snapshot->frameNumber = frameNumber;
+		snapshot->frame = frameData;
+		snapshot->viewPos = camera.Position;
+		glfwGetFramebufferSize(window, &snapshot->framebufferWidth, &snapshot->framebufferHeight);
+		snapshot->dirLightOn = dirLightOn;
+		snapshot->lamp1On = lamp1On;
+		snapshot->lamp2On = lamp2On;
+		snapshot->skinnedLamps = skinnedLamps;
+		snapshot->sphereImpostors = sphereImpostors;
+		snapshot->hudVisible = hudVisible;
+		snapshot->reportPrinting = reportPrinting;
 
-		glfwSwapBuffers(window);
 		glfwPollEvents();
+		int64_t frameEnd = Clock::now();
+		snapshot->mainAllocations = threadHeapAllocations() + jobs.workerAllocations() - frameAllocations;
+		snapshots.publish();
+		if (runningScenario)
+			scenarioRun.endFrame((float)((frameEnd - frameStart) / 1.0e6));
+		frameNumber++;
+		PROFILE_FRAME();
 	}
-
+	snapshots.close();
+	renderThread.join();
+	glfwMakeContextCurrent(window);
+
+	if (replayingInput) {
+		double seconds = Clock::toSeconds(clock.elapsed());
+		std::cout << "Replayed " << replayedFrames << " frames (" << Clock::toSeconds(playback.elapsed()) << "s recorded) in "
+			<< seconds << "s, " << replayedFrames / seconds << " fps" << std::endl;
+	}
+	recorder.close();
 	glfwTerminate();
-	return 0;
+	bool allocationFree = allocationCheck.report();
+
+	// nonzero exit on a regression so scripts can gate on it
+	if (runningScenario) {
+		BenchmarkResult result = scenarioRun.result();
+		std::cout << "Scenario " << scenario.name << ": " << result.frames << " frames, p50 " << result.p50 << "ms, p95 "
+			<< result.p95 << "ms, p99 " << result.p99 << "ms" << std::endl;
+		if (!writeBenchmarkJson(benchmarkOut, scenario.name, result))
+			return 1;
+		if (!benchmarkBaseline.empty()) {
+			BenchmarkResult baseline;
+			if (!readBenchmarkJson(benchmarkBaseline, baseline))
+				return 1;
+			if (!compareToBaseline(result, baseline, regressionTolerance)) {
+				std::cout << "Slower than " << benchmarkBaseline << " by more than " << regressionTolerance * 100.0 << "%" << std::endl;
+				return 2;
+			}
+		}
+	}
+	return allocationFree ? 0 : 3;
 }
 
 
-void renderTable(Shader& tableShader) {
+void renderTable(int eggLod, bool egg) {
+	PROFILE_ZONE("renderTable");
 
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, tableTexture);
+	countStateChange();
 
 	glActiveTexture(GL_TEXTURE1);
 	glBindTexture(GL_TEXTURE_2D, tableSpec);
+	countStateChange();
 
-	// base
-	glm::mat4 model = glm::mat4(1.0f);
-	model = glm::scale(model, glm::vec3(2.0f, 0.125f, 2.0f));
-	model = glm::translate(model, glm::vec3(0.0f, 20.0f, 0.0f));
-	tableShader.use();
-	tableShader.setMat4("model", model);
-	renderCube();
-
-	// front right leg
-	model = glm::mat4(1.0f);
-	model = glm::translate(model, glm::vec3(1.8f, 1.25f, 1.8f));
-	model = glm::scale(model, glm::vec3(0.125f, 1.25f, 0.125f));
-	tableShader.use();
-	tableShader.setMat4("model", model);
-	renderCube();
-
-	//front left leg
-	model = glm::mat4(1.0f);
-	model = glm::translate(model, glm::vec3(-1.8f, 1.25f, 1.8f));
-	model = glm::scale(model, glm::vec3(0.125f, 1.25f, 0.125f));
-	tableShader.use();
-	tableShader.setMat4("model", model);
-	renderCube();
-
-	//top right leg
-	model = glm::mat4(1.0f);
-	model = glm::translate(model, glm::vec3(1.8f, 1.25f, -1.8f));
-	model = glm::scale(model, glm::vec3(0.125f, 1.25f, 0.125f));
-	tableShader.use();
-	tableShader.setMat4("model", model);
-	renderCube();
-
-	//top left leg
-	model = glm::mat4(1.0f);
-	model = glm::translate(model, glm::vec3(-1.8f, 1.25f, -1.8f));
-	model = glm::scale(model, glm::vec3(0.125f, 1.25f, 0.125f));
-	tableShader.use();
-	tableShader.setMat4("model", model);
-	renderCube();
-
-	// egg base
-	model = glm::mat4(1.0f);
-	model = glm::scale(model, glm::vec3(0.5f, 0.125f, 0.5f));
-	model = glm::translate(model, glm::vec3(0.0f, 21.0f, 0.0f));
-	tableShader.use();
-	tableShader.setMat4("model", model);
-	renderCube();
+	// base, legs and egg base
+	for (int i = 0; i < 6; i++) {
+		bindDraw(DrawTable + i);
+		renderCube();
+	}
 
 	// egg
 
+	if (!egg)
+		return;
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, eggTexture);
+	countStateChange();
 
 	glActiveTexture(GL_TEXTURE1);
 	glBindTexture(GL_TEXTURE_2D, eggSpec);
+	countStateChange();
 
-	model = glm::mat4(1.0f);
-	model = glm::scale(model, glm::vec3(1.0f, 1.5f, 1.0f));
-	model = glm::translate(model, glm::vec3(0.0f, 2.25f, 0.0f));
+	bindDraw(DrawEgg);
+	renderSphere(eggLod);
+}
 
-	
-	// time of animation 1.257156
-	if (eggAnimating == true) { // handles animation
-		animationCounter += deltaTime;
-		model = glm::translate(model, glm::vec3(0.0f, (sin(animationCounter * 2.5) * 0.25f) + 0.01f, 0.0f));
-		float rotateDegree = (360.0 / 1.2571) * animationCounter;
-		model = glm::rotate(model, glm::radians(rotateDegree), glm::vec3(0.0f, 1.0f, 0.0f));
-		if (((sin(animationCounter * 2.5) * 0.25f)) + 0.01f <= 0.01f) {
-			eggAnimating = false;
-			nextJump = 20.0f;
-			animationCounter = 0.0f;
+// the egg as an impostor, for renderTable(eggLod, false)
+void renderEggImpostor(EllipsoidImpostors& impostors, Shader& shader, const glm::mat4& model)
+{
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, eggTexture);
+	countStateChange();
+
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, eggSpec);
+	countStateChange();
+
+	bindDraw(DrawEgg);
+	impostors.add(model);
+	impostors.draw(shader);
+}
 
+// one draw per part at the level of detail its node's size on screen needs, binding only
+// what changed since the last draw
+void renderImportedModel(const std::vector<ModelPart>& parts, const FrameData& frame)
+{
+	PROFILE_ZONE("renderImportedModel");
+	int node = -1;
+	unsigned int vertexArray = 0;
+	Frustum frustum(frame.projection * frame.view);
+	glm::vec3 camera(0.0f);
+	int meshletsCulled = 0;
+	bool backFaceCulling = false;
+	for (const ModelPart& part : parts) {
+		// Cooked meshes are closed, so their back faces are culled whichever path draws them
+		// and dropping meshlets that face away only skips what the rasterizer would. glTF
+		// parts may be double sided and keep both.
+		bool cooked = part.meshlets[0] != nullptr;
+		if (cooked != backFaceCulling) {
+			if (cooked)
+				glEnable(GL_CULL_FACE);
+			else
+				glDisable(GL_CULL_FACE);
+			countStateChange();
+			backFaceCulling = cooked;
+		}
+		if (part.node != node) {
+			bindDraw(DrawImportedModel + part.node);
+			node = part.node;
+			// meshlet bounds are in the asset's space, so the frustum and camera go there
+			glm::mat4 model = importedModelMatrix * importedNodes[node];
+			frustum = Frustum(frame.projection * frame.view * model);
+			camera = glm::vec3(glm::inverse(frame.view * model)[3]);
+		}
+		if (part.vertexArray != vertexArray) {
+			glBindVertexArray(part.vertexArray);
+			countStateChange();
+			vertexArray = part.vertexArray;
+		}
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, part.diffuse);
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, part.specular);
+		countStateChange(2);
+		int level = selectLod(part.lods, part.lodCount, frame.importedPixelsPerUnit[part.node]);
+		const MeshLod& lod = part.lods[level];
+		MeshletSet* meshlets = part.meshlets[level];
+		if (meshletCulling && meshlets != nullptr) {
+			// meshlets outside the frustum or facing away never reach the rasterizer, the
+			// visible ones go out as one call of merged index ranges
+			int ranges = meshlets->cull(frustum, camera);
+			if (ranges > 0) {
+				glMultiDrawElements(GL_TRIANGLES, meshlets->counts(), part.indexType, meshlets->offsets(), ranges);
+				countDraw(meshlets->triangles() * 3);
+			}
+			meshletsCulled += (int)meshlets->size() - meshlets->visible();
+			continue;
 		}
+		if (part.indexType != 0) {
+			size_t indexSize = part.indexType == GL_UNSIGNED_INT ? 4 : part.indexType == GL_UNSIGNED_SHORT ? 2 : 1;
+			glDrawElements(GL_TRIANGLES, lod.indexCount, part.indexType, (void*)(lod.firstIndex * indexSize));
+		}
+		else {
+			glDrawArrays(GL_TRIANGLES, lod.firstIndex, lod.indexCount);
+		}
+		countDraw(lod.indexCount);
 	}
+	if (backFaceCulling)
+		glDisable(GL_CULL_FACE);
+	glBindVertexArray(0);
+	PROFILE_COUNTER("meshlets culled", meshletsCulled);
+}
 
+// Maps a .glb, uploads its buffer views as they are and turns every primitive of every
+// placed node into a part. Base colour textures become material.diffuse and
+// KHR_materials_specular textures material.specular, the table's textures stand in
+// for any that are missing.
+bool loadGltfModel(GltfModel& model, const std::string& path, std::vector<ModelPart>& parts)
+{
+	auto start = std::chrono::steady_clock::now();
+	if (!model.open(path))
+		return false;
+	auto parsed = std::chrono::steady_clock::now();
+	model.upload();
+	auto uploaded = std::chrono::steady_clock::now();
+
+	std::vector<unsigned int> imageTextures(model.imageCount(), 0); // decoded once however many materials share them
+	auto texture = [&](int image, unsigned int fallback) {
+		if (image < 0)
+			return fallback;
+		if (imageTextures[image] == 0) {
+			const unsigned char* bytes = nullptr;
+			size_t size = 0;
+			std::string file = model.imagePath(image);
+			if (model.imageBytes(image, bytes, size))
+				imageTextures[image] = loadTextureFromMemory(bytes, size, path.c_str());
+			else if (!file.empty())
+				imageTextures[image] = loadTexture(file.c_str());
+			else
+				return fallback;
+		}
+		return imageTextures[image];
+	};
 
+	const std::vector<GltfInstance>& instances = model.instanceList();
+	if ((int)instances.size() > IMPORTED_MODEL_DRAWS)
+		std::cout << path << " places " << instances.size() << " meshes, only the first " << IMPORTED_MODEL_DRAWS << " are drawn" << std::endl;
+	importedNodeCount = 0;
+	for (const GltfInstance& instance : instances) {
+		if (importedNodeCount == IMPORTED_MODEL_DRAWS)
+			break;
+		const GltfMesh& mesh = model.meshList()[instance.mesh];
+		for (int p = mesh.firstPrimitive; p < mesh.firstPrimitive + mesh.primitiveCount; p++) {
+			const GltfPrimitive& primitive = model.primitiveList()[p];
+			GltfMaterial material = { -1, -1 };
+			if (primitive.material >= 0)
+				material = model.materialList()[primitive.material];
+			GLenum indexType = primitive.indices >= 0 ? primitive.indexType : 0;
+			unsigned int indexSize = indexType == GL_UNSIGNED_INT ? 4 : indexType == GL_UNSIGNED_SHORT ? 2 : 1;
+			MeshLod full = { primitive.indexOffset / indexSize, primitive.count, 0.0f }; // no levels, a .glb is drawn as stored
+			parts.push_back({ primitive.vertexArray, indexType, 1, { full }, texture(material.diffuseImage, tableTexture),
+				texture(material.specularImage, tableSpec), importedNodeCount });
+		}
+		importedNodes[importedNodeCount++] = instance.transform;
+	}
+	auto finished = std::chrono::steady_clock::now();
 
-	tableShader.use();
-	tableShader.setMat4("model", model);
-	tableShader.setFloat("material.shininess", 16.0f);
-	renderSphere();
-	tableShader.setFloat("material.shininess", 32.0f);
+	auto ms = [](std::chrono::steady_clock::duration time) { return std::chrono::duration<double, std::milli>(time).count(); };
+	std::cout << "loaded " << path << ": " << parts.size() << " draws in " << importedNodeCount << " nodes, " << model.size() << " bytes mapped, "
+		<< model.uploaded() << " uploaded. parse " << ms(parsed - start) << "ms, upload " << ms(uploaded - parsed) << "ms, textures "
+		<< ms(finished - uploaded) << "ms" << std::endl;
+	return !parts.empty();
+}
 
-	
+// the shared lighting state of room.frag, set on every program that uses it
+void setLightingUniforms(Shader& shader, const RenderSnapshot& snapshot)
+{
+	shader.setMat4("projection", snapshot.frame.projection);
+	shader.setMat4("view", snapshot.frame.view);
+
+	shader.setVec3("viewPos", snapshot.viewPos);
+	shader.setBool("dirLightOn", snapshot.dirLightOn); // handle directional lighting on/off
+	shader.setBool("lightingOn", true);
+	shader.setBool("lamp1On", snapshot.lamp1On);
+	shader.setBool("lamp2On", snapshot.lamp2On);
+
+	// directionalLight
+	shader.setVec3("dirLights[0].direction", -10.0f, -10.0f, 0.0f);
+	shader.setVec3("dirLights[0].ambient", 0.05f, 0.05f, 0.05f);
+	shader.setVec3("dirLights[0].diffuse", 0.8f, 0.8f, 0.8f);
+	shader.setVec3("dirLights[0].specular", 0.5f, 0.5f, 0.5f);
+
+	shader.setVec3("dirLights[1].direction", 10.0f, 10.0f, -5.0f);
+	shader.setVec3("dirLights[1].ambient", 0.05f, 0.05f, 0.05f);
+	shader.setVec3("dirLights[1].diffuse", 0.8f, 0.8f, 0.8f);
+	shader.setVec3("dirLights[1].specular", 0.5f, 0.5f, 0.5f);
 }
 
-void renderLamp(Shader lampShader, glm::vec3 pos, glm::vec3 scale, float angle, glm::vec3 axis, LampState state, int lampNum)
+// one fixed step of the egg jump
+void updateEgg(SimulationState& state, float dt)
 {
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, lampTexture);
+	// egg animation, time of animation 1.257156
+	if (state.nextJump <= 0) {
+		state.eggAnimating = true;
+	} else {
+		state.nextJump -= dt;
+	}
+	if (state.eggAnimating == true) {
+		state.eggTime += dt;
+		if (((sin(state.eggTime * 2.5) * 0.25f)) + 0.01f <= 0.01f) {
+			state.eggAnimating = false;
+			state.nextJump = 20.0f;
+			state.eggTime = 0.0f;
+		}
+	}
+}
+
+// one fixed step of the clouds, they drift past the window and wrap around
+void updateClouds(SimulationState& state, float dt)
+{
+	for (int i = 0; i < CLOUD_COUNT; i++) {
+		if (state.clouds[i].z < -40.0f) {
+			state.clouds[i].z += 80.0f;
+		}
+		state.clouds[i].z -= dt * 3.0f;
+	}
+}
+
+// The frame as tasks: egg, clouds and lamp transitions step independently, then the blended
+// state feeds the lamp poses, culling and the model matrices the render loop draws with.
+// The tasks touch separate parts of the simulation so they never need a lock.
+void buildFrameGraph(TaskGraph& graph, FrameData& frame, const std::vector<AnimationClip>& lampClips, const AnimationEvaluator& lampEvaluator)
+{
+	TaskSpan egg = graph.add("egg", [&frame]() {
+		for (int i = 0; i < frame.steps; i++) {
+			previousSimulation.eggAnimating = simulation.eggAnimating;
+			previousSimulation.eggTime = simulation.eggTime;
+			previousSimulation.nextJump = simulation.nextJump;
+			updateEgg(simulation, frame.step);
+		}
+	});
+	TaskSpan clouds = graph.add("clouds", [&frame]() {
+		for (int i = 0; i < frame.steps; i++) {
+			std::copy(simulation.clouds, simulation.clouds + CLOUD_COUNT, previousSimulation.clouds);
+			updateClouds(simulation, frame.step);
+		}
+	});
+	TaskSpan lampAnimation = graph.add("lamp animation", [&frame]() {
+		for (int i = 0; i < frame.steps; i++) {
+			previousSimulation.lamp1 = simulation.lamp1;
+			previousSimulation.lamp2 = simulation.lamp2;
+			updateLampAnimation(simulation.lamp1, currentLamp1State, frame.step);
+			updateLampAnimation(simulation.lamp2, currentLamp2State, frame.step);
+		}
+	}, JobHigh);
+	TaskSpan interpolate = graph.add("interpolate", [&frame]() {
+		frame.state = interpolateSimulation(previousSimulation, simulation, frame.alpha);
+	}, JobHigh);
+	TaskSpan lampPoses = graph.add("lamp poses", [&frame, &lampClips, &lampEvaluator]() {
+		RigInstance lampRigs[2] = {
+			lampRigInstance(lampClips, frame.state.lamp1, glm::vec3(-5.0f, 0.0f, 0.0f), 1.0f, 0.0f, glm::vec3(1.0f, 0.0f, 0.0f)),
+			lampRigInstance(lampClips, frame.state.lamp2, glm::vec3(-4.0f, 0.0f, 0.0f), 0.75f, 180.0f, glm::vec3(0.0f, 1.0f, 0.0f)),
+		};
+		glm::mat4 lampBones[2 * LAMP_BONES];
+		lampEvaluator.evaluate(lampRigs, 2, lampBones);
+		frame.lamps[0] = lampPoseFromBones(lampBones, frame.state.lamp1);
+		frame.lamps[1] = lampPoseFromBones(lampBones + LAMP_BONES, frame.state.lamp2);
+	}, JobHigh);
+	TaskSpan cull = graph.add("cull", [&frame]() {
+		Frustum frustum(frame.projection * frame.view);
+		for (int lamp = 0; lamp < 2; lamp++) {
+			// sphere around the bone origins, padded for the meshes hanging off them
+			glm::vec3 center(0.0f);
+			for (const glm::mat4& bone : frame.lamps[lamp].bones)
+				center += glm::vec3(bone[3]);
+			center /= (float)LAMP_BONES;
+			float radius = 0.0f;
+			for (const glm::mat4& bone : frame.lamps[lamp].bones)
+				radius = glm::max(radius, glm::length(glm::vec3(bone[3]) - center));
+			frame.lampVisible[lamp] = frustum.intersectsSphere(center, radius + 1.0f);
+		}
+		frame.tableVisible = frustum.intersectsSphere(glm::vec3(0.0f, 2.5f, 0.0f), 3.5f); // table and egg
+
+		// levels of detail from how big a mesh unit is on screen, the finest any sphere of a lamp needs
+		for (int lamp = 0; lamp < 2; lamp++) {
+			float pixelsPerUnit = 0.0f;
+			for (int bone : LAMP_SPHERE_BONES) {
+				const glm::mat4& model = frame.lamps[lamp].bones[bone];
+				pixelsPerUnit = glm::max(pixelsPerUnit, lodPixelsPerUnit(frame.projection, frame.view, glm::vec3(model[3]), modelScale(model), (float)HEIGHT));
+			}
+			frame.lampLods[lamp] = selectLod(sphereMesh->chain.lods, sphereMesh->chain.lodCount, pixelsPerUnit);
+		}
+		glm::mat4 egg = eggModelMatrix(frame.state);
+		frame.eggLod = selectLod(sphereMesh->chain.lods, sphereMesh->chain.lodCount, lodPixelsPerUnit(frame.projection, frame.view, glm::vec3(egg[3]), modelScale(egg), (float)HEIGHT));
+		glm::vec3 importedWorldCenter = glm::vec3(importedModelMatrix * glm::vec4(importedCenter, 1.0f));
+		for (int i = 0; i < importedNodeCount; i++) {
+			float scale = modelScale(importedModelMatrix * importedNodes[i]);
+			frame.importedPixelsPerUnit[i] = lodPixelsPerUnit(frame.projection, frame.view, importedWorldCenter, scale, (float)HEIGHT);
+		}
+		frame.cloudDraws = 0;
+		for (int i = 0; i < CLOUD_COUNT; i++) {
+			glm::mat4 model = glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+			model = glm::translate(model, frame.state.clouds[i]);
+			if (frustum.intersectsSphere(glm::vec3(model * glm::vec4(-5.0f, 0.0f, 0.0f, 1.0f)), 7.1f))
+				setDraw(frame.draws[DrawClouds + frame.cloudDraws++], model);
+		}
+	});
+	TaskSpan commands = graph.add("build commands", [&frame]() {
+		buildRoomDraws(frame);
+	});
+
+	graph.precede(egg, interpolate);
+	graph.precede(clouds, interpolate);
+	graph.precede(lampAnimation, interpolate);
+	graph.precede(interpolate, lampPoses);
+	graph.precede(lampPoses, commands);
+	graph.precede(lampPoses, cull);
+}
+
+void setDraw(DrawConstants& draw, const glm::mat4& model, float shininess)
+{
+	draw.model = model;
+	draw.normalModel = glm::mat4(glm::transpose(glm::inverse(glm::mat3(model))));
+	draw.shininess = shininess;
+}
+
+// model matrices and materials of every room draw except the clouds, which culling fills in,
+// and the static batches, set once at load
+void buildRoomDraws(FrameData& frame)
+{
+	DrawConstants* draws = frame.draws;
+
+	// table base, legs front right, front left, top right, top left, then the egg base
+	glm::mat4 model = glm::scale(glm::mat4(1.0f), glm::vec3(2.0f, 0.125f, 2.0f));
+	setDraw(draws[DrawTable], glm::translate(model, glm::vec3(0.0f, 20.0f, 0.0f)));
+	const glm::vec3 legs[4] = {
+		glm::vec3(1.8f, 1.25f, 1.8f),
+		glm::vec3(-1.8f, 1.25f, 1.8f),
+		glm::vec3(1.8f, 1.25f, -1.8f),
+		glm::vec3(-1.8f, 1.25f, -1.8f),
+	};
+	for (int i = 0; i < 4; i++) {
+		model = glm::translate(glm::mat4(1.0f), legs[i]);
+		setDraw(draws[DrawTable + 1 + i], glm::scale(model, glm::vec3(0.125f, 1.25f, 0.125f)));
+	}
+	model = glm::scale(glm::mat4(1.0f), glm::vec3(0.5f, 0.125f, 0.5f));
+	setDraw(draws[DrawTable + 5], glm::translate(model, glm::vec3(0.0f, 21.0f, 0.0f)));
+	setDraw(draws[DrawEgg], eggModelMatrix(frame.state), 16.0f);
 
+	for (int lamp = 0; lamp < 2; lamp++) {
+		for (int bone = 0; bone < LAMP_BONES; bone++)
+			setDraw(draws[DrawLampParts + lamp * LAMP_BONES + bone], frame.lamps[lamp].bones[bone]);
+	}
+	setDraw(draws[DrawSkinnedLamps], glm::mat4(1.0f));
+	for (int i = 0; i < importedNodeCount; i++) {
+		// the normal matrix comes from the model alone, dequantizing only moves positions
+		setDraw(draws[DrawImportedModel + i], importedModelMatrix * importedNodes[i]);
+		draws[DrawImportedModel + i].model *= importedDequantize;
+	}
+}
+
+// the frame's draw table into its region of the stream buffer, one draw every drawStride bytes
+void writeDraws(const DrawConstants* draws, int64_t frame)
+{
+	unsigned char* region = drawBuffer->beginFrame(frame);
+	if (region != nullptr) {
+		for (int i = 0; i < DRAW_COUNT; i++)
+			std::memcpy(region + i * drawStride, &draws[i], sizeof(DrawConstants));
+	}
+	drawBuffer->endWrites(DRAW_COUNT * drawStride);
+}
+
+void bindDraw(int draw)
+{
+	glBindBufferRange(GL_UNIFORM_BUFFER, DRAW_BLOCK_BINDING, drawBuffer->id(), drawBuffer->regionOffset() + draw * drawStride, sizeof(DrawConstants));
+}
+
+// state to render alpha of the way from the previous step to the current one
+SimulationState interpolateSimulation(const SimulationState& previous, const SimulationState& current, float alpha)
+{
+	SimulationState state = current;
+	if (previous.eggAnimating && current.eggAnimating) {
+		state.eggTime = glm::mix(previous.eggTime, current.eggTime, alpha);
+	}
+	for (int i = 0; i < CLOUD_COUNT; i++) {
+		if (glm::abs(current.clouds[i].z - previous.clouds[i].z) < 40.0f) { // not across the wrap
+			state.clouds[i] = glm::mix(previous.clouds[i], current.clouds[i], alpha);
+		}
+	}
+	if (previous.lamp1.to == current.lamp1.to) {
+		state.lamp1.transitionTime = glm::mix(previous.lamp1.transitionTime, current.lamp1.transitionTime, alpha);
+	}
+	if (previous.lamp2.to == current.lamp2.to) {
+		state.lamp2.transitionTime = glm::mix(previous.lamp2.transitionTime, current.lamp2.transitionTime, alpha);
+	}
+	return state;
+}
+
+glm::mat4 eggModelMatrix(const SimulationState& state)
+{
+	glm::mat4 model = glm::mat4(1.0f);
+	model = glm::scale(model, glm::vec3(1.0f, 1.5f, 1.0f));
+	model = glm::translate(model, glm::vec3(0.0f, 2.25f, 0.0f));
+
+	if (state.eggAnimating == true) { // handles animation
+		model = glm::translate(model, glm::vec3(0.0f, (sin(state.eggTime * 2.5) * 0.25f) + 0.01f, 0.0f));
+		float rotateDegree = (360.0 / 1.2571) * state.eggTime;
+		model = glm::rotate(model, glm::radians(rotateDegree), glm::vec3(0.0f, 1.0f, 0.0f));
+	}
+	return model;
+}
+
+LampPose evaluateLamp(glm::vec3 pos, glm::vec3 scale, float angle, glm::vec3 axis, LampState state)
+{
 	// scene graph implemented using nodes
 	Node bulb = {
 		"cube",
@@ -883,6 +1753,17 @@ void renderLamp(Shader lampShader, glm::vec3 pos, glm::vec3 scale, float angle,
 
 
 
+	LampPose pose;
+	pose.bones[LampBase] = base.model;
+	pose.bones[LampLowerarm] = lowerarm.model;
+	pose.bones[LampHinge] = hinge.model;
+	pose.bones[LampTail] = tail.model;
+	pose.bones[LampUpperarm] = upperarm.model;
+	pose.bones[LampHead] = head.model;
+	pose.bones[LampBulb] = bulb.model;
+	pose.bones[LampHorn] = horn.model;
+	pose.bones[LampHorn2] = horn2.model;
+
 	// handle lighting for bulb
 
 	// 0.5f, 2.75f, 0.5f, 1.0f (base) 
@@ -894,199 +1775,180 @@ void renderLamp(Shader lampShader, glm::vec3 pos, glm::vec3 scale, float angle,
 		bulbDir = glm::vec4(0.0f, 0.0f, -1.0f, 0.0f);
 	}
 
-	lampShader.setVec3("spotLights[" + std::to_string(lampNum - 1) + "].position", glm::vec3(bulbPos.x, bulbPos.y, bulbPos.z));
-	lampShader.setVec3("spotLights[" + std::to_string(lampNum - 1) + "].direction", bulbDir);
-	lampShader.setVec3("spotLights[" + std::to_string(lampNum - 1) + "].ambient", 0.1f, 0.1f, 0.1f);
-	lampShader.setVec3("spotLights[" + std::to_string(lampNum - 1) + "].diffuse", 1.0f, 1.0f, 1.0f);
-	lampShader.setVec3("spotLights[" + std::to_string(lampNum - 1) + "].specular", 1.0f, 1.0f, 1.0f);
-	lampShader.setFloat("spotLights[" + std::to_string(lampNum - 1) + "].constant", 1.0f);
-	lampShader.setFloat("spotLights[" + std::to_string(lampNum - 1) + "].linear", 0.09f);
-	lampShader.setFloat("spotLights[" + std::to_string(lampNum - 1) + "].quadratic", 0.032f);
-	lampShader.setFloat("spotLights[" + std::to_string(lampNum - 1) + "].cutOff", glm::cos(glm::radians(12.5f)));
-	lampShader.setFloat("spotLights[" + std::to_string(lampNum - 1) + "].outerCutOff", glm::cos(glm::radians(15.0f)));
-
-
-
-	// render tree from root node which is base
-	renderNode(lampShader, base);
+	pose.lightPosition = glm::vec3(bulbPos);
+	pose.lightDirection = glm::vec3(bulbDir);
+	return pose;
+}
 
+Skeleton lampSkeleton()
+{
+	Skeleton skeleton;
+	skeleton.parents.resize(LAMP_BONES);
+	skeleton.parents[LampBase] = -1;
+	skeleton.parents[LampLowerarm] = LampBase;
+	skeleton.parents[LampHinge] = LampLowerarm;
+	skeleton.parents[LampTail] = LampHinge;
+	skeleton.parents[LampUpperarm] = LampHinge;
+	skeleton.parents[LampHead] = LampUpperarm;
+	skeleton.parents[LampBulb] = LampHead;
+	skeleton.parents[LampHorn] = LampHead;
+	skeleton.parents[LampHorn2] = LampHead;
+	return skeleton;
 }
 
-void renderNode(Shader& shader, Node node)
+// one single key clip per LampState, taken from the node hierarchy in evaluateLamp()
+std::vector<AnimationClip> buildLampClips()
 {
-	shader.setMat4("model", node.model);
-	if (node.object == "cube") {
-		renderCube();
-	} else if (node.object == "sphere"){
-		renderSphere();
+	Skeleton skeleton = lampSkeleton();
+	std::vector<AnimationClip> clips;
+	for (int state = Default; state <= Other2; state++) {
+		// at the origin with unit scale the base holds only its own scale, placement is the rig root
+		LampPose pose = evaluateLamp(glm::vec3(0.0f), glm::vec3(1.0f), 0.0f, glm::vec3(1.0f, 0.0f, 0.0f), (LampState)state);
+		std::vector<JointTransform> locals(LAMP_BONES);
+		for (int j = 0; j < LAMP_BONES; j++) {
+			int parent = skeleton.parents[j];
+			glm::mat4 local = parent < 0 ? pose.bones[j] : glm::inverse(pose.bones[parent]) * pose.bones[j];
+			locals[j] = decomposeTransform(local);
+		}
+		clips.push_back(AnimationClip(locals, LAMP_BONES, 30.0f));
 	}
+	return clips;
+}
 
-	if (node.children.size() != 0) {
-		for (int i = 0; i < node.children.size(); i++) {
-			renderNode(shader, node.children[i]);
+// every pose to pose transition baked at 60Hz, the same blend the lamps use at runtime
+std::vector<AnimationClip> buildLampTransitionClips(const std::vector<AnimationClip>& poses)
+{
+	const float rate = 60.0f;
+	int frames = (int)(LAMP_TRANSITION_TIME * rate) + 1;
+	std::vector<AnimationClip> clips;
+	for (size_t from = 0; from < poses.size(); from++) {
+		for (size_t to = 0; to < poses.size(); to++) {
+			if (from == to)
+				continue;
+			std::vector<JointTransform> keys;
+			for (int f = 0; f < frames; f++) {
+				float weight = glm::smoothstep(0.0f, 1.0f, (float)f / (float)(frames - 1));
+				for (int j = 0; j < LAMP_BONES; j++) {
+					keys.push_back(blendJoint(poses[from].sampleJoint(j, 0.0f), poses[to].sampleJoint(j, 0.0f), weight));
+				}
+			}
+			clips.push_back(AnimationClip(keys, LAMP_BONES, rate));
 		}
 	}
-	
+	return clips;
 }
 
-
-void renderCube()
+void updateLampAnimation(LampAnimation& animation, LampState state, float dt)
 {
-	float cubeVertices[] = {
-		// vertex pos         // normal pos     // texture coords
-		// back face
-		-1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
-		 1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
-		 1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 0.0f, // bottom-right         
-		 1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
-		-1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
-		-1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 1.0f, // top-left
-		// front face
-		-1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
-		 1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 0.0f, // bottom-right
-		 1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
-		 1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
-		-1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 1.0f, // top-left
-		-1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
-		// left face
-		-1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
-		-1.0f,  1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-left
-		-1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
-		-1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
-		-1.0f, -1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-right
-		-1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
-		// right face
-		 1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
-		 1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
-		 1.0f,  1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-right         
-		 1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
-		 1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
-		 1.0f, -1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left     
-		// bottom face
-		-1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
-		 1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 1.0f, // top-left
-		 1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
-		 1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
-		-1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 0.0f, // bottom-right
-		-1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
-		// top face
-		-1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
-		 1.0f,  1.0f , 1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
-		 1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 1.0f, // top-right     
-		 1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
-		-1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
-		-1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 0.0f  // bottom-left        
-	};
-
-	unsigned int cubeVAO, cubeVBO;
-	glGenVertexArrays(1, &cubeVAO);
-	glGenBuffers(1, &cubeVBO);
-	glBindVertexArray(cubeVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), cubeVertices, GL_STATIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-	glBindVertexArray(0);
-
-	glBindVertexArray(cubeVAO);
-	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glBindVertexArray(0);
+	if (state != animation.to) {
+		animation.from = animation.to;
+		animation.to = state;
+		animation.transitionTime = 0.0f;
+	}
+	animation.transitionTime = glm::min(animation.transitionTime + dt, LAMP_TRANSITION_TIME);
 }
 
-void renderSphere() {
-
-	const  int XLONG = 30;
-	const int YLAT = 30;
+RigInstance lampRigInstance(const std::vector<AnimationClip>& clips, const LampAnimation& animation, glm::vec3 pos, float scale, float angle, glm::vec3 axis)
+{
+	RigInstance rig;
+	rig.clipA = &clips[animation.from];
+	rig.clipB = &clips[animation.to];
+	rig.blend = glm::smoothstep(0.0f, LAMP_TRANSITION_TIME, animation.transitionTime);
+	rig.root = glm::rotate(glm::mat4(1.0f), glm::radians(angle), axis);
+	rig.root = glm::translate(rig.root, pos);
+	rig.root = glm::scale(rig.root, glm::vec3(scale));
+	return rig;
+}
 
-	double r = 0.5;
-	const int step = 8;
+// lamp pose and spotlight from the animated bone matrices
+LampPose lampPoseFromBones(const glm::mat4* bones, const LampAnimation& animation)
+{
+	LampPose pose;
+	std::copy(bones, bones + LAMP_BONES, pose.bones);
 
-	float vertices[XLONG * YLAT * step];
+	glm::vec4 eggBasePos = glm::vec4(0.5f, 3.0f, 0.0f, 1.0f);
+	glm::vec4 bulbPos = bones[LampBulb] * glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+	glm::vec3 eggDir = glm::normalize(glm::vec3(eggBasePos - bulbPos));
+	glm::vec3 fromDir = animation.from == Other1 ? glm::vec3(0.0f, 0.0f, -1.0f) : eggDir;
+	glm::vec3 toDir = animation.to == Other1 ? glm::vec3(0.0f, 0.0f, -1.0f) : eggDir;
+
+	pose.lightPosition = glm::vec3(bulbPos);
+	pose.lightDirection = glm::mix(fromDir, toDir, glm::smoothstep(0.0f, LAMP_TRANSITION_TIME, animation.transitionTime));
+	return pose;
+}
 
-	for (int j = 0; j < YLAT; ++j) {
-		double b = glm::radians(-90 + 180 * (double)(j) / (YLAT - 1));
-		for (int i = 0; i < XLONG; ++i) {
-			double a = glm::radians(360 * (double)(i) / (XLONG - 1));
-			double z = glm::cos(b) * glm::cos(a);
-			double x = glm::cos(b) * glm::sin(a);
-			double y = glm::sin(b);
-			int base = j * XLONG * step;
-			vertices[base + i * step + 0] = (float)(r * x);
-			vertices[base + i * step + 1] = (float)(r * y);
-			vertices[base + i * step + 2] = (float)(r * z);
+void setLampLight(Shader& lampShader, const LampPose& pose, int lampNum)
+{
+	lampShader.setVec3(frameArena().format("spotLights[%d].position", lampNum - 1), pose.lightPosition);
+	lampShader.setVec3(frameArena().format("spotLights[%d].direction", lampNum - 1), pose.lightDirection);
+	lampShader.setVec3(frameArena().format("spotLights[%d].ambient", lampNum - 1), 0.1f, 0.1f, 0.1f);
+	lampShader.setVec3(frameArena().format("spotLights[%d].diffuse", lampNum - 1), 1.0f, 1.0f, 1.0f);
+	lampShader.setVec3(frameArena().format("spotLights[%d].specular", lampNum - 1), 1.0f, 1.0f, 1.0f);
+	lampShader.setFloat(frameArena().format("spotLights[%d].constant", lampNum - 1), 1.0f);
+	lampShader.setFloat(frameArena().format("spotLights[%d].linear", lampNum - 1), 0.09f);
+	lampShader.setFloat(frameArena().format("spotLights[%d].quadratic", lampNum - 1), 0.032f);
+	lampShader.setFloat(frameArena().format("spotLights[%d].cutOff", lampNum - 1), glm::cos(glm::radians(12.5f)));
+	lampShader.setFloat(frameArena().format("spotLights[%d].outerCutOff", lampNum - 1), glm::cos(glm::radians(15.0f)));
+}
 
-			vertices[base + i * step + 3] = (float)x;
-			vertices[base + i * step + 4] = (float)y;
-			vertices[base + i * step + 5] = (float)z;
+// draws the lamp one part at a time, the skinned path in main() draws all lamps at once instead.
+// Without spheres only the cubes are drawn, the spheres go out as impostors.
+void renderLamp(int lampNum, int lod, bool spheres)
+{
+	PROFILE_ZONE("renderLamp");
+	static const bool boneIsSphere[LAMP_BONES] = { false, false, true, true, false, false, false, true, true };
 
-			vertices[base + i * step + 6] = (float)(i) / (float)(XLONG - 1);
-			vertices[base + i * step + 7] = (float)(j) / (float)(YLAT - 1);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, lampTexture);
+	countStateChange();
+
+	for (int i = 0; i < LAMP_BONES; i++) {
+		if (boneIsSphere[i] && !spheres)
+			continue;
+		bindDraw(DrawLampParts + (lampNum - 1) * LAMP_BONES + i);
+		if (boneIsSphere[i]) {
+			renderSphere(lod);
+		} else {
+			renderCube();
 		}
 	}
+}
 
-	int indices[(XLONG - 1) * (YLAT - 1) * 6];
-	for (int j = 0; j < YLAT - 1; ++j) {
-		for (int i = 0; i < XLONG - 1; ++i) {
-			int base = j * (XLONG - 1) * 6;
-			indices[base + i * 6 + 0] = j * XLONG + i;
-			indices[base + i * 6 + 1] = j * XLONG + i + 1;
-			indices[base + i * 6 + 2] = (j + 1) * XLONG + i + 1;
-			indices[base + i * 6 + 3] = j * XLONG + i;
-			indices[base + i * 6 + 4] = (j + 1) * XLONG + i + 1;
-			indices[base + i * 6 + 5] = (j + 1) * XLONG + i;
-		}
-	}
-	
-	unsigned int sphereVAO, sphereVBO;
-	glGenVertexArrays(1, &sphereVAO);
-	glGenBuffers(1, &sphereVBO);
-	glBindVertexArray(sphereVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, sphereVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-	unsigned int sphereEBO;
-	glGenBuffers(1, &sphereEBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphereEBO);   
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-	glBindBuffer(GL_ARRAY_BUFFER, sphereVBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphereEBO);
-
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-	glBindVertexArray(0);
 
-	glBindVertexArray(sphereVAO);
-	glDrawElements(GL_TRIANGLES, sizeof(indices), GL_UNSIGNED_INT, (void*)0);
-	glBindVertexArray(0);
+void renderCube()
+{
+	cubeMesh->mesh.draw();
+}
 
+void renderSphere(int lod) {
+	const MeshLod& level = sphereMesh->chain.lods[lod];
+	sphereMesh->mesh.drawRange(level.firstIndex, level.indexCount);
 }
 
 
 void processInput(GLFWwindow* window)
 {
+	PROFILE_ZONE("processInput");
+	for (const InputEvent& event : frameInput.events) {
+		if (event.type == InputMouseMove)
+			mouseMoved(event.x, event.y);
+		else
+			camera.ProcessMouseScroll(static_cast<float>(event.y));
+	}
 
-	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+	if (frameInput.keyDown(GLFW_KEY_ESCAPE))
 		glfwSetWindowShouldClose(window, true);
-	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+	if (frameInput.keyDown(GLFW_KEY_W))
 		camera.ProcessKeyboard(FORWARD, deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+	if (frameInput.keyDown(GLFW_KEY_S))
 		camera.ProcessKeyboard(BACKWARD, deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+	if (frameInput.keyDown(GLFW_KEY_A))
 		camera.ProcessKeyboard(LEFT, deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+	if (frameInput.keyDown(GLFW_KEY_D))
 		camera.ProcessKeyboard(RIGHT, deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS) // change lamp 1 positions
+	if (frameInput.keyDown(GLFW_KEY_E)) // change lamp 1 positions
 		lamp2Key = true;
-	if (glfwGetKey(window, GLFW_KEY_E) == GLFW_RELEASE)
+	if (!frameInput.keyDown(GLFW_KEY_E))
 		if (lamp2Key == true) {
 			if (currentLamp2State == Default) {
 				currentLamp2State = Crouched1;
@@ -1099,9 +1961,9 @@ void processInput(GLFWwindow* window)
 			}
 			lamp2Key = false;
 		}
-	if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS) // change lamp 2 positions
+	if (frameInput.keyDown(GLFW_KEY_R)) // change lamp 2 positions
 		lamp1Key = true;
-	if (glfwGetKey(window, GLFW_KEY_R) == GLFW_RELEASE)
+	if (!frameInput.keyDown(GLFW_KEY_R))
 		if (lamp1Key == true) {
 			if (currentLamp1State == Default) {
 				currentLamp1State = Other1;
@@ -1114,9 +1976,9 @@ void processInput(GLFWwindow* window)
 			}
 			lamp1Key = false;
 		}
-	if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
+	if (frameInput.keyDown(GLFW_KEY_Q))
 		dirLightKey = true;
-	if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_RELEASE)
+	if (!frameInput.keyDown(GLFW_KEY_Q))
 		if (dirLightKey == true) {
 			if (dirLightOn == true) {
 				dirLightOn = false;
@@ -1126,9 +1988,9 @@ void processInput(GLFWwindow* window)
 			}
 			dirLightKey = false;
 		}
-	if (glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS) //lamp 1 on/off
+	if (frameInput.keyDown(GLFW_KEY_T)) //lamp 1 on/off
 		lamp1OnKey = true;
-	if (glfwGetKey(window, GLFW_KEY_T) == GLFW_RELEASE)
+	if (!frameInput.keyDown(GLFW_KEY_T))
 		if (lamp1OnKey == true) {
 			if (lamp1On == true) {
 				lamp1On = false;
@@ -1138,9 +2000,9 @@ void processInput(GLFWwindow* window)
 			}
 			lamp1OnKey = false;
 		}
-	if (glfwGetKey(window, GLFW_KEY_Y) == GLFW_PRESS) //lamp 2 on/off
+	if (frameInput.keyDown(GLFW_KEY_Y)) //lamp 2 on/off
 		lamp2OnKey = true;
-	if (glfwGetKey(window, GLFW_KEY_Y) == GLFW_RELEASE)
+	if (!frameInput.keyDown(GLFW_KEY_Y))
 		if (lamp2OnKey == true) {
 			if (lamp2On == true) {
 				lamp2On = false;
@@ -1150,12 +2012,335 @@ void processInput(GLFWwindow* window)
 			}
 			lamp2OnKey = false;
 		}
+	if (keyToggled(GLFW_KEY_G, skinnedLampsKey)) // skinned/per part lamps
+		skinnedLamps = !skinnedLamps;
+	if (keyToggled(GLFW_KEY_I, sphereImpostorsKey)) // sphere impostors/meshes
+		sphereImpostors = !sphereImpostors;
+	if (keyToggled(GLFW_KEY_P, pauseKey)) // pause simulation
+		simulationTimer.paused = !simulationTimer.paused;
+	if (keyToggled(GLFW_KEY_MINUS, slowerKey)) // half speed simulation
+		simulationTimer.timeScale = glm::max(simulationTimer.timeScale * 0.5, 0.125);
+	if (keyToggled(GLFW_KEY_EQUAL, fasterKey)) // double speed simulation
+		simulationTimer.timeScale = glm::min(simulationTimer.timeScale * 2.0, 8.0);
+	if (keyToggled(GLFW_KEY_F9, profileKey)) // write a chrome trace of the last frames
+		PROFILE_REQUEST_DUMP();
+	if (keyToggled(GLFW_KEY_F8, reportKey)) // print pass timings once a second
+		reportPrinting = !reportPrinting;
+	if (keyToggled(GLFW_KEY_H, hudKey)) // performance overlay
+		hudVisible = !hudVisible;
+
+
+
+}
+
+// true once when a key is let go after being pressed, keyDown remembers the press
+bool keyToggled(int key, bool& keyDown)
+{
+	if (frameInput.keyDown(key)) {
+		keyDown = true;
+		return false;
+	}
+	if (keyDown) {
+		keyDown = false;
+		return true;
+	}
+	return false;
+}
+
+// cpu cost of the per frame and loading paths, no window or gpu needed
+bool runHotPathBenchmarks(const std::string& out, const std::string& filter)
+{
+	useStubGL();
+	MicroBenchmarkSuite suite;
+
+	suite.add("sphere generation 30x30", []() {
+		MeshData sphere = makeUVSphere(30, 30);
+		benchmarkKeep(sphere.vertices[0]);
+	});
+
+	MeshData lodSource = makeUVSphere(30, 30);
+	suite.add("sphere lod chain 30x30", [&lodSource]() {
+		MeshLodChain chain = buildLodChain(lodSource);
+		benchmarkKeep(chain.lods[chain.lodCount - 1].indexCount);
+	});
+
+	suite.add("icosphere lod chain 4 levels", []() {
+		MeshLodChain chain = icosphereLodChain(4, 4);
+		benchmarkKeep(chain.lods[chain.lodCount - 1].indexCount);
+	});
+
+	MeshLodChain optimiseSource = buildLodChain(lodSource);
+	suite.add("sphere optimise 30x30", [&optimiseSource]() {
+		MeshData mesh = optimiseSource.mesh;
+		MeshOptimizeReport report = optimizeMesh(mesh.vertices, MESH_VERTEX_FLOATS, mesh.indices, optimiseSource.lods, optimiseSource.lodCount);
+		benchmarkKeep(report.after.transformed);
+	});
+
+	MeshData denseSphere = makeUVSphere(200, 200);
+	std::vector<Meshlet> denseMeshlets = buildMeshlets(denseSphere.vertices.data(), MESH_VERTEX_FLOATS, denseSphere.vertexCount(), denseSphere.indices.data(),
+		0, (uint32_t)denseSphere.indices.size());
+	MeshletSet denseSet(denseMeshlets.data(), denseMeshlets.size());
+	Frustum denseFrustum(glm::perspective(glm::radians(45.0f), (float)WIDTH / (float)HEIGHT, 0.1f, 50.0f)
+		* glm::lookAt(glm::vec3(0.0f, 0.0f, 2.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+	suite.add("meshlet cull 200x200 sphere", [&denseSet, &denseFrustum]() {
+		benchmarkKeep(denseSet.cull(denseFrustum, glm::vec3(0.0f, 0.0f, 2.0f)));
+	});
+
+	Node leaves[3] = { { "cube", glm::mat4(1.0f), {} }, { "sphere", glm::mat4(1.0f), {} }, { "sphere", glm::mat4(1.0f), {} } };
+	Node head = { "cube", glm::mat4(1.0f), { leaves[0], leaves[1], leaves[2] } };
+	Node upperarm = { "cube", glm::mat4(1.0f), { head } };
+	Node tail = { "sphere", glm::mat4(1.0f), {} };
+	Node hinge = { "sphere", glm::mat4(1.0f), { tail, upperarm } };
+	Node lowerarm = { "cube", glm::mat4(1.0f), { hinge } };
+	Node base = { "cube", glm::mat4(1.0f), { lowerarm } };
+	suite.add("node update 9 nodes", [&]() {
+		base.updateRotate(0.001f, glm::vec3(0.0f, 1.0f, 0.0f));
+		benchmarkKeep(leaves[2].model);
+	});
+
+	suite.add("lamp pose nodes", []() {
+		frameArena().reset();
+		LampPose pose = evaluateLamp(glm::vec3(-5.0f, 0.0f, 0.0f), glm::vec3(1.0f), 0.0f, glm::vec3(1.0f, 0.0f, 0.0f), Crouched1);
+		benchmarkKeep(pose);
+	});
+
+	std::vector<AnimationClip> clips = buildLampClips();
+	AnimationEvaluator evaluator(lampSkeleton(), 1);
+	LampAnimation animation = { Default, Crouched1, 0.25f };
+	suite.add("lamp pose clips 2 lamps", [&]() {
+		RigInstance rigs[2] = {
+			lampRigInstance(clips, animation, glm::vec3(-5.0f, 0.0f, 0.0f), 1.0f, 0.0f, glm::vec3(1.0f, 0.0f, 0.0f)),
+			lampRigInstance(clips, animation, glm::vec3(-4.0f, 0.0f, 0.0f), 0.75f, 180.0f, glm::vec3(0.0f, 1.0f, 0.0f)),
+		};
+		glm::mat4 bones[2 * LAMP_BONES];
+		evaluator.evaluate(rigs, 2, bones);
+		benchmarkKeep(bones);
+	});
+
+	Shader shader("Shaders/room.vert", "Shaders/room.frag");
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)WIDTH / (float)HEIGHT, 0.1f, 50.0f);
+	LampPose pose = evaluateLamp(glm::vec3(-5.0f, 0.0f, 0.0f), glm::vec3(1.0f), 0.0f, glm::vec3(1.0f, 0.0f, 0.0f), Default);
+	RenderSnapshot snapshot = {};
+	snapshot.frame.projection = projection;
+	snapshot.frame.view = camera.GetViewMatrix();
+	snapshot.viewPos = camera.Position;
+	snapshot.dirLightOn = snapshot.lamp1On = snapshot.lamp2On = true;
+	suite.add("shader frame uniforms", [&]() {
+		frameArena().reset();
+		setLightingUniforms(shader, snapshot);
+		setLampLight(shader, pose, 1);
+		setLampLight(shader, pose, 2);
+	});
+	suite.add("shader setMat4", [&]() {
+		shader.setMat4("model", projection);
+	});
+	FrameData frame = {}; // the draw table that replaced the per draw uniforms
+	suite.add("room draw table", [&]() {
+		buildRoomDraws(frame);
+		benchmarkKeep(frame.draws);
+	});
+
+	suite.add("camera updateCameraVectors", []() {
+		camera.Yaw += 0.01f;
+		camera.updateCameraVectors();
+		benchmarkKeep(camera.Front);
+	});
+
+	// decode only, the file is read once up front
+	const char* images[] = {
+		"Resources/Textures/Wood Floor_007_SD/Wood_Floor_007_COLOR.jpg",
+		"Resources/Textures/Wood Floor_007_SD/Wood_Floor_007_DISP.png",
+	};
+	std::vector<std::vector<unsigned char>> files;
+	for (const char* image : images) {
+		std::ifstream file(image, std::ios::binary);
+		if (!file) {
+			std::cout << "ERROR::MICROBENCH::TEXTURE_NOT_FOUND: " << image << std::endl;
+			return false;
+		}
+		files.emplace_back((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	}
+	suite.add("texture decode jpg", [&]() {
+		int width, height, components;
+		unsigned char* data = stbi_load_from_memory(files[0].data(), (int)files[0].size(), &width, &height, &components, 0);
+		benchmarkKeep(data);
+		stbi_image_free(data);
+	});
+	suite.add("texture decode png", [&]() {
+		int width, height, components;
+		unsigned char* data = stbi_load_from_memory(files[1].data(), (int)files[1].size(), &width, &height, &components, 0);
+		benchmarkKeep(data);
+		stbi_image_free(data);
+	});
+
+	std::vector<MicroBenchmarkResult> results = suite.run(filter);
+	return writeMicroBenchmarkJson(out, results);
+}
+
+// --bench-spheres: count egg textured spheres and ellipsoids in a grid filling the screen,
+// drawn into an offscreen target as instanced meshes at every level of detail, then as
+// impostors. Prints the median gpu time of each and how many pixels the impostors change
+// against the finest mesh.
+bool runSphereBenchmark(Shader& meshShader, Shader& impostorShader, int count)
+{
+	const int warmupFrames = 5;
+	const int timedFrames = 31;
+	int side = (int)std::ceil(std::sqrt((double)count));
+	std::vector<glm::mat4> models;
+	models.reserve(count);
+	for (int i = 0; i < count; i++) {
+		glm::vec3 position((float)(i % side) - (side - 1) * 0.5f, (float)(i / side) - (side - 1) * 0.5f, 0.0f);
+		glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+		model = glm::rotate(model, 0.7f * i, glm::normalize(glm::vec3(1.0f, 2.0f, 3.0f)));
+		models.push_back(glm::scale(model, glm::vec3(0.8f, 0.8f + 0.2f * (i % 3), 0.8f))); // spheres and eggs
+	}
+
+	RenderSnapshot snapshot = {};
+	float distance = side * 1.25f; // the whole grid in the 45 degree field of view
+	snapshot.viewPos = glm::vec3(0.0f, 0.0f, distance);
+	snapshot.frame.view = glm::lookAt(snapshot.viewPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	snapshot.frame.projection = glm::perspective(glm::radians(45.0f), (float)WIDTH / (float)HEIGHT, 0.1f, distance + 2.0f);
+	snapshot.dirLightOn = true;
+	setDraw(snapshot.frame.draws[DrawEgg], glm::mat4(1.0f), 16.0f);
+	writeDraws(snapshot.frame.draws, 0);
+	bindDraw(DrawEgg);
+	for (Shader* shader : { &meshShader, &impostorShader }) {
+		shader->use();
+		setLightingUniforms(*shader, snapshot);
+	}
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, eggTexture);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, eggSpec);
+	glActiveTexture(GL_TEXTURE0);
 
+	// offscreen, a hidden window's own framebuffer may not be rendered at all
+	unsigned int framebuffer, colour, depth;
+	glGenFramebuffers(1, &framebuffer);
+	glGenRenderbuffers(1, &colour);
+	glGenRenderbuffers(1, &depth);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, colour);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, WIDTH, HEIGHT);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colour);
+	glBindRenderbuffer(GL_RENDERBUFFER, depth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, WIDTH, HEIGHT);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		std::cout << "ERROR::SPHERE_BENCHMARK::FRAMEBUFFER_INCOMPLETE" << std::endl;
+		return false;
+	}
+	glViewport(0, 0, WIDTH, HEIGHT);
+
+	unsigned int query;
+	glGenQueries(1, &query);
+	std::vector<unsigned char> pixels((size_t)WIDTH * HEIGHT * 4);
+	std::vector<unsigned char> reference;
+	// median gpu time of a frame drawn by draw, the last frame is left in pixels
+	auto timeFrames = [&](const std::function<void()>& draw) {
+		std::vector<double> times;
+		for (int frame = 0; frame < warmupFrames + timedFrames; frame++) {
+			glClearColor(0.53f, 0.81f, 0.92f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			glBeginQuery(GL_TIME_ELAPSED, query);
+			draw();
+			glEndQuery(GL_TIME_ELAPSED);
+			GLuint64 nanoseconds = 0;
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds); // waits, nothing else is running
+			if (frame >= warmupFrames)
+				times.push_back(nanoseconds / 1.0e6);
+		}
+		glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		std::sort(times.begin(), times.end());
+		return times[times.size() / 2];
+	};
 
+	std::cout << count << " spheres at " << WIDTH << "x" << HEIGHT << ", median gpu time of " << timedFrames << " frames" << std::endl;
+	for (int lod = 0; lod < sphereMesh->chain.lodCount; lod++) {
+		MeshData level = sphereMesh->chain.level(lod);
+		SkinnedRig rig(std::vector<SkinnedPart>{ { &level, 0 } }, 1); // one bone, every sphere an instance
+		double milliseconds = timeFrames([&]() {
+			for (const glm::mat4& model : models)
+				rig.addInstance(&model);
+			rig.draw(meshShader);
+		});
+		std::cout << "  mesh level " << lod << " (" << level.indices.size() / 3 << " triangles): " << milliseconds << " ms" << std::endl;
+		if (lod == 0)
+			reference = pixels;
+	}
+	EllipsoidImpostors impostors(models.size());
+	double milliseconds = timeFrames([&]() {
+		for (const glm::mat4& model : models)
+			impostors.add(model);
+		impostors.draw(impostorShader);
+	});
+	size_t differing = 0;
+	for (size_t i = 0; i < pixels.size(); i += 4) {
+		for (int c = 0; c < 3; c++) {
+			if (std::abs((int)pixels[i + c] - (int)reference[i + c]) > 8) {
+				differing++;
+				break;
+			}
+		}
+	}
+	std::cout << "  impostors (2 triangles): " << milliseconds << " ms, " << 100.0 * differing / ((double)WIDTH * HEIGHT)
+		<< "% of pixels differ from level 0 by more than 8/255" << std::endl;
+
+	glDeleteQueries(1, &query);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteRenderbuffers(1, &colour);
+	glDeleteRenderbuffers(1, &depth);
+	return true;
+}
 
+// does what the matching key would, but to an exact state rather than the next one
+void applyScenarioEvent(const ScenarioEvent& event)
+{
+	const char* stateNames[] = { "Default", "Crouched1", "Crouched2", "Other1", "Other2" };
+	bool on = event.value == "on";
+	if (event.action == "lamp1" || event.action == "lamp2") {
+		for (int i = 0; i < 5; i++) {
+			if (event.value == stateNames[i]) {
+				(event.action == "lamp1" ? currentLamp1State : currentLamp2State) = (LampState)i;
+				return;
+			}
+		}
+	}
+	else if (event.action == "lamp1light" && (on || event.value == "off")) {
+		lamp1On = on;
+		return;
+	}
+	else if (event.action == "lamp2light" && (on || event.value == "off")) {
+		lamp2On = on;
+		return;
+	}
+	else if (event.action == "dirlight" && (on || event.value == "off")) {
+		dirLightOn = on;
+		return;
+	}
+	else if (event.action == "egg" && event.value == "jump") {
+		if (!simulation.eggAnimating)
+			simulation.nextJump = 0.0f;
+		return;
+	}
+	std::cout << "ERROR::SCENARIO::UNKNOWN_EVENT: " << event.action << " " << event.value << std::endl;
 }
 
+// glfw events are queued on the frame so they can be recorded, processInput applies them
 void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
+{
+	if (!replayingInput)
+		frameInput.events.push_back({ InputMouseMove, xposIn, yposIn });
+}
+
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+{
+	if (!replayingInput)
+		frameInput.events.push_back({ InputScroll, xoffset, yoffset });
+}
+
+void mouseMoved(double xposIn, double yposIn)
 {
 	float xpos = static_cast<float>(xposIn);
 	float ypos = static_cast<float>(yposIn);
@@ -1177,23 +2362,32 @@ void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
 }
 
 
-void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
-{
-	camera.ProcessMouseScroll(static_cast<float>(yoffset));
-}
-
 void framebuffer_resize(GLFWwindow* window, int width, int height)
 {
 	glViewport(0, 0, width, height);
 }
 
 unsigned int loadTexture(char const* path)
+{
+	int width, height, nrComponents;
+	unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
+	return textureFromPixels(data, width, height, nrComponents, path);
+}
+
+// an encoded image already in memory, such as one inside a .glb, name is only for errors
+unsigned int loadTextureFromMemory(const unsigned char* bytes, size_t size, const char* name)
+{
+	int width, height, nrComponents;
+	unsigned char* data = stbi_load_from_memory(bytes, (int)size, &width, &height, &nrComponents, 0);
+	return textureFromPixels(data, width, height, nrComponents, name);
+}
+
+// uploads decoded pixels with mipmaps and frees them
+unsigned int textureFromPixels(unsigned char* data, int width, int height, int nrComponents, const char* path)
 {
 	unsigned int ID;
 	glGenTextures(1, &ID);
 
-	int width, height, nrComponents;
-	unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
 	if (data)
 	{
 		GLenum type;
@@ -1206,6 +2400,8 @@ unsigned int loadTexture(char const* path)
 
 		glBindTexture(GL_TEXTURE_2D, ID);
 		glTexImage2D(GL_TEXTURE_2D, 0, type, width, height, 0, type, GL_UNSIGNED_BYTE, data);
+		countUpload((int64_t)width * height * nrComponents);
+		countTextureMemory((int64_t)width * height * nrComponents * 4 / 3); // mipmaps add a third
 		glGenerateMipmap(GL_TEXTURE_2D);
 
 
@@ -1246,6 +2442,8 @@ unsigned int loadSkybox(std::vector<std::string> faces)
 		if (data)
 		{
 			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
+			countUpload((int64_t)width * height * 3);
+			countTextureMemory((int64_t)width * height * 3);
 			stbi_image_free(data);
 		}
 		else
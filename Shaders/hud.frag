@@ -0,0 +1,12 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+in vec4 Color;
+
+uniform sampler2D atlas;
+
+void main()
+{
+	FragColor = vec4(Color.rgb, Color.a * texture(atlas, TexCoords).r);
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 ObjectPos;
+flat in vec3 ObjectCamera;
+flat in mat4 Model;
+flat in mat3 NormalModel;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+// what room.vert would have passed for the sphere mesh, worked out from the hit
+vec3 FragPos;
+vec3 Normal;
+vec2 TexCoords;
+// derivatives of TexCoords without the jump at the seam
+vec2 TexCoordsDx;
+vec2 TexCoordsDy;
+#define MaterialTexture(map) textureGrad(map, TexCoords, TexCoordsDx, TexCoordsDy)
+
+#include "lighting.glsl"
+
+const float PI = 3.14159265;
+
+void main()
+{
+    // the ray through this pixel against the radius 0.5 sphere, in the ellipsoid's space
+    vec3 direction = ObjectPos - ObjectCamera;
+    float a = dot(direction, direction);
+    float b = dot(ObjectCamera, direction);
+    float c = dot(ObjectCamera, ObjectCamera) - 0.25;
+    float discriminant = b * b - a * c;
+    // a miss takes the edge and is discarded at the end, so its neighbours' derivatives hold
+    float t = (-b - sqrt(max(discriminant, 0.0))) / a;
+    vec3 hit = ObjectCamera + direction * t;
+    vec3 unit = hit * 2.0;
+
+    FragPos = vec3(Model * vec4(hit, 1.0));
+    Normal = NormalModel * unit;
+
+    // makeUVSphere's coords. The derivatives of u come from 0..1 or -0.5..0.5, whichever
+    // doesn't jump between this pixel and the next, so the seam doesn't sample the smallest
+    // mip. The coords themselves stay in 0..1, textures with alpha don't repeat.
+    float u = atan(unit.x, unit.z) / (2.0 * PI);
+    float wrapped = fract(u);
+    float centred = fract(u + 0.5) - 0.5;
+    TexCoords = vec2(wrapped, asin(clamp(unit.y, -1.0, 1.0)) / PI + 0.5);
+    TexCoordsDx = dFdx(TexCoords);
+    TexCoordsDy = dFdy(TexCoords);
+    if (abs(dFdx(centred)) < abs(TexCoordsDx.x))
+        TexCoordsDx.x = dFdx(centred);
+    if (abs(dFdy(centred)) < abs(TexCoordsDy.x))
+        TexCoordsDy.x = dFdy(centred);
+
+    vec4 clip = projection * view * vec4(FragPos, 1.0);
+    gl_FragDepth = (clip.z / clip.w) * 0.5 * gl_DepthRange.diff + (gl_DepthRange.near + gl_DepthRange.far) * 0.5;
+
+    vec4 texColor = MaterialTexture(material.diffuse);
+    FragColor = LitColor(normalize(Normal), FragPos, texColor);
+    if (discriminant < 0.0 || t < 0.0 || clip.z < -clip.w || texColor.a < 0.08)
+        discard;
+}
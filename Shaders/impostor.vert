@@ -0,0 +1,48 @@
+#version 330 core
+// No vertex attributes: gl_VertexID is the corner of the quad, gl_InstanceID the ellipsoid.
+// Each ellipsoid is the radius 0.5 sphere the meshes use, placed by its model matrix.
+
+out vec3 ObjectPos; // this corner in the ellipsoid's own space
+flat out vec3 ObjectCamera;
+flat out mat4 Model;
+flat out mat3 NormalModel;
+
+uniform samplerBuffer impostorModels; // model matrix of every ellipsoid, 4 texels each
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 viewPos;
+
+void main()
+{
+    int texel = gl_InstanceID * 4;
+    Model = mat4(texelFetch(impostorModels, texel),
+                 texelFetch(impostorModels, texel + 1),
+                 texelFetch(impostorModels, texel + 2),
+                 texelFetch(impostorModels, texel + 3));
+    mat4 inverseModel = inverse(Model);
+    NormalModel = transpose(mat3(inverseModel));
+    ObjectCamera = vec3(inverseModel * vec4(viewPos, 1.0));
+
+    // the sphere round the ellipsoid
+    vec3 center = vec3(Model[3]);
+    float radius = 0.5 * max(length(vec3(Model[0])), max(length(vec3(Model[1])), length(vec3(Model[2]))));
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0; // strip order
+    vec3 toCenter = center - viewPos;
+    float distance = length(toCenter);
+    vec4 world;
+    if (distance > radius * 1.01) {
+        // square to the line of sight through the centre, as wide as the cone from the eye
+        // that just holds the sphere is there
+        vec3 forward = toCenter / distance;
+        vec3 right = normalize(cross(forward, abs(forward.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0)));
+        vec3 up = cross(right, forward);
+        float halfSize = radius * distance / sqrt(distance * distance - radius * radius);
+        world = vec4(center + (right * corner.x + up * corner.y) * halfSize, 1.0);
+    } else {
+        // the camera is inside the sphere, cover the screen on the near plane
+        world = inverse(projection * view) * vec4(corner, -1.0, 1.0);
+        world /= world.w;
+    }
+    ObjectPos = vec3(inverseModel * world);
+    gl_Position = projection * view * world;
+}
@@ -0,0 +1,139 @@
+// Lighting of every lit fragment shader, included by room.frag and impostor.frag. The
+// includer declares TexCoords, the material's texture coords, before including this, and
+// may define MaterialTexture to sample the material maps some other way.
+
+#ifndef MaterialTexture
+#define MaterialTexture(map) texture(map, TexCoords)
+#endif
+
+struct Material{
+    sampler2D diffuse;
+    sampler2D specular;
+};
+
+struct DirLight {
+    vec3  direction;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular; 
+};
+
+struct SpotLight {
+    vec3 position;
+    vec3 direction;
+    float cutOff;
+    float outerCutOff;
+
+    float constant;
+    float linear;
+    float quadratic;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+#define NUM_SPOT_LIGHT 2
+#define NUM_DIR_LIGHT 2
+
+uniform sampler2D texture_diffuse1;
+uniform vec3 viewPos;
+uniform DirLight dirLights[NUM_DIR_LIGHT];
+uniform SpotLight spotLights[NUM_SPOT_LIGHT];
+uniform Material material;
+layout (std140) uniform Draw // shininess comes with the model matrix, per draw
+{
+    mat4 model;
+    mat4 normalModel;
+    float shininess;
+} draw;
+
+uniform bool dirLightOn; 
+uniform bool lightingOn;
+
+uniform bool lamp1On;
+uniform bool lamp2On;
+
+vec3 DirLightValue(DirLight light, vec3 normal, vec3 viewDir);
+vec3 SpotLightValue(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+vec3 ExtraAmbient(SpotLight light);
+
+// colour of a fragment at fragPos facing norm (normalized) with the texel texColor
+vec4 LitColor(vec3 norm, vec3 fragPos, vec4 texColor)
+{
+    vec3 viewDir = normalize(viewPos - fragPos);
+    vec3 result = vec3(0.0);
+
+    if(lightingOn){ // used for rendering without lighting
+        if (dirLightOn){ // handles directional light being on and off. 
+            for(int i = 0; i < NUM_DIR_LIGHT; i++)
+                result += DirLightValue(dirLights[i], norm, viewDir);
+        } else {
+            result += ExtraAmbient(spotLights[1]);
+        }
+
+        if (lamp1On == true){
+            result += SpotLightValue(spotLights[0], norm, fragPos, viewDir);
+        }
+        if (lamp2On == true){
+            result += SpotLightValue(spotLights[1], norm, fragPos, viewDir);
+        }
+        
+        return vec4(result, 1.0);
+    } else {
+        if (!dirLightOn){ // Use Spotlights when directional lights off. 
+            return vec4(0.6 * texColor.rgb, texColor.a);
+        } else {
+            return texColor;
+        }
+    }
+}
+
+vec3 DirLightValue(DirLight light, vec3 normal, vec3 viewDir)
+{
+    vec3 lightDir = normalize(-light.direction);
+    float diffuseFloat = max(dot(normal, lightDir), 0.0);
+
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), draw.shininess);
+
+    vec3 ambient = light.ambient * vec3(MaterialTexture(material.diffuse));
+    vec3 diffuse = light.diffuse * diffuseFloat * vec3(MaterialTexture(material.diffuse));
+    vec3 specular = light.specular * spec * vec3(MaterialTexture(material.specular));
+
+    return (ambient + diffuse + specular);
+}
+
+vec3 SpotLightValue(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    vec3 lightDir = normalize(light.position - fragPos);
+
+    float diffuseFloat = max(dot(normal, lightDir), 0.0);
+
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), draw.shininess);
+
+    float distance = length(light.position - fragPos);
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+
+    // intensity
+    float theta = dot(lightDir, normalize(-light.direction));
+    float epsilon = light.cutOff - light.outerCutOff;
+    float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
+
+    vec3 ambient = light.ambient * vec3(MaterialTexture(material.diffuse));
+    vec3 diffuse = light.diffuse * diffuseFloat * vec3(MaterialTexture(material.diffuse));
+    vec3 specular = light.specular * spec * vec3(MaterialTexture(material.specular));
+    
+    ambient *= attenuation * intensity;
+    diffuse *= attenuation * intensity;
+    specular *= attenuation * intensity;
+
+    return(ambient + diffuse + specular);
+}
+
+vec3 ExtraAmbient(SpotLight light){
+    return (light.ambient * vec3(MaterialTexture(material.diffuse)));
+}
+
@@ -7,14 +7,19 @@ out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
 
-uniform mat4 model;
+layout (std140) uniform Draw // this draw's slice of the stream buffer
+{
+    mat4 model;
+    mat4 normalModel;
+    float shininess;
+} draw;
 uniform mat4 view;
 uniform mat4 projection;
 
 void main()
 {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;  
+    FragPos = vec3(draw.model * vec4(aPos, 1.0));
+    Normal = mat3(draw.normalModel) * aNormal;
     TexCoords = aTexCoords;
     
     gl_Position = projection * view * vec4(FragPos, 1.0);
@@ -0,0 +1,33 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in float aBone;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+
+uniform samplerBuffer bonePalette; // bonesPerRig world matrices per instance, 4 texels each
+uniform int bonesPerRig;
+uniform mat4 view;
+uniform mat4 projection;
+
+mat4 boneMatrix(int bone)
+{
+    int texel = (gl_InstanceID * bonesPerRig + bone) * 4;
+    return mat4(texelFetch(bonePalette, texel),
+                texelFetch(bonePalette, texel + 1),
+                texelFetch(bonePalette, texel + 2),
+                texelFetch(bonePalette, texel + 3));
+}
+
+void main()
+{
+    mat4 model = boneMatrix(int(aBone + 0.5));
+    FragPos = vec3(model * vec4(aPos, 1.0));
+    Normal = mat3(transpose(inverse(model))) * aNormal;
+    TexCoords = aTexCoords;
+
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
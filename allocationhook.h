@@ -0,0 +1,102 @@
+#ifndef ALLOCATIONHOOK_H
+#define ALLOCATIONHOOK_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+// Replaces the global operator new so heap allocations can be counted per thread.
+// Define HATCH_ALLOCATION_HOOK=0 to keep the standard one. The replacement is defined
+// here rather than inline, so only one translation unit (Hatch.cpp) may include this.
+#ifndef HATCH_ALLOCATION_HOOK
+#define HATCH_ALLOCATION_HOOK 1
+#endif
+
+// operator new calls made by the calling thread so far
+inline int64_t& threadHeapAllocations()
+{
+	static thread_local int64_t count = 0;
+	return count;
+}
+
+#if HATCH_ALLOCATION_HOOK
+inline void* countedAllocate(std::size_t size)
+{
+	threadHeapAllocations()++;
+	if (size == 0)
+		size = 1;
+	for (;;) {
+		void* memory = std::malloc(size);
+		if (memory != nullptr)
+			return memory;
+		std::new_handler handler = std::get_new_handler();
+		if (handler == nullptr)
+			throw std::bad_alloc();
+		handler();
+	}
+}
+
+void* operator new(std::size_t size) { return countedAllocate(size); }
+void* operator new[](std::size_t size) { return countedAllocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	try {
+		return countedAllocate(size);
+	}
+	catch (...) {
+		return nullptr;
+	}
+}
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+#endif
+
+// Fails any frame after the warmup that allocated on the heap. Loading, first use of
+// thread locals and containers reaching their working size all happen in the warmup.
+class AllocationCheck
+{
+public:
+	bool enabled = false;
+	int64_t warmupFrames = 120;
+	int64_t failedFrames = 0;
+
+	void endFrame(int64_t frame, int64_t allocations)
+	{
+		if (!enabled || frame < warmupFrames)
+			return;
+		checkedFrames++;
+		if (allocations == 0)
+			return;
+		failedFrames++;
+		if (failedFrames <= 10)
+			std::cout << "Frame " << frame << " made " << allocations << " heap allocations" << std::endl;
+	}
+
+	// prints the outcome, true when no checked frame allocated
+	bool report() const
+	{
+		if (!enabled)
+			return true;
+#if !HATCH_ALLOCATION_HOOK
+		std::cout << "Allocation check needs HATCH_ALLOCATION_HOOK" << std::endl;
+		return false;
+#else
+		if (checkedFrames <= 0) {
+			std::cout << "Allocation check: no frames after the " << warmupFrames << " frame warmup" << std::endl;
+			return false;
+		}
+		std::cout << "Allocation check: " << failedFrames << " of " << checkedFrames << " frames allocated on the heap" << std::endl;
+		return failedFrames == 0;
+#endif
+	}
+
+private:
+	int64_t checkedFrames = 0;
+};
+#endif
@@ -0,0 +1,402 @@
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <iostream>
+#include <cmath>
+
+#include "animclip.h"
+
+// lane width follows the same instruction sets glm/simd detects
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define ANIM_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ANIM_SIMD_SSE2
+#elif defined(__ARM_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+#include <arm_neon.h>
+#define ANIM_SIMD_NEON
+#endif
+
+namespace anim_simd {
+
+// Thin wrapper so the evaluator is written once for every instruction set.
+// Only IEEE exact operations are used (no reciprocal estimates), so a lane gives
+// the same result on every run no matter how rigs are split between threads.
+#if defined(ANIM_SIMD_AVX2)
+	const int LANES = 8;
+	struct vfloat { __m256 v; };
+	inline vfloat load(const float* p) { return { _mm256_loadu_ps(p) }; }
+	inline void store(float* p, vfloat a) { _mm256_storeu_ps(p, a.v); }
+	inline vfloat set1(float f) { return { _mm256_set1_ps(f) }; }
+	inline vfloat operator+(vfloat a, vfloat b) { return { _mm256_add_ps(a.v, b.v) }; }
+	inline vfloat operator-(vfloat a, vfloat b) { return { _mm256_sub_ps(a.v, b.v) }; }
+	inline vfloat operator*(vfloat a, vfloat b) { return { _mm256_mul_ps(a.v, b.v) }; }
+	inline vfloat operator/(vfloat a, vfloat b) { return { _mm256_div_ps(a.v, b.v) }; }
+	inline vfloat sqrt(vfloat a) { return { _mm256_sqrt_ps(a.v) }; }
+	// sign of a where b is negative flipped, used to keep quaternions in the same hemisphere
+	inline vfloat flipsign(vfloat a, vfloat b) { return { _mm256_xor_ps(a.v, _mm256_and_ps(b.v, _mm256_set1_ps(-0.0f))) }; }
+#elif defined(ANIM_SIMD_SSE2)
+	const int LANES = 4;
+	struct vfloat { __m128 v; };
+	inline vfloat load(const float* p) { return { _mm_loadu_ps(p) }; }
+	inline void store(float* p, vfloat a) { _mm_storeu_ps(p, a.v); }
+	inline vfloat set1(float f) { return { _mm_set1_ps(f) }; }
+	inline vfloat operator+(vfloat a, vfloat b) { return { _mm_add_ps(a.v, b.v) }; }
+	inline vfloat operator-(vfloat a, vfloat b) { return { _mm_sub_ps(a.v, b.v) }; }
+	inline vfloat operator*(vfloat a, vfloat b) { return { _mm_mul_ps(a.v, b.v) }; }
+	inline vfloat operator/(vfloat a, vfloat b) { return { _mm_div_ps(a.v, b.v) }; }
+	inline vfloat sqrt(vfloat a) { return { _mm_sqrt_ps(a.v) }; }
+	inline vfloat flipsign(vfloat a, vfloat b) { return { _mm_xor_ps(a.v, _mm_and_ps(b.v, _mm_set1_ps(-0.0f))) }; }
+#elif defined(ANIM_SIMD_NEON)
+	const int LANES = 4;
+	struct vfloat { float32x4_t v; };
+	inline vfloat load(const float* p) { return { vld1q_f32(p) }; }
+	inline void store(float* p, vfloat a) { vst1q_f32(p, a.v); }
+	inline vfloat set1(float f) { return { vdupq_n_f32(f) }; }
+	inline vfloat operator+(vfloat a, vfloat b) { return { vaddq_f32(a.v, b.v) }; }
+	inline vfloat operator-(vfloat a, vfloat b) { return { vsubq_f32(a.v, b.v) }; }
+	inline vfloat operator*(vfloat a, vfloat b) { return { vmulq_f32(a.v, b.v) }; }
+	inline vfloat operator/(vfloat a, vfloat b) { return { vdivq_f32(a.v, b.v) }; }
+	inline vfloat sqrt(vfloat a) { return { vsqrtq_f32(a.v) }; }
+	inline vfloat flipsign(vfloat a, vfloat b)
+	{
+		uint32x4_t sign = vandq_u32(vreinterpretq_u32_f32(b.v), vdupq_n_u32(0x80000000u));
+		return { vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(a.v), sign)) };
+	}
+#else
+	const int LANES = 4;
+	struct vfloat { float v[4]; };
+	inline vfloat load(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+	inline void store(float* p, vfloat a) { for (int i = 0; i < 4; i++) p[i] = a.v[i]; }
+	inline vfloat set1(float f) { return { { f, f, f, f } }; }
+	inline vfloat operator+(vfloat a, vfloat b) { for (int i = 0; i < 4; i++) a.v[i] += b.v[i]; return a; }
+	inline vfloat operator-(vfloat a, vfloat b) { for (int i = 0; i < 4; i++) a.v[i] -= b.v[i]; return a; }
+	inline vfloat operator*(vfloat a, vfloat b) { for (int i = 0; i < 4; i++) a.v[i] *= b.v[i]; return a; }
+	inline vfloat operator/(vfloat a, vfloat b) { for (int i = 0; i < 4; i++) a.v[i] /= b.v[i]; return a; }
+	inline vfloat sqrt(vfloat a) { for (int i = 0; i < 4; i++) a.v[i] = std::sqrt(a.v[i]); return a; }
+	inline vfloat flipsign(vfloat a, vfloat b) { for (int i = 0; i < 4; i++) if (std::signbit(b.v[i])) a.v[i] = -a.v[i]; return a; }
+#endif
+
+	inline vfloat lerp(vfloat a, vfloat b, vfloat t) { return a + (b - a) * t; }
+}
+
+// parent of every joint, parents always come before their children
+struct Skeleton
+{
+	std::vector<int> parents;
+
+	int jointCount() const { return (int)parents.size(); }
+};
+
+// a rig being animated: clip a blended towards clip b by blend, placed in the world by root.
+// Compressed clips (packedA/packedB) are used instead of the raw ones when set.
+struct RigInstance
+{
+	const AnimationClip* clipA = nullptr;
+	float timeA = 0.0f;
+	const AnimationClip* clipB = nullptr;
+	float timeB = 0.0f;
+	float blend = 0.0f;
+	glm::mat4 root = glm::mat4(1.0f);
+	const CompressedClip* packedA = nullptr;
+	const CompressedClip* packedB = nullptr;
+
+	bool hasSecondClip() const { return clipB != nullptr || packedB != nullptr; }
+};
+
+// Samples, blends and composes local-to-world matrices for many rigs at once, one rig per simd lane.
+// Rigs are handed to threads in whole lane groups, each rig only ever depends on its own inputs,
+// so the output is bit identical for any thread count.
+class AnimationEvaluator
+{
+public:
+	static const int LANES = anim_simd::LANES;
+	// below this many rigs per thread spawning threads costs more than it saves
+	int rigsPerThread = 256;
+
+	AnimationEvaluator(const Skeleton& skel, int threads = 0) : skeleton(skel)
+	{
+		threadCount = threads > 0 ? threads : (int)std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	int threads() const { return threadCount; }
+	void setThreads(int threads) { threadCount = std::max(1, threads); }
+
+	// writes jointCount world matrices per rig into worlds
+	void evaluate(const RigInstance* rigs, int rigCount, glm::mat4* worlds) const
+	{
+		int groups = (rigCount + LANES - 1) / LANES;
+		int workers = std::min(threadCount, std::max(1, rigCount / rigsPerThread));
+		if (workers <= 1) {
+			evaluateGroups(rigs, rigCount, worlds, 0, groups);
+			return;
+		}
+
+		std::vector<std::thread> pool;
+		for (int w = 1; w < workers; w++) {
+			int begin = groups * w / workers;
+			int end = groups * (w + 1) / workers;
+			pool.emplace_back([this, rigs, rigCount, worlds, begin, end]() { evaluateGroups(rigs, rigCount, worlds, begin, end); });
+		}
+		evaluateGroups(rigs, rigCount, worlds, 0, groups / workers);
+		for (std::thread& t : pool) {
+			t.join();
+		}
+	}
+
+private:
+	Skeleton skeleton;
+	int threadCount;
+
+	// key indices and interpolation factors of one clip for every lane
+	struct LaneKeys
+	{
+		const AnimationClip* clip[LANES];
+		const CompressedClip* packed[LANES];
+		float time[LANES];
+		int k0[LANES];
+		int k1[LANES];
+		float alpha[LANES];
+	};
+
+	static void laneKeys(LaneKeys& keys, const RigInstance* group, int count, bool second)
+	{
+		for (int l = 0; l < LANES; l++) {
+			const RigInstance& rig = group[std::min(l, count - 1)]; // pad the last group with its last rig
+			bool useSecond = second && rig.hasSecondClip();
+			keys.clip[l] = useSecond ? rig.clipB : rig.clipA;
+			keys.packed[l] = useSecond ? rig.packedB : rig.packedA;
+			keys.time[l] = useSecond ? rig.timeB : rig.timeA;
+			if (keys.packed[l] != nullptr) {
+				// compressed clips are decoded already interpolated, per joint in sampleJoint()
+				keys.k0[l] = keys.k1[l] = 0;
+				keys.alpha[l] = 0.0f;
+			} else {
+				keys.clip[l]->keyInterval(keys.time[l], keys.k0[l], keys.k1[l], keys.alpha[l]);
+			}
+		}
+	}
+
+	// samples one joint of every lane's clip into SoA vectors
+	static void sampleJoint(const LaneKeys& keys, int joint, anim_simd::vfloat out[TRACK_COMPONENTS])
+	{
+		using namespace anim_simd;
+		alignas(32) float a[TRACK_COMPONENTS][LANES];
+		alignas(32) float b[TRACK_COMPONENTS][LANES];
+		for (int l = 0; l < LANES; l++) {
+			if (keys.packed[l] != nullptr) {
+				JointTransform sample = keys.packed[l]->sampleJoint(joint, keys.time[l]);
+				float values[TRACK_COMPONENTS] = {
+					sample.translation.x, sample.translation.y, sample.translation.z,
+					sample.rotation.x, sample.rotation.y, sample.rotation.z, sample.rotation.w,
+					sample.scale.x, sample.scale.y, sample.scale.z,
+				};
+				for (int c = 0; c < TRACK_COMPONENTS; c++) {
+					a[c][l] = b[c][l] = values[c];
+				}
+				continue;
+			}
+			const AnimationClip* clip = keys.clip[l];
+			int first = joint * clip->keyCount;
+			for (int c = 0; c < TRACK_COMPONENTS; c++) {
+				a[c][l] = clip->tracks[c][first + keys.k0[l]];
+				b[c][l] = clip->tracks[c][first + keys.k1[l]];
+			}
+		}
+
+		vfloat alpha = load(keys.alpha);
+		for (int c = TrackTX; c <= TrackTZ; c++) {
+			out[c] = lerp(load(a[c]), load(b[c]), alpha);
+		}
+		for (int c = TrackSX; c <= TrackSZ; c++) {
+			out[c] = lerp(load(a[c]), load(b[c]), alpha);
+		}
+		// rotations take the shortest arc, normalised once after the clip blend
+		vfloat dot = load(a[TrackRX]) * load(b[TrackRX]) + load(a[TrackRY]) * load(b[TrackRY])
+			+ load(a[TrackRZ]) * load(b[TrackRZ]) + load(a[TrackRW]) * load(b[TrackRW]);
+		for (int c = TrackRX; c <= TrackRW; c++) {
+			out[c] = lerp(load(a[c]), flipsign(load(b[c]), dot), alpha);
+		}
+	}
+
+	void evaluateGroups(const RigInstance* rigs, int rigCount, glm::mat4* worlds, int beginGroup, int endGroup) const
+	{
+		using namespace anim_simd;
+		int joints = skeleton.jointCount();
+		// plain floats, the heap does not guarantee the alignment wide vectors need.
+		// Kept per thread so evaluating every frame does not go back to the heap.
+		static thread_local std::vector<float> world;
+		world.resize(joints * 16 * LANES);
+		alignas(32) float lanes[16][LANES];
+		alignas(32) float blend[LANES];
+
+		for (int g = beginGroup; g < endGroup; g++) {
+			const RigInstance* group = rigs + g * LANES;
+			int count = std::min(LANES, rigCount - g * LANES);
+
+			LaneKeys keysA, keysB;
+			laneKeys(keysA, group, count, false);
+			laneKeys(keysB, group, count, true);
+
+			for (int l = 0; l < LANES; l++) {
+				const RigInstance& rig = group[std::min(l, count - 1)];
+				blend[l] = rig.hasSecondClip() ? rig.blend : 0.0f;
+				for (int e = 0; e < 16; e++) {
+					lanes[e][l] = rig.root[e / 4][e % 4];
+				}
+			}
+			vfloat root[16];
+			for (int e = 0; e < 16; e++) {
+				root[e] = load(lanes[e]);
+			}
+			vfloat weight = load(blend);
+
+			for (int j = 0; j < joints; j++) {
+				vfloat a[TRACK_COMPONENTS], b[TRACK_COMPONENTS];
+				sampleJoint(keysA, j, a);
+				sampleJoint(keysB, j, b);
+
+				// blend the two clips, then renormalise the rotation
+				vfloat dot = a[TrackRX] * b[TrackRX] + a[TrackRY] * b[TrackRY] + a[TrackRZ] * b[TrackRZ] + a[TrackRW] * b[TrackRW];
+				vfloat t[3], q[4], s[3];
+				for (int i = 0; i < 3; i++) {
+					t[i] = lerp(a[TrackTX + i], b[TrackTX + i], weight);
+					s[i] = lerp(a[TrackSX + i], b[TrackSX + i], weight);
+				}
+				for (int i = 0; i < 4; i++) {
+					q[i] = lerp(a[TrackRX + i], flipsign(b[TrackRX + i], dot), weight);
+				}
+				vfloat length = sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+				for (int i = 0; i < 4; i++) {
+					q[i] = q[i] / length;
+				}
+
+				// local matrix columns (rotation * scale, translation)
+				vfloat one = set1(1.0f), two = set1(2.0f);
+				vfloat xx = q[0] * q[0], yy = q[1] * q[1], zz = q[2] * q[2];
+				vfloat xy = q[0] * q[1], xz = q[0] * q[2], yz = q[1] * q[2];
+				vfloat wx = q[3] * q[0], wy = q[3] * q[1], wz = q[3] * q[2];
+				vfloat local[3][3] = {
+					{ (one - two * (yy + zz)) * s[0], two * (xy + wz) * s[0], two * (xz - wy) * s[0] },
+					{ two * (xy - wz) * s[1], (one - two * (xx + zz)) * s[1], two * (yz + wx) * s[1] },
+					{ two * (xz + wy) * s[2], two * (yz - wx) * s[2], (one - two * (xx + yy)) * s[2] },
+				};
+
+				// world = parent world * local
+				int parent = skeleton.parents[j];
+				vfloat p[16];
+				for (int e = 0; e < 16; e++) {
+					p[e] = parent < 0 ? root[e] : load(&world[(parent * 16 + e) * LANES]);
+				}
+				vfloat w[16];
+				for (int r = 0; r < 4; r++) {
+					for (int c = 0; c < 3; c++) {
+						w[c * 4 + r] = p[0 * 4 + r] * local[c][0] + p[1 * 4 + r] * local[c][1] + p[2 * 4 + r] * local[c][2];
+					}
+					w[3 * 4 + r] = p[0 * 4 + r] * t[0] + p[1 * 4 + r] * t[1] + p[2 * 4 + r] * t[2] + p[3 * 4 + r];
+				}
+
+				for (int e = 0; e < 16; e++) {
+					store(&world[(j * 16 + e) * LANES], w[e]);
+					store(lanes[e], w[e]);
+				}
+				for (int l = 0; l < count; l++) {
+					glm::mat4& out = worlds[(g * LANES + l) * joints + j];
+					for (int e = 0; e < 16; e++) {
+						out[e / 4][e % 4] = lanes[e][l];
+					}
+				}
+			}
+		}
+	}
+};
+
+// Times evaluate() for rigCount rigs on 1..max threads and checks every thread count
+// produced identical matrices. Returns false if the output was not deterministic.
+inline bool runAnimationBenchmark(const Skeleton& skeleton, const std::vector<AnimationClip>& clips, int rigCount, int iterations = 20)
+{
+	std::vector<RigInstance> rigs(rigCount);
+	unsigned int seed = 12345u;
+	auto random = [&seed]() { seed = seed * 1664525u + 1013904223u; return (seed >> 8) / 16777216.0f; };
+	for (RigInstance& rig : rigs) {
+		rig.clipA = &clips[(int)(random() * clips.size()) % clips.size()];
+		rig.clipB = &clips[(int)(random() * clips.size()) % clips.size()];
+		rig.timeA = random() * 2.0f;
+		rig.timeB = random() * 2.0f;
+		rig.blend = random();
+		rig.root[3] = glm::vec4(random() * 100.0f, 0.0f, random() * 100.0f, 1.0f);
+	}
+
+	int joints = skeleton.jointCount();
+	std::vector<glm::mat4> reference(rigCount * joints), worlds(rigCount * joints);
+	int maxThreads = (int)std::max(1u, std::thread::hardware_concurrency());
+	AnimationEvaluator evaluator(skeleton, 1);
+	evaluator.rigsPerThread = 1;
+	evaluator.evaluate(rigs.data(), rigCount, reference.data());
+
+	std::cout << "animation benchmark: " << rigCount << " rigs, " << joints << " joints, " << AnimationEvaluator::LANES << " lanes" << std::endl;
+	std::vector<int> threadCounts;
+	for (int threads = 1; threads < maxThreads; threads *= 2) {
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(maxThreads); // always finish on every core
+
+	double singleThread = 0.0;
+	bool deterministic = true;
+	for (int threads : threadCounts) {
+		evaluator.setThreads(threads);
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < iterations; i++) {
+			evaluator.evaluate(rigs.data(), rigCount, worlds.data());
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / iterations;
+		if (threads == 1)
+			singleThread = seconds;
+
+		bool same = std::equal(worlds.begin(), worlds.end(), reference.begin());
+		deterministic = deterministic && same;
+		std::cout << "  threads " << threads << ": " << seconds * 1000.0 << " ms, "
+			<< (rigCount / seconds) / 1.0e6 << " M rigs/s, speedup " << singleThread / seconds
+			<< (same ? "" : " (OUTPUT DIFFERS)") << std::endl;
+	}
+
+	// the same rigs on the clips compressed (animclip.h), decoded while sampling
+	std::vector<unsigned char> library = buildClipLibrary(clips, ClipTolerance());
+	ClipLibrary packed(library.data(), library.size());
+	if (!packed.valid())
+		return false;
+	std::vector<CompressedClip> compressed;
+	for (int c = 0; c < packed.clipCount(); c++) {
+		compressed.push_back(packed.clip(c));
+	}
+	std::vector<RigInstance> packedRigs = rigs;
+	for (RigInstance& rig : packedRigs) {
+		rig.packedA = &compressed[rig.clipA - clips.data()];
+		rig.packedB = &compressed[rig.clipB - clips.data()];
+	}
+	evaluator.setThreads(maxThreads);
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; i++) {
+		evaluator.evaluate(packedRigs.data(), rigCount, worlds.data());
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / iterations;
+	float error = 0.0f;
+	for (size_t i = 0; i < worlds.size(); i++) {
+		error = std::max(error, glm::length(glm::vec3(worlds[i][3]) - glm::vec3(reference[i][3])));
+	}
+	// key reduction and quantisation add up down the joint chain, but stay far below this
+	bool accurate = error < 0.01f;
+	std::cout << "  packed clips, threads " << maxThreads << ": " << seconds * 1000.0 << " ms, "
+		<< (rigCount / seconds) / 1.0e6 << " M rigs/s, largest joint error " << error
+		<< (accurate ? "" : " (TOO FAR FROM THE RAW CLIPS)") << std::endl;
+	return deterministic && accurate;
+}
+#endif
@@ -0,0 +1,594 @@
+#ifndef ANIMCLIP_H
+#define ANIMCLIP_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+#include "mappedfile.h"
+
+// local transform of one joint relative to its parent
+struct JointTransform
+{
+	glm::vec3 translation = glm::vec3(0.0f);
+	glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+	glm::vec3 scale = glm::vec3(1.0f);
+};
+
+// splits an affine matrix without shear back into translation, rotation and scale
+inline JointTransform decomposeTransform(const glm::mat4& m)
+{
+	JointTransform result;
+	result.translation = glm::vec3(m[3]);
+	result.scale = glm::vec3(glm::length(glm::vec3(m[0])), glm::length(glm::vec3(m[1])), glm::length(glm::vec3(m[2])));
+	glm::mat3 rotation(glm::vec3(m[0]) / result.scale.x, glm::vec3(m[1]) / result.scale.y, glm::vec3(m[2]) / result.scale.z);
+	result.rotation = glm::normalize(glm::quat_cast(rotation));
+	return result;
+}
+
+// lerp translation and scale, nlerp rotation along the shortest arc
+inline glm::quat nlerpRotation(const glm::quat& a, glm::quat b, float t)
+{
+	if (glm::dot(a, b) < 0.0f)
+		b = -b;
+	glm::quat q(a.w + (b.w - a.w) * t, a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t);
+	return glm::normalize(q);
+}
+
+inline JointTransform blendJoint(const JointTransform& a, const JointTransform& b, float t)
+{
+	JointTransform result;
+	result.translation = glm::mix(a.translation, b.translation, t);
+	result.rotation = nlerpRotation(a.rotation, b.rotation, t);
+	result.scale = glm::mix(a.scale, b.scale, t);
+	return result;
+}
+
+// track components, each one is stored as its own array (SoA)
+enum TrackComponent
+{
+	TrackTX, TrackTY, TrackTZ,
+	TrackRX, TrackRY, TrackRZ, TrackRW,
+	TrackSX, TrackSY, TrackSZ,
+	TRACK_COMPONENTS
+};
+
+// Uniformly sampled clip. Component c of joint j at key k lives at tracks[c][j * keyCount + k],
+// so sampling a joint touches two neighbouring floats of each track.
+class AnimationClip
+{
+public:
+	int jointCount = 0;
+	int keyCount = 0;
+	float sampleRate = 30.0f;
+	bool looping = false;
+	std::vector<float> tracks[TRACK_COMPONENTS];
+
+	AnimationClip() {}
+
+	// keys holds keyCount poses of jointCount joints one after the other
+	AnimationClip(const std::vector<JointTransform>& keys, int joints, float rate, bool loop = false)
+		: jointCount(joints), keyCount((int)keys.size() / joints), sampleRate(rate), looping(loop)
+	{
+		for (int c = 0; c < TRACK_COMPONENTS; c++) {
+			tracks[c].resize(jointCount * keyCount);
+		}
+		for (int k = 0; k < keyCount; k++) {
+			for (int j = 0; j < jointCount; j++) {
+				const JointTransform& key = keys[k * jointCount + j];
+				int i = j * keyCount + k;
+				tracks[TrackTX][i] = key.translation.x;
+				tracks[TrackTY][i] = key.translation.y;
+				tracks[TrackTZ][i] = key.translation.z;
+				tracks[TrackRX][i] = key.rotation.x;
+				tracks[TrackRY][i] = key.rotation.y;
+				tracks[TrackRZ][i] = key.rotation.z;
+				tracks[TrackRW][i] = key.rotation.w;
+				tracks[TrackSX][i] = key.scale.x;
+				tracks[TrackSY][i] = key.scale.y;
+				tracks[TrackSZ][i] = key.scale.z;
+			}
+		}
+	}
+
+	float duration() const { return keyCount > 1 ? (keyCount - 1) / sampleRate : 0.0f; }
+
+	// finds the two keys either side of time and how far between them it is
+	void keyInterval(float time, int& k0, int& k1, float& alpha) const
+	{
+		float position = time * sampleRate;
+		float last = (float)(keyCount - 1);
+		if (looping && last > 0.0f) {
+			position = std::fmod(position, last);
+			if (position < 0.0f)
+				position += last;
+		}
+		position = glm::clamp(position, 0.0f, last);
+		k0 = (int)position;
+		k1 = std::min(k0 + 1, keyCount - 1);
+		alpha = position - (float)k0;
+	}
+
+	float value(int component, int joint, int key) const { return tracks[component][joint * keyCount + key]; }
+
+	// scalar sample of one joint, the evaluator does the same for many rigs at once
+	JointTransform sampleJoint(int joint, float time) const
+	{
+		int k0, k1;
+		float alpha;
+		keyInterval(time, k0, k1, alpha);
+		JointTransform a, b;
+		a.translation = glm::vec3(value(TrackTX, joint, k0), value(TrackTY, joint, k0), value(TrackTZ, joint, k0));
+		a.rotation = glm::quat(value(TrackRW, joint, k0), value(TrackRX, joint, k0), value(TrackRY, joint, k0), value(TrackRZ, joint, k0));
+		a.scale = glm::vec3(value(TrackSX, joint, k0), value(TrackSY, joint, k0), value(TrackSZ, joint, k0));
+		b.translation = glm::vec3(value(TrackTX, joint, k1), value(TrackTY, joint, k1), value(TrackTZ, joint, k1));
+		b.rotation = glm::quat(value(TrackRW, joint, k1), value(TrackRX, joint, k1), value(TrackRY, joint, k1), value(TrackRZ, joint, k1));
+		b.scale = glm::vec3(value(TrackSX, joint, k1), value(TrackSY, joint, k1), value(TrackSZ, joint, k1));
+		return blendJoint(a, b, alpha);
+	}
+};
+
+// Compressed clips
+// ------------------------------------------------------------------------
+// Every track (translation, rotation or scale of one joint) keeps only the keys needed to stay
+// within tolerance, each key is 6 bytes: rotations are smallest three quaternions (2 bit index,
+// 3 x 15 bits), translations and scales 3 x 16 bits inside the track's own range.
+// Everything is addressed by offsets so a library can be memory mapped and sampled in place.
+
+// tolerances used when dropping keys, quantisation error comes on top
+struct ClipTolerance
+{
+	float translation = 0.0005f; // scene units
+	float rotation = 0.01f; // degrees
+	float scale = 0.001f;
+};
+
+enum PackedTrackType
+{
+	PackedTranslation,
+	PackedRotation,
+	PackedScale,
+	PACKED_TRACK_TYPES
+};
+
+const uint32_t CLIP_LIBRARY_MAGIC = 0x50494C43; // "CLIP"
+const uint32_t CLIP_LIBRARY_VERSION = 1;
+
+// file layout, little endian: header, clip offsets, then the clips
+struct ClipLibraryHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t clipCount;
+	uint32_t reserved;
+};
+
+// frame numbers and key counts are 16 bit
+const uint32_t MAX_PACKED_FRAMES = 65535;
+
+// clip layout: header, PACKED_TRACK_TYPES tracks per joint, then the key data of every track
+struct PackedClipHeader
+{
+	uint32_t jointCount;
+	uint32_t frameCount;
+	float sampleRate;
+	uint32_t looping;
+};
+
+struct PackedTrack
+{
+	uint32_t dataOffset; // from the start of the clip: keyCount frame numbers, then keyCount * 3 values
+	uint16_t keyCount;
+	uint16_t type;
+	float rangeMin[3];
+	float rangeExtent[3];
+};
+
+const float SMALLEST_THREE_RANGE = 0.70710678f; // the three smaller components are within +-1/sqrt(2)
+
+inline void packRotation(const glm::quat& q, uint16_t out[3])
+{
+	float c[4] = { q.x, q.y, q.z, q.w };
+	int largest = 0;
+	for (int i = 1; i < 4; i++) {
+		if (std::fabs(c[i]) > std::fabs(c[largest]))
+			largest = i;
+	}
+	float sign = c[largest] < 0.0f ? -1.0f : 1.0f; // q and -q are the same rotation
+	int o = 0;
+	for (int i = 0; i < 4; i++) {
+		if (i == largest)
+			continue;
+		float unit = (c[i] * sign / SMALLEST_THREE_RANGE) * 0.5f + 0.5f;
+		out[o++] = (uint16_t)glm::clamp((int)std::lround(unit * 32767.0f), 0, 32767);
+	}
+	out[0] |= (uint16_t)((largest & 1) << 15);
+	out[1] |= (uint16_t)((largest >> 1) << 15);
+}
+
+inline glm::quat unpackRotation(const uint16_t in[3])
+{
+	int largest = (in[0] >> 15) | ((in[1] >> 15) << 1);
+	float v[3];
+	float sum = 0.0f;
+	for (int i = 0; i < 3; i++) {
+		v[i] = ((in[i] & 0x7FFF) / 32767.0f * 2.0f - 1.0f) * SMALLEST_THREE_RANGE;
+		sum += v[i] * v[i];
+	}
+	float c[4];
+	int o = 0;
+	for (int i = 0; i < 4; i++) {
+		c[i] = i == largest ? std::sqrt(std::max(0.0f, 1.0f - sum)) : v[o++];
+	}
+	return glm::quat(c[3], c[0], c[1], c[2]);
+}
+
+// angle between two rotations, from the chord length since acos loses precision near 1
+inline float rotationErrorDegrees(const glm::quat& a, const glm::quat& b)
+{
+	glm::quat na = glm::normalize(a), nb = glm::normalize(b);
+	if (glm::dot(na, nb) < 0.0f)
+		nb = -nb;
+	glm::vec4 chord(na.x - nb.x, na.y - nb.y, na.z - nb.z, na.w - nb.w);
+	float half = std::min(1.0f, glm::length(chord) * 0.5f);
+	return glm::degrees(4.0f * std::asin(half));
+}
+
+// keeps the fewest keys such that interpolating between them stays within tolerance of every sample
+template <typename Value, typename Blend, typename Error>
+std::vector<int> reduceKeys(const std::vector<Value>& samples, float tolerance, Blend blend, Error error)
+{
+	int n = (int)samples.size();
+	std::vector<int> kept(1, 0);
+
+	bool constant = true;
+	for (int i = 1; i < n && constant; i++) {
+		constant = error(samples[0], samples[i]) <= tolerance;
+	}
+	if (constant)
+		return kept;
+
+	auto fits = [&](int a, int b) {
+		for (int i = a + 1; i < b; i++) {
+			if (error(blend(samples[a], samples[b], (float)(i - a) / (float)(b - a)), samples[i]) > tolerance)
+				return false;
+		}
+		return true;
+	};
+
+	int anchor = 0;
+	while (anchor < n - 1) {
+		int end = anchor + 1;
+		while (end + 1 < n && fits(anchor, end + 1)) {
+			end++;
+		}
+		kept.push_back(end);
+		anchor = end;
+	}
+	return kept;
+}
+
+// view of one compressed clip, usually pointing straight into a mapped file
+class CompressedClip
+{
+public:
+	CompressedClip() {}
+	CompressedClip(const unsigned char* data) : base(data) {}
+
+	const PackedClipHeader& header() const { return *(const PackedClipHeader*)base; }
+	int jointCount() const { return (int)header().jointCount; }
+	float duration() const { return header().frameCount > 1 ? (header().frameCount - 1) / header().sampleRate : 0.0f; }
+
+	const PackedTrack& track(int joint, int type) const
+	{
+		const PackedTrack* tracks = (const PackedTrack*)(base + sizeof(PackedClipHeader));
+		return tracks[joint * PACKED_TRACK_TYPES + type];
+	}
+
+	// decodes only the two keys around time for each of the joint's tracks
+	JointTransform sampleJoint(int joint, float time) const
+	{
+		float frame = framePosition(time);
+		JointTransform result;
+		result.translation = glm::vec3(sampleTrack(track(joint, PackedTranslation), frame));
+		glm::vec4 q = sampleTrack(track(joint, PackedRotation), frame);
+		result.rotation = glm::quat(q.w, q.x, q.y, q.z);
+		result.scale = glm::vec3(sampleTrack(track(joint, PackedScale), frame));
+		return result;
+	}
+
+	void samplePose(float time, JointTransform* out) const
+	{
+		for (int j = 0; j < jointCount(); j++) {
+			out[j] = sampleJoint(j, time);
+		}
+	}
+
+private:
+	const unsigned char* base = nullptr;
+
+	// same wrapping and clamping as AnimationClip::keyInterval, in frames
+	float framePosition(float time) const
+	{
+		float position = time * header().sampleRate;
+		float last = (float)(header().frameCount - 1);
+		if (header().looping && last > 0.0f) {
+			position = std::fmod(position, last);
+			if (position < 0.0f)
+				position += last;
+		}
+		return glm::clamp(position, 0.0f, last);
+	}
+
+	static glm::vec4 decodeKey(const PackedTrack& track, const uint16_t* values, int key)
+	{
+		const uint16_t* v = values + key * 3;
+		if (track.type == PackedRotation) {
+			glm::quat q = unpackRotation(v);
+			return glm::vec4(q.x, q.y, q.z, q.w);
+		}
+		glm::vec4 result(0.0f);
+		for (int i = 0; i < 3; i++) {
+			result[i] = track.rangeMin[i] + (v[i] / 65535.0f) * track.rangeExtent[i];
+		}
+		return result;
+	}
+
+	glm::vec4 sampleTrack(const PackedTrack& track, float frame) const
+	{
+		const uint16_t* frames = (const uint16_t*)(base + track.dataOffset);
+		const uint16_t* values = frames + track.keyCount;
+		if (track.keyCount == 1)
+			return decodeKey(track, values, 0);
+
+		int k1 = (int)(std::upper_bound(frames, frames + track.keyCount, (uint16_t)frame) - frames);
+		k1 = glm::clamp(k1, 1, (int)track.keyCount - 1);
+		int k0 = k1 - 1;
+		float t = glm::clamp((frame - frames[k0]) / (float)(frames[k1] - frames[k0]), 0.0f, 1.0f);
+
+		glm::vec4 a = decodeKey(track, values, k0);
+		glm::vec4 b = decodeKey(track, values, k1);
+		if (track.type == PackedRotation) {
+			glm::quat q = nlerpRotation(glm::quat(a.w, a.x, a.y, a.z), glm::quat(b.w, b.x, b.y, b.z), t);
+			return glm::vec4(q.x, q.y, q.z, q.w);
+		}
+		return glm::mix(a, b, t);
+	}
+};
+
+template <typename T>
+void appendBytes(std::vector<unsigned char>& bytes, const T* data, size_t count)
+{
+	const unsigned char* p = (const unsigned char*)data;
+	bytes.insert(bytes.end(), p, p + sizeof(T) * count);
+}
+
+inline void alignBytes(std::vector<unsigned char>& bytes, size_t alignment)
+{
+	while (bytes.size() % alignment != 0) {
+		bytes.push_back(0);
+	}
+}
+
+inline std::vector<unsigned char> compressClip(const AnimationClip& clip, const ClipTolerance& tolerance)
+{
+	int joints = clip.jointCount;
+	int frames = clip.keyCount;
+	if (frames < 1 || (uint32_t)frames > MAX_PACKED_FRAMES) {
+		std::cout << "ERROR::CLIPLIBRARY::FRAME_COUNT: " << frames << " frames, at most " << MAX_PACKED_FRAMES << std::endl;
+		return std::vector<unsigned char>();
+	}
+
+	PackedClipHeader header = { (uint32_t)joints, (uint32_t)frames, clip.sampleRate, clip.looping ? 1u : 0u };
+	std::vector<PackedTrack> tracks(joints * PACKED_TRACK_TYPES);
+	std::vector<unsigned char> data;
+	size_t dataStart = sizeof(PackedClipHeader) + sizeof(PackedTrack) * tracks.size();
+
+	auto vectorBlend = [](const glm::vec3& a, const glm::vec3& b, float t) { return glm::mix(a, b, t); };
+	auto vectorError = [](const glm::vec3& a, const glm::vec3& b) { return glm::length(a - b); };
+	auto rotationBlend = [](const glm::quat& a, const glm::quat& b, float t) { return nlerpRotation(a, b, t); };
+
+	for (int j = 0; j < joints; j++) {
+		for (int type = 0; type < PACKED_TRACK_TYPES; type++) {
+			PackedTrack& track = tracks[j * PACKED_TRACK_TYPES + type];
+			track.type = (uint16_t)type;
+			std::vector<int> keys;
+			std::vector<glm::vec3> vectors(frames);
+			std::vector<glm::quat> rotations(frames);
+			int first = type == PackedTranslation ? TrackTX : TrackSX;
+			for (int k = 0; k < frames; k++) {
+				if (type == PackedRotation) {
+					rotations[k] = glm::quat(clip.value(TrackRW, j, k), clip.value(TrackRX, j, k), clip.value(TrackRY, j, k), clip.value(TrackRZ, j, k));
+				} else {
+					vectors[k] = glm::vec3(clip.value(first, j, k), clip.value(first + 1, j, k), clip.value(first + 2, j, k));
+				}
+			}
+
+			if (type == PackedRotation) {
+				keys = reduceKeys(rotations, tolerance.rotation, rotationBlend, rotationErrorDegrees);
+			} else {
+				keys = reduceKeys(vectors, type == PackedTranslation ? tolerance.translation : tolerance.scale, vectorBlend, vectorError);
+			}
+
+			// range of the kept keys, values are stored as a fraction of it
+			glm::vec3 low(0.0f), high(0.0f);
+			if (type != PackedRotation) {
+				low = high = vectors[keys[0]];
+				for (int k : keys) {
+					low = glm::min(low, vectors[k]);
+					high = glm::max(high, vectors[k]);
+				}
+			}
+			for (int i = 0; i < 3; i++) {
+				track.rangeMin[i] = low[i];
+				track.rangeExtent[i] = high[i] - low[i];
+			}
+
+			alignBytes(data, 4);
+			track.dataOffset = (uint32_t)(dataStart + data.size());
+			track.keyCount = (uint16_t)keys.size();
+			for (int k : keys) {
+				uint16_t frame = (uint16_t)k;
+				appendBytes(data, &frame, 1);
+			}
+			for (int k : keys) {
+				uint16_t values[3];
+				if (type == PackedRotation) {
+					packRotation(rotations[k], values);
+				} else {
+					for (int i = 0; i < 3; i++) {
+						float unit = track.rangeExtent[i] > 0.0f ? (vectors[k][i] - low[i]) / track.rangeExtent[i] : 0.0f;
+						values[i] = (uint16_t)glm::clamp((int)std::lround(unit * 65535.0f), 0, 65535);
+					}
+				}
+				appendBytes(data, values, 3);
+			}
+		}
+	}
+
+	std::vector<unsigned char> bytes;
+	appendBytes(bytes, &header, 1);
+	appendBytes(bytes, tracks.data(), tracks.size());
+	bytes.insert(bytes.end(), data.begin(), data.end());
+	alignBytes(bytes, 4);
+	return bytes;
+}
+
+inline std::vector<unsigned char> buildClipLibrary(const std::vector<AnimationClip>& clips, const ClipTolerance& tolerance)
+{
+	ClipLibraryHeader header = { CLIP_LIBRARY_MAGIC, CLIP_LIBRARY_VERSION, (uint32_t)clips.size(), 0 };
+	std::vector<unsigned char> bytes;
+	appendBytes(bytes, &header, 1);
+	bytes.resize(bytes.size() + sizeof(uint32_t) * clips.size());
+
+	for (size_t i = 0; i < clips.size(); i++) {
+		uint32_t offset = (uint32_t)bytes.size();
+		std::memcpy(&bytes[sizeof(ClipLibraryHeader) + sizeof(uint32_t) * i], &offset, sizeof(offset));
+		std::vector<unsigned char> clip = compressClip(clips[i], tolerance);
+		if (clip.empty())
+			return std::vector<unsigned char>(); // refused by ClipLibrary
+		bytes.insert(bytes.end(), clip.begin(), clip.end());
+	}
+	return bytes;
+}
+
+// clips of a library held in memory or mapped from disk
+class ClipLibrary
+{
+public:
+	ClipLibrary(const unsigned char* data, size_t size) : base(data), bytes(size)
+	{
+		if (base == nullptr || bytes < sizeof(ClipLibraryHeader) || header().magic != CLIP_LIBRARY_MAGIC || header().version != CLIP_LIBRARY_VERSION
+			|| bytes < sizeof(ClipLibraryHeader) + sizeof(uint32_t) * (uint64_t)header().clipCount || !validate()) {
+			std::cout << "ERROR::CLIPLIBRARY::INVALID_DATA" << std::endl;
+			base = nullptr;
+		}
+	}
+
+	bool valid() const { return base != nullptr; }
+	int clipCount() const { return valid() ? (int)header().clipCount : 0; }
+
+	CompressedClip clip(int i) const
+	{
+		const uint32_t* offsets = (const uint32_t*)(base + sizeof(ClipLibraryHeader));
+		return CompressedClip(base + offsets[i]);
+	}
+
+private:
+	const unsigned char* base;
+	size_t bytes;
+
+	const ClipLibraryHeader& header() const { return *(const ClipLibraryHeader*)base; }
+
+	// every clip's header and track table, and every track's keys, inside the data, so a
+	// truncated or corrupt file is refused here rather than read past its end when sampled
+	bool validate() const
+	{
+		const uint32_t* offsets = (const uint32_t*)(base + sizeof(ClipLibraryHeader));
+		for (uint32_t c = 0; c < header().clipCount; c++) {
+			uint64_t start = offsets[c];
+			if (start % 4 != 0 || start + sizeof(PackedClipHeader) > bytes)
+				return false;
+			const PackedClipHeader& clip = *(const PackedClipHeader*)(base + start);
+			uint64_t trackCount = (uint64_t)clip.jointCount * PACKED_TRACK_TYPES;
+			if (clip.frameCount == 0 || clip.frameCount > MAX_PACKED_FRAMES || !(clip.sampleRate > 0.0f)
+				|| start + sizeof(PackedClipHeader) + trackCount * sizeof(PackedTrack) > bytes)
+				return false;
+			const PackedTrack* tracks = (const PackedTrack*)(base + start + sizeof(PackedClipHeader));
+			for (uint64_t t = 0; t < trackCount; t++) {
+				const PackedTrack& track = tracks[t];
+				// keyCount frame numbers, then 3 values a key
+				if (track.keyCount == 0 || track.type != t % PACKED_TRACK_TYPES || track.dataOffset % 2 != 0
+					|| start + track.dataOffset + (uint64_t)track.keyCount * (1 + 3) * sizeof(uint16_t) > bytes)
+					return false;
+			}
+		}
+		return true;
+	}
+};
+
+// Compresses clips into a library, writes it to path (if given) and maps it back, then compares
+// every key of the source clips against the compressed samples. Prints the compression ratio and
+// the largest translation, rotation and scale error.
+inline bool runClipReport(const std::vector<AnimationClip>& clips, const ClipTolerance& tolerance, const std::string& path)
+{
+	std::vector<unsigned char> library = buildClipLibrary(clips, tolerance);
+
+	MappedFile mapped;
+	const unsigned char* data = library.data();
+	size_t size = library.size();
+	if (!path.empty()) {
+		std::ofstream file(path, std::ios::binary);
+		file.write((const char*)library.data(), library.size());
+		file.close();
+		if (!mapped.open(path))
+			return false;
+		data = mapped.data();
+		size = mapped.size();
+	}
+
+	ClipLibrary packed(data, size);
+	if (!packed.valid())
+		return false;
+
+	size_t rawBytes = 0;
+	size_t keys = 0, keptKeys = 0;
+	float translationError = 0.0f, rotationError = 0.0f, scaleError = 0.0f;
+	for (int c = 0; c < packed.clipCount(); c++) {
+		const AnimationClip& clip = clips[c];
+		CompressedClip compressed = packed.clip(c);
+		for (int t = 0; t < TRACK_COMPONENTS; t++) {
+			rawBytes += clip.tracks[t].size() * sizeof(float);
+		}
+		for (int j = 0; j < clip.jointCount; j++) {
+			for (int type = 0; type < PACKED_TRACK_TYPES; type++) {
+				keys += clip.keyCount;
+				keptKeys += compressed.track(j, type).keyCount;
+			}
+			for (int k = 0; k < clip.keyCount; k++) {
+				float time = k / clip.sampleRate;
+				JointTransform source = clip.sampleJoint(j, time);
+				JointTransform sampled = compressed.sampleJoint(j, time);
+				translationError = std::max(translationError, glm::length(source.translation - sampled.translation));
+				rotationError = std::max(rotationError, rotationErrorDegrees(source.rotation, sampled.rotation));
+				scaleError = std::max(scaleError, glm::length(source.scale - sampled.scale));
+			}
+		}
+	}
+
+	std::cout << "clip report: " << clips.size() << " clips, " << keptKeys << " of " << keys << " track keys kept" << std::endl;
+	std::cout << "  raw " << rawBytes << " bytes, compressed " << size << " bytes, ratio " << (double)rawBytes / (double)size << ":1" << std::endl;
+	std::cout << "  max error: translation " << translationError << ", rotation " << rotationError << " deg, scale " << scaleError << std::endl;
+	if (!path.empty())
+		std::cout << "  written to " << path << std::endl;
+	return true;
+}
+#endif
@@ -104,7 +104,6 @@ public:
 			Zoom = 45.0f;
 	}
 
-private:
 	// calculatoirs the front vector from cameras updated Euler Angles
 	void updateCameraVectors()
 	{
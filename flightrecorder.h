@@ -0,0 +1,96 @@
+#ifndef FLIGHTRECORDER_H
+#define FLIGHTRECORDER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "framereport.h"
+#include "profiler.h"
+
+const int FLIGHT_RECORDER_FRAMES = 512; // frames kept, also the frames needed before judging stutters
+const int FLIGHT_RECORDER_MEDIAN_INTERVAL = 32; // frames between median updates
+
+// Keeps the last FLIGHT_RECORDER_FRAMES complete frames. When a frame takes longer than
+// budget times the median frame, the history around it is written to stutter_<frame>.csv
+// once framesAfter more frames have come in, along with a profiler trace of the same frames.
+// Recording a frame is one copy into the ring, the median is only redone every few frames.
+class FlightRecorder
+{
+public:
+	float budget = 2.0f; // stutter threshold as a multiple of the median, 0 turns the recorder off
+	int framesAfter = 60;
+	int64_t dumps = 0;
+
+	void record(const FrameTimings& timings)
+	{
+		if (budget <= 0.0f)
+			return;
+		history[recorded % FLIGHT_RECORDER_FRAMES] = timings;
+		recorded++;
+		if (recorded % FLIGHT_RECORDER_MEDIAN_INTERVAL == 0)
+			updateMedian();
+
+		if (stutterFrame >= 0) {
+			if (timings.frame >= stutterFrame + framesAfter) {
+				dump();
+				quietUntil = timings.frame + FLIGHT_RECORDER_FRAMES; // one dump per stretch of bad frames
+				stutterFrame = -1;
+			}
+		}
+		else if (recorded >= FLIGHT_RECORDER_FRAMES && timings.frame >= quietUntil && timings.frameMs > budget * median) {
+			stutterFrame = timings.frame;
+			stutterMs = timings.frameMs;
+		}
+	}
+
+	float medianMs() const { return median; }
+
+private:
+	FrameTimings history[FLIGHT_RECORDER_FRAMES];
+	float sorted[FLIGHT_RECORDER_FRAMES];
+	int64_t recorded = 0;
+	float median = 0.0f;
+	int64_t stutterFrame = -1;
+	float stutterMs = 0.0f;
+	int64_t quietUntil = 0;
+
+	void updateMedian()
+	{
+		int count = (int)std::min<int64_t>(recorded, FLIGHT_RECORDER_FRAMES);
+		for (int i = 0; i < count; i++)
+			sorted[i] = history[i].frameMs;
+		std::nth_element(sorted, sorted + count / 2, sorted + count);
+		median = sorted[count / 2];
+	}
+
+	void dump()
+	{
+		std::string path = "stutter_" + std::to_string(stutterFrame) + ".csv";
+		std::ofstream file(path);
+		if (!file) {
+			std::cout << "ERROR::FLIGHTRECORDER::OPEN_FAILED: " << path << std::endl;
+			return;
+		}
+		file << "# frame " << stutterFrame << " took " << stutterMs << "ms, median " << median << "ms, budget " << budget << "x\n";
+		file << "frame,stutter,frame_ms,cpu_busy_ms,draws,triangles,upload_bytes";
+		for (int i = 0; i < RENDER_PASSES; i++)
+			file << "," << RENDER_PASS_NAMES[i] << "_cpu_ms," << RENDER_PASS_NAMES[i] << "_gpu_ms";
+		file << "\n";
+		int count = (int)std::min<int64_t>(recorded, FLIGHT_RECORDER_FRAMES);
+		for (int i = 0; i < count; i++) {
+			const FrameTimings& frame = history[(recorded - count + i) % FLIGHT_RECORDER_FRAMES];
+			file << frame.frame << "," << (frame.frame == stutterFrame ? 1 : 0) << "," << frame.frameMs << "," << frame.cpuBusyMs << ","
+				<< frame.stats.draws << "," << frame.stats.triangles << "," << frame.stats.uploadBytes;
+			for (int p = 0; p < RENDER_PASSES; p++)
+				file << "," << frame.cpuMs[p] << "," << frame.gpuMs[p];
+			file << "\n";
+		}
+		dumps++;
+		std::cout << "Stutter at frame " << stutterFrame << " (" << stutterMs << "ms, median " << median << "ms) written to " << path << std::endl;
+		PROFILE_REQUEST_DUMP();
+	}
+};
+#endif
@@ -0,0 +1,123 @@
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <new>
+#include <vector>
+
+// Linear allocator for memory that only lives for one frame. Allocating bumps a pointer,
+// nothing is freed on its own, reset() at the start of the next frame takes it all back.
+// When a frame needs more than the block holds the rest comes from the heap, and the
+// next reset grows the block so later frames fit without touching the heap again.
+class FrameArena
+{
+public:
+	explicit FrameArena(size_t bytes = 64 * 1024) { grow(bytes); }
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t))
+	{
+		size_t start = (offset + alignment - 1) & ~(alignment - 1);
+		if (start + bytes <= capacity) {
+			offset = start + bytes;
+			peak = std::max(peak, offset);
+			return block.get() + start;
+		}
+		// too big for this frame, take it from the heap and remember to grow
+		overflowBytes += bytes + alignment;
+		overflow.emplace_back(new unsigned char[bytes + alignment]);
+		uintptr_t address = (uintptr_t)overflow.back().get();
+		return (void*)((address + alignment - 1) & ~(uintptr_t)(alignment - 1));
+	}
+
+	template <typename T>
+	T* allocateArray(size_t count) { return (T*)allocate(count * sizeof(T), alignof(T)); }
+
+	// printf into the arena, the string lasts until the next reset
+	const char* format(const char* pattern, ...)
+	{
+		// written straight into the free space, written again elsewhere only if it did not fit
+		va_list args;
+		va_start(args, pattern);
+		char* text = (char*)block.get() + offset;
+		int length = std::vsnprintf(text, capacity - offset, pattern, args);
+		va_end(args);
+		if (length >= 0 && (size_t)length < capacity - offset) {
+			allocate(length + 1, 1);
+			return text;
+		}
+		va_start(args, pattern);
+		text = allocateArray<char>(length + 1);
+		std::vsnprintf(text, length + 1, pattern, args);
+		va_end(args);
+		return text;
+	}
+
+	void reset()
+	{
+		if (!overflow.empty()) {
+			grow((capacity + overflowBytes) * 2);
+			overflow.clear();
+			overflowBytes = 0;
+		}
+		offset = 0;
+	}
+
+	size_t used() const { return offset; }
+	size_t size() const { return capacity; }
+	size_t highWater() const { return peak; } // most any frame has used
+
+private:
+	std::unique_ptr<unsigned char[]> block;
+	size_t capacity = 0;
+	size_t offset = 0;
+	size_t peak = 0;
+	std::vector<std::unique_ptr<unsigned char[]>> overflow;
+	size_t overflowBytes = 0;
+
+	void grow(size_t bytes)
+	{
+		block.reset(new unsigned char[bytes]);
+		capacity = bytes;
+		overflow.reserve(16);
+	}
+};
+
+// the calling thread's arena, the main and render threads each reset theirs at the start of their frame
+inline FrameArena& frameArena()
+{
+	static thread_local FrameArena arena;
+	return arena;
+}
+
+// Standard allocator over frameArena(), for containers that are built and thrown away within a frame.
+// Deallocation does nothing, the memory comes back when the frame ends.
+template <typename T>
+class FrameAllocator
+{
+public:
+	typedef T value_type;
+
+	FrameAllocator() {}
+	template <typename U>
+	FrameAllocator(const FrameAllocator<U>&) {}
+
+	T* allocate(size_t count) { return frameArena().allocateArray<T>(count); }
+	void deallocate(T*, size_t) {}
+
+	template <typename U>
+	bool operator==(const FrameAllocator<U>&) const { return true; }
+	template <typename U>
+	bool operator!=(const FrameAllocator<U>&) const { return false; }
+};
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+#endif
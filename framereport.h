@@ -0,0 +1,128 @@
+#ifndef FRAMEREPORT_H
+#define FRAMEREPORT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+
+#include "renderstats.h"
+
+// the render passes of a frame, timed on both the cpu and the gpu
+enum RenderPass
+{
+	PassLamps,
+	PassFloor,
+	PassWalls,
+	PassTable,
+	PassWindows,
+	PassSkybox,
+	PassClouds,
+	PassHud,
+	RENDER_PASSES
+};
+
+const char* const RENDER_PASS_NAMES[RENDER_PASSES] = {
+	"lamps", "floor", "walls", "table", "windows", "skybox", "clouds", "hud"
+};
+
+struct FrameTimings
+{
+	int64_t frame = -1;
+	float frameMs = 0.0f; // start of this frame to the start of the next
+	float cpuBusyMs = 0.0f; // frame time minus waiting in swap buffers
+	float cpuMs[RENDER_PASSES] = {};
+	float gpuMs[RENDER_PASSES] = {}; // negative until the gpu timer reads the pass back
+	RenderStats stats;
+};
+
+// frames kept, gpu results arrive a few frames late so this must be more than GPU_TIMER_FRAMES
+const int FRAME_REPORT_HISTORY = 8;
+
+// Collects cpu and gpu pass times per frame. A frame is complete once its gpu
+// results had time to arrive, complete frames are averaged and printed once a second.
+class FrameReport
+{
+public:
+	bool printing = false;
+
+	void beginFrame(int64_t frame)
+	{
+		current = &history[frame % FRAME_REPORT_HISTORY];
+		*current = FrameTimings();
+		current->frame = frame;
+		for (int i = 0; i < RENDER_PASSES; i++)
+			current->gpuMs[i] = -1.0f;
+	}
+
+	void addCpu(RenderPass pass, float ms) { current->cpuMs[pass] += ms; }
+
+	void addGpu(int64_t frame, RenderPass pass, float ms)
+	{
+		FrameTimings& timings = history[frame % FRAME_REPORT_HISTORY];
+		if (timings.frame == frame)
+			timings.gpuMs[pass] = ms;
+	}
+
+	void endFrame(float frameMs, float cpuBusyMs, const RenderStats& stats)
+	{
+		current->frameMs = frameMs;
+		current->cpuBusyMs = cpuBusyMs;
+		current->stats = stats;
+
+		const FrameTimings& done = history[(current->frame + 1) % FRAME_REPORT_HISTORY];
+		if (done.frame >= 0 && done.frame == current->frame + 1 - FRAME_REPORT_HISTORY) {
+			lastComplete = &done;
+			accumulate(done);
+		}
+	}
+
+	// newest frame with its gpu times in, null for the first few frames
+	const FrameTimings* complete() const { return lastComplete; }
+
+	const FrameTimings& frame(int64_t frame) const { return history[frame % FRAME_REPORT_HISTORY]; }
+
+private:
+	FrameTimings history[FRAME_REPORT_HISTORY];
+	FrameTimings* current = &history[0];
+	const FrameTimings* lastComplete = nullptr;
+
+	struct Totals
+	{
+		int frames = 0;
+		double frameMs = 0.0, cpuBusyMs = 0.0;
+		double cpuMs[RENDER_PASSES] = {}, gpuMs[RENDER_PASSES] = {};
+	} totals;
+
+	void accumulate(const FrameTimings& timings)
+	{
+		totals.frames++;
+		totals.frameMs += timings.frameMs;
+		totals.cpuBusyMs += timings.cpuBusyMs;
+		for (int i = 0; i < RENDER_PASSES; i++) {
+			totals.cpuMs[i] += timings.cpuMs[i];
+			totals.gpuMs[i] += std::max(timings.gpuMs[i], 0.0f);
+		}
+		if (totals.frameMs >= 1000.0) {
+			if (printing)
+				print();
+			totals = Totals();
+		}
+	}
+
+	void print() const
+	{
+		int frames = totals.frames;
+		double gpuTotal = 0.0;
+		for (int i = 0; i < RENDER_PASSES; i++)
+			gpuTotal += totals.gpuMs[i];
+		std::cout << std::fixed << std::setprecision(3);
+		std::cout << "frame " << totals.frameMs / frames << "ms, cpu " << totals.cpuBusyMs / frames << "ms, gpu " << gpuTotal / frames << "ms ("
+			<< (gpuTotal > totals.cpuBusyMs ? "GPU" : "CPU") << " bound)" << std::endl;
+		for (int i = 0; i < RENDER_PASSES; i++) {
+			std::cout << "  " << std::setw(8) << RENDER_PASS_NAMES[i] << " cpu " << totals.cpuMs[i] / frames << "ms gpu " << totals.gpuMs[i] / frames << "ms" << std::endl;
+		}
+		std::cout << std::defaultfloat;
+	}
+};
+#endif
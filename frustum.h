@@ -0,0 +1,37 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+// The six planes of a view frustum, pointing inwards, taken straight from a
+// projection * view matrix (Gribb and Hartmann).
+struct Frustum
+{
+	glm::vec4 planes[6];
+
+	explicit Frustum(const glm::mat4& viewProjection)
+	{
+		glm::vec4 rows[4];
+		for (int i = 0; i < 4; i++)
+			rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+		planes[0] = rows[3] + rows[0]; // left
+		planes[1] = rows[3] - rows[0]; // right
+		planes[2] = rows[3] + rows[1]; // bottom
+		planes[3] = rows[3] - rows[1]; // top
+		planes[4] = rows[3] + rows[2]; // near
+		planes[5] = rows[3] - rows[2]; // far
+		for (glm::vec4& plane : planes)
+			plane /= glm::length(glm::vec3(plane));
+	}
+
+	// false only when the sphere is entirely outside one plane
+	bool intersectsSphere(const glm::vec3& center, float radius) const
+	{
+		for (const glm::vec4& plane : planes) {
+			if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+				return false;
+		}
+		return true;
+	}
+};
+#endif
@@ -0,0 +1,397 @@
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "mesh.h"
+#include "meshlod.h"
+
+// Spheres, capsules and cylinders at a few fixed subdivision levels. The tables they are
+// built from are worked out by the compiler, the shapes themselves once at startup.
+
+namespace geometry_tables {
+	constexpr double PI = 3.14159265358979323846;
+
+	constexpr double sine(double x)
+	{
+		while (x > PI)
+			x -= 2.0 * PI;
+		while (x < -PI)
+			x += 2.0 * PI;
+		double term = x, sum = x;
+		for (int n = 1; n < 14; n++) {
+			term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+			sum += term;
+		}
+		return sum;
+	}
+
+	constexpr double cosine(double x) { return sine(x + PI * 0.5); }
+
+	constexpr double root(double x)
+	{
+		double guess = x > 1.0 ? x : 1.0;
+		for (int i = 0; i < 64; i++)
+			guess = 0.5 * (guess + x / guess);
+		return guess;
+	}
+
+	// cos and sin of every step round a circle, the last repeats the first for the uv seam
+	template <int Segments>
+	struct RingTable
+	{
+		float cosines[Segments + 1];
+		float sines[Segments + 1];
+
+		constexpr RingTable() : cosines(), sines()
+		{
+			for (int i = 0; i <= Segments; i++) {
+				cosines[i] = (float)cosine(2.0 * PI * i / Segments);
+				sines[i] = (float)sine(2.0 * PI * i / Segments);
+			}
+		}
+	};
+
+	constexpr RingTable<8> RING_8;
+	constexpr RingTable<16> RING_16;
+	constexpr RingTable<32> RING_32;
+	constexpr RingTable<64> RING_64;
+
+	// the 12 corners of an icosahedron on the unit sphere
+	struct Icosahedron
+	{
+		float vertices[12][3];
+
+		constexpr Icosahedron() : vertices()
+		{
+			const double phi = (1.0 + root(5.0)) * 0.5;
+			const double length = root(1.0 + phi * phi);
+			const double corners[12][3] = {
+				{ -1, phi, 0 }, { 1, phi, 0 }, { -1, -phi, 0 }, { 1, -phi, 0 },
+				{ 0, -1, phi }, { 0, 1, phi }, { 0, -1, -phi }, { 0, 1, -phi },
+				{ phi, 0, -1 }, { phi, 0, 1 }, { -phi, 0, -1 }, { -phi, 0, 1 },
+			};
+			for (int v = 0; v < 12; v++) {
+				for (int i = 0; i < 3; i++)
+					vertices[v][i] = (float)(corners[v][i] / length);
+			}
+		}
+	};
+
+	constexpr Icosahedron ICOSAHEDRON;
+
+	// counter clockwise seen from outside
+	constexpr unsigned int ICOSAHEDRON_FACES[20][3] = {
+		{ 0, 11, 5 }, { 0, 5, 1 }, { 0, 1, 7 }, { 0, 7, 10 }, { 0, 10, 11 },
+		{ 1, 5, 9 }, { 5, 11, 4 }, { 11, 10, 2 }, { 10, 7, 6 }, { 7, 1, 8 },
+		{ 3, 9, 4 }, { 3, 4, 2 }, { 3, 2, 6 }, { 3, 6, 8 }, { 3, 8, 9 },
+		{ 4, 9, 5 }, { 2, 4, 11 }, { 6, 2, 10 }, { 8, 6, 7 }, { 9, 8, 1 },
+	};
+
+	// outward axis, then the two axes across each cube face, right handed so faces wind outwards
+	constexpr int CUBE_FACES[6][3][3] = {
+		{ { 1, 0, 0 }, { 0, 0, -1 }, { 0, 1, 0 } },
+		{ { -1, 0, 0 }, { 0, 0, 1 }, { 0, 1, 0 } },
+		{ { 0, 1, 0 }, { 1, 0, 0 }, { 0, 0, -1 } },
+		{ { 0, -1, 0 }, { 1, 0, 0 }, { 0, 0, 1 } },
+		{ { 0, 0, 1 }, { 1, 0, 0 }, { 0, 1, 0 } },
+		{ { 0, 0, -1 }, { -1, 0, 0 }, { 0, 1, 0 } },
+	};
+}
+
+// subdivision levels every shape takes, 0 the coarsest
+const int SHAPE_LEVELS = 4;
+
+// segments round the circle of the round shapes at each level
+constexpr int shapeSegments(int level) { return 8 << (level < 0 ? 0 : level >= SHAPE_LEVELS ? SHAPE_LEVELS - 1 : level); }
+constexpr unsigned int icosphereTriangles(int level) { return 20u << (2 * level); }
+
+struct ShapeRing
+{
+	int segments;
+	const float* cosines;
+	const float* sines;
+};
+
+inline ShapeRing shapeRing(int level)
+{
+	using namespace geometry_tables;
+	switch (shapeSegments(level)) {
+	case 8: return { 8, RING_8.cosines, RING_8.sines };
+	case 16: return { 16, RING_16.cosines, RING_16.sines };
+	case 32: return { 32, RING_32.cosines, RING_32.sines };
+	}
+	return { 64, RING_64.cosines, RING_64.sines };
+}
+
+inline void addShapeVertex(MeshData& mesh, const glm::vec3& position, const glm::vec3& normal, const glm::vec2& uv)
+{
+	const float vertex[MESH_VERTEX_FLOATS] = { position.x, position.y, position.z, normal.x, normal.y, normal.z, uv.x, uv.y };
+	mesh.vertices.insert(mesh.vertices.end(), vertex, vertex + MESH_VERTEX_FLOATS);
+}
+
+// The texture coords makeUVSphere gives, u round from +z and v from the bottom, so textures
+// drawn for it fit. A triangle across the seam gets copies of its low u vertices one
+// texture further on (textures repeat), and a pole vertex one copy per triangle under the
+// middle of its other two.
+inline void sphericalTextureCoords(MeshData& mesh)
+{
+	const float pi = (float)geometry_tables::PI;
+	unsigned int count = mesh.vertexCount();
+	for (unsigned int v = 0; v < count; v++) {
+		float* vertex = &mesh.vertices[(size_t)v * MESH_VERTEX_FLOATS];
+		glm::vec3 n = glm::normalize(glm::vec3(vertex[3], vertex[4], vertex[5]));
+		float u = std::atan2(n.x, n.z) / (2.0f * pi);
+		vertex[6] = u < 0.0f ? u + 1.0f : u;
+		vertex[7] = std::asin(glm::clamp(n.y, -1.0f, 1.0f)) / pi + 0.5f;
+	}
+	auto copyWithU = [&](unsigned int v, float u) {
+		float vertex[MESH_VERTEX_FLOATS];
+		std::copy(mesh.vertices.begin() + (size_t)v * MESH_VERTEX_FLOATS, mesh.vertices.begin() + (size_t)(v + 1) * MESH_VERTEX_FLOATS, vertex);
+		vertex[6] = u;
+		mesh.vertices.insert(mesh.vertices.end(), vertex, vertex + MESH_VERTEX_FLOATS);
+		return mesh.vertexCount() - 1;
+	};
+	std::unordered_map<unsigned int, unsigned int> shifted; // vertex to its copy one texture on
+	auto uOf = [&](unsigned int v) { return mesh.vertices[(size_t)v * MESH_VERTEX_FLOATS + 6]; };
+	auto isPole = [&](unsigned int v) { return std::fabs(mesh.vertices[(size_t)v * MESH_VERTEX_FLOATS + 4]) > 0.99999f; };
+	for (size_t t = 0; t + 2 < mesh.indices.size(); t += 3) {
+		unsigned int* corner = &mesh.indices[t];
+		float low = 2.0f, high = -1.0f;
+		for (int k = 0; k < 3; k++) {
+			if (isPole(corner[k]))
+				continue;
+			low = glm::min(low, uOf(corner[k]));
+			high = glm::max(high, uOf(corner[k]));
+		}
+		if (high - low > 0.5f) {
+			for (int k = 0; k < 3; k++) {
+				if (isPole(corner[k]) || uOf(corner[k]) >= 0.5f)
+					continue;
+				auto found = shifted.find(corner[k]);
+				if (found == shifted.end())
+					found = shifted.emplace(corner[k], copyWithU(corner[k], uOf(corner[k]) + 1.0f)).first;
+				corner[k] = found->second;
+			}
+		}
+		for (int k = 0; k < 3; k++) {
+			if (isPole(corner[k]))
+				corner[k] = copyWithU(corner[k], (uOf(corner[(k + 1) % 3]) + uOf(corner[(k + 2) % 3])) * 0.5f);
+		}
+	}
+}
+
+// Icosahedron split level times, every edge halved and pushed out to the sphere, so every
+// triangle is close to the same size. 20 * 4^level triangles.
+inline MeshData makeIcosphere(int level, float radius = 0.5f)
+{
+	using namespace geometry_tables;
+	std::vector<glm::vec3> points;
+	std::vector<unsigned int> triangles;
+	points.reserve(10 * ((size_t)1 << (2 * level)) + 2);
+	for (const float* v : ICOSAHEDRON.vertices)
+		points.push_back(glm::vec3(v[0], v[1], v[2]));
+	for (const unsigned int* face : ICOSAHEDRON_FACES)
+		triangles.insert(triangles.end(), face, face + 3);
+
+	for (int pass = 0; pass < level; pass++) {
+		std::unordered_map<uint64_t, unsigned int> midpoints;
+		std::vector<unsigned int> split;
+		split.reserve(triangles.size() * 4);
+		auto midpoint = [&](unsigned int a, unsigned int b) {
+			uint64_t key = a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+			auto found = midpoints.find(key);
+			if (found != midpoints.end())
+				return found->second;
+			points.push_back(glm::normalize(points[a] + points[b]));
+			unsigned int index = (unsigned int)points.size() - 1;
+			midpoints.emplace(key, index);
+			return index;
+		};
+		for (size_t t = 0; t < triangles.size(); t += 3) {
+			unsigned int a = triangles[t], b = triangles[t + 1], c = triangles[t + 2];
+			unsigned int ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+			const unsigned int children[12] = { a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca };
+			split.insert(split.end(), children, children + 12);
+		}
+		triangles.swap(split);
+	}
+
+	MeshData mesh;
+	mesh.vertices.reserve(points.size() * MESH_VERTEX_FLOATS);
+	for (const glm::vec3& point : points)
+		addShapeVertex(mesh, point * radius, point, glm::vec2(0.0f));
+	mesh.indices = triangles;
+	sphericalTextureCoords(mesh);
+	return mesh;
+}
+
+// Cube with each face a grid pushed out to the sphere, shapeSegments(level) / 2 squares a
+// side. The mapping spreads the grid evenly instead of bunching it at the face middles.
+inline MeshData makeCubeSphere(int level, float radius = 0.5f)
+{
+	using namespace geometry_tables;
+	int squares = shapeSegments(level) / 2;
+	MeshData mesh;
+	for (const auto& face : CUBE_FACES) {
+		glm::vec3 out((float)face[0][0], (float)face[0][1], (float)face[0][2]);
+		glm::vec3 right((float)face[1][0], (float)face[1][1], (float)face[1][2]);
+		glm::vec3 up((float)face[2][0], (float)face[2][1], (float)face[2][2]);
+		unsigned int first = mesh.vertexCount();
+		for (int j = 0; j <= squares; j++) {
+			for (int i = 0; i <= squares; i++) {
+				glm::vec3 p = out + right * (2.0f * i / squares - 1.0f) + up * (2.0f * j / squares - 1.0f);
+				glm::vec3 p2 = p * p;
+				glm::vec3 n(p.x * std::sqrt(1.0f - p2.y * 0.5f - p2.z * 0.5f + p2.y * p2.z / 3.0f),
+					p.y * std::sqrt(1.0f - p2.z * 0.5f - p2.x * 0.5f + p2.z * p2.x / 3.0f),
+					p.z * std::sqrt(1.0f - p2.x * 0.5f - p2.y * 0.5f + p2.x * p2.y / 3.0f));
+				n = glm::normalize(n);
+				addShapeVertex(mesh, n * radius, n, glm::vec2(0.0f));
+			}
+		}
+		for (int j = 0; j < squares; j++) {
+			for (int i = 0; i < squares; i++) {
+				unsigned int a = first + j * (squares + 1) + i, b = a + 1, c = a + squares + 1, d = c + 1;
+				const unsigned int quad[6] = { a, b, d, a, d, c };
+				mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+			}
+		}
+	}
+	sphericalTextureCoords(mesh);
+	return mesh;
+}
+
+// rings of a tube round y from bottom to top, each ring.segments long with the seam vertex
+// doubled for the texture, joined by quads
+inline void addShapeRings(MeshData& mesh, const ShapeRing& ring, const float* heights, const float* radii, const float* normalY, const float* v,
+	int ringCount)
+{
+	unsigned int first = mesh.vertexCount();
+	for (int r = 0; r < ringCount; r++) {
+		float across = std::sqrt(glm::max(0.0f, 1.0f - normalY[r] * normalY[r]));
+		for (int s = 0; s <= ring.segments; s++) {
+			glm::vec3 direction(ring.sines[s], 0.0f, ring.cosines[s]);
+			glm::vec3 position = direction * radii[r] + glm::vec3(0.0f, heights[r], 0.0f);
+			glm::vec3 normal = direction * across + glm::vec3(0.0f, normalY[r], 0.0f);
+			addShapeVertex(mesh, position, normal, glm::vec2((float)s / ring.segments, v[r]));
+		}
+	}
+	for (int r = 0; r + 1 < ringCount; r++) {
+		for (int s = 0; s < ring.segments; s++) {
+			unsigned int a = first + r * (ring.segments + 1) + s, b = a + 1, c = a + ring.segments + 1, d = c + 1;
+			// a ring of radius 0 is a pole, only one triangle of the quad has any area
+			if (radii[r] > 0.0f) {
+				const unsigned int lower[3] = { a, b, d };
+				mesh.indices.insert(mesh.indices.end(), lower, lower + 3);
+			}
+			if (radii[r + 1] > 0.0f) {
+				const unsigned int upper[3] = { a, d, c };
+				mesh.indices.insert(mesh.indices.end(), upper, upper + 3);
+			}
+		}
+	}
+}
+
+// Cylinder round y, centred on the origin, with flat caps.
+inline MeshData makeCylinder(int level, float radius = 0.5f, float height = 1.0f)
+{
+	ShapeRing ring = shapeRing(level);
+	MeshData mesh;
+	const float heights[2] = { -height * 0.5f, height * 0.5f };
+	const float radii[2] = { radius, radius };
+	const float normalY[2] = { 0.0f, 0.0f };
+	const float v[2] = { 0.0f, 1.0f };
+	addShapeRings(mesh, ring, heights, radii, normalY, v, 2);
+	for (int cap = 0; cap < 2; cap++) {
+		float y = cap == 0 ? -height * 0.5f : height * 0.5f;
+		float facing = cap == 0 ? -1.0f : 1.0f;
+		unsigned int centre = mesh.vertexCount();
+		addShapeVertex(mesh, glm::vec3(0.0f, y, 0.0f), glm::vec3(0.0f, facing, 0.0f), glm::vec2(0.5f));
+		for (int s = 0; s <= ring.segments; s++) {
+			glm::vec2 d(ring.sines[s], ring.cosines[s]);
+			addShapeVertex(mesh, glm::vec3(d.x * radius, y, d.y * radius), glm::vec3(0.0f, facing, 0.0f), d * 0.5f + 0.5f);
+		}
+		for (int s = 0; s < ring.segments; s++) {
+			unsigned int a = centre + 1 + s, b = a + 1;
+			const unsigned int fan[3] = { centre, cap == 0 ? b : a, cap == 0 ? a : b };
+			mesh.indices.insert(mesh.indices.end(), fan, fan + 3);
+		}
+	}
+	return mesh;
+}
+
+// Cylinder round y with a hemisphere on each end, height between the hemisphere centres.
+// Rings and texture v follow the surface so texels stay the same size all over.
+inline MeshData makeCapsule(int level, float radius = 0.5f, float height = 1.0f)
+{
+	ShapeRing ring = shapeRing(level);
+	int quarter = ring.segments / 4; // rings from a pole to the equator
+	float arc = (float)(geometry_tables::PI * 0.5) * radius;
+	std::vector<float> heights, radii, normalY, v;
+	for (int side = 0; side < 2; side++) {
+		for (int r = 0; r <= quarter; r++) {
+			// bottom hemisphere from its pole up, then the top one from its equator up
+			float angle = (float)(geometry_tables::PI * 0.5) * (side == 0 ? r : quarter - r) / quarter;
+			float y = side == 0 ? -std::cos(angle) : std::cos(angle);
+			heights.push_back(y * radius + (side == 0 ? -height : height) * 0.5f);
+			radii.push_back(std::sin(angle) * radius);
+			normalY.push_back(y);
+			v.push_back((side * (arc + height) + arc * r / quarter) / (2.0f * arc + height));
+		}
+	}
+	MeshData mesh;
+	addShapeRings(mesh, ring, heights.data(), radii.data(), normalY.data(), v.data(), (int)heights.size());
+	return mesh;
+}
+
+// furthest a flat triangle of a sphere mesh sinks below the true surface
+inline float sphereFacetError(const MeshData& mesh, float radius)
+{
+	float nearest = radius;
+	for (size_t t = 0; t + 2 < mesh.indices.size(); t += 3) {
+		glm::vec3 p[3];
+		for (int k = 0; k < 3; k++)
+			p[k] = glm::vec3(mesh.vertices[(size_t)mesh.indices[t + k] * MESH_VERTEX_FLOATS], mesh.vertices[(size_t)mesh.indices[t + k] * MESH_VERTEX_FLOATS + 1],
+				mesh.vertices[(size_t)mesh.indices[t + k] * MESH_VERTEX_FLOATS + 2]);
+		glm::vec3 normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+		if (glm::length(normal) > 0.0f)
+			nearest = glm::min(nearest, std::fabs(glm::dot(glm::normalize(normal), p[0])));
+	}
+	return radius - nearest;
+}
+
+// Levels of a shape as one LOD chain (meshlod.h), finest first. Each level keeps its own
+// vertices in the shared buffer, errors are in mesh units like simplified chains.
+inline MeshLodChain shapeLodChain(const MeshData* levels, const float* errors, int count)
+{
+	MeshLodChain chain;
+	for (int l = 0; l < count && l < MAX_MESH_LODS; l++) {
+		unsigned int base = chain.mesh.vertexCount();
+		chain.lods[l] = { (unsigned int)chain.mesh.indices.size(), (unsigned int)levels[l].indices.size(), errors[l] };
+		chain.mesh.vertices.insert(chain.mesh.vertices.end(), levels[l].vertices.begin(), levels[l].vertices.end());
+		for (unsigned int index : levels[l].indices)
+			chain.mesh.indices.push_back(base + index);
+		chain.lodCount = l + 1;
+	}
+	return chain;
+}
+
+// count icosphere levels, the first split finest times and each after it once less. Errors
+// are each level's distance from the true sphere, the first counts as exact.
+inline MeshLodChain icosphereLodChain(int finest, int count, float radius = 0.5f)
+{
+	std::vector<MeshData> levels;
+	std::vector<float> errors;
+	for (int l = 0; l < count && finest - l >= 0; l++) {
+		levels.push_back(makeIcosphere(finest - l, radius));
+		errors.push_back(l == 0 ? 0.0f : sphereFacetError(levels.back(), radius));
+	}
+	return shapeLodChain(levels.data(), errors.data(), (int)levels.size());
+}
+#endif
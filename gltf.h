@@ -0,0 +1,553 @@
+#ifndef GLTF_H
+#define GLTF_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "json.h"
+#include "mappedfile.h"
+#include "renderstats.h"
+
+const uint32_t GLB_MAGIC = 0x46546C67; // "glTF"
+const uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+const uint32_t GLB_CHUNK_BIN = 0x004E4942;
+
+// vertex attributes read from a primitive, at the locations room.vert uses
+enum GltfAttribute {
+	GltfPosition,
+	GltfNormal,
+	GltfTexCoord,
+	GltfTangent,
+	GLTF_ATTRIBUTE_COUNT
+};
+
+struct GltfView {
+	uint32_t offset; // into the BIN chunk
+	uint32_t length;
+	uint32_t stride; // 0 when tightly packed
+	GLuint buffer; // 0 until upload, and for views no primitive reads
+};
+
+struct GltfAccessor {
+	int view;
+	uint32_t offset; // into the view
+	GLenum componentType;
+	int components;
+	uint32_t count;
+	bool normalized;
+	bool hasBounds;
+	glm::vec3 min;
+	glm::vec3 max;
+};
+
+struct GltfPrimitive {
+	int attributes[GLTF_ATTRIBUTE_COUNT]; // accessors, -1 if missing
+	int indices; // accessor, -1 to draw the vertices in order
+	int material; // -1 for none
+	GLenum indexType;
+	uint32_t count; // indices, or vertices when there are none
+	uint32_t indexOffset; // bytes into the index buffer
+	GLuint vertexArray;
+};
+
+struct GltfMesh {
+	int firstPrimitive;
+	int primitiveCount;
+};
+
+struct GltfMaterial {
+	int diffuseImage; // base colour, -1 for none
+	int specularImage; // KHR_materials_specular, -1 for none
+};
+
+struct GltfImage {
+	int view; // -1 when the image is a file next to the model
+	std::string uri;
+};
+
+// a mesh placed by a node of the scene
+struct GltfInstance {
+	int mesh;
+	glm::mat4 transform;
+};
+
+// A glTF 2.0 binary mapped from disk. Opening parses the JSON chunk and checks every view
+// and accessor against the BIN chunk, and every index against its vertices. upload() then
+// hands each view straight from the mapping to glBufferData, so vertex data is never
+// copied or converted on the cpu. Buffers must be the GLB's own BIN chunk, primitives
+// need POSITION and NORMAL, and points and lines are skipped.
+class GltfModel
+{
+public:
+	bool open(const std::string& path)
+	{
+		this->path = path;
+		views.clear();
+		accessors.clear();
+		primitives.clear();
+		meshes.clear();
+		materials.clear();
+		images.clear();
+		instances.clear();
+		bin = nullptr;
+		binSize = 0;
+		if (!file.open(path))
+			return false;
+		if (!readContainer() || !readViews() || !readAccessors() || !readImages() || !readMaterials() || !readMeshes() || !readScene()) {
+			file.close();
+			return false;
+		}
+		return true;
+	}
+
+	// one gl buffer per view a primitive reads, one vertex array per primitive
+	void upload()
+	{
+		std::vector<bool> used(views.size(), false);
+		for (const GltfPrimitive& primitive : primitives) {
+			for (int attribute : primitive.attributes) {
+				if (attribute >= 0)
+					used[accessors[attribute].view] = true;
+			}
+			if (primitive.indices >= 0)
+				used[accessors[primitive.indices].view] = true;
+		}
+		uploadedBytes = 0;
+		for (size_t i = 0; i < views.size(); i++) {
+			if (!used[i])
+				continue; // images and anything else the gpu never reads
+			// buffers have no type, so index views go through GL_ARRAY_BUFFER too
+			glGenBuffers(1, &views[i].buffer);
+			glBindBuffer(GL_ARRAY_BUFFER, views[i].buffer);
+			glBufferData(GL_ARRAY_BUFFER, views[i].length, bin + views[i].offset, GL_STATIC_DRAW);
+			uploadedBytes += views[i].length;
+		}
+		countUpload(uploadedBytes);
+		countBufferMemory(uploadedBytes);
+
+		static const GLuint locations[GLTF_ATTRIBUTE_COUNT] = { 0, 1, 2, 4 };
+		for (GltfPrimitive& primitive : primitives) {
+			glGenVertexArrays(1, &primitive.vertexArray);
+			glBindVertexArray(primitive.vertexArray);
+			for (int a = 0; a < GLTF_ATTRIBUTE_COUNT; a++) {
+				if (primitive.attributes[a] < 0)
+					continue;
+				const GltfAccessor& accessor = accessors[primitive.attributes[a]];
+				const GltfView& view = views[accessor.view];
+				glBindBuffer(GL_ARRAY_BUFFER, view.buffer);
+				glEnableVertexAttribArray(locations[a]);
+				glVertexAttribPointer(locations[a], accessor.components, accessor.componentType, accessor.normalized ? GL_TRUE : GL_FALSE,
+					view.stride, (void*)(uintptr_t)accessor.offset);
+			}
+			if (primitive.indices >= 0)
+				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, views[accessors[primitive.indices].view].buffer);
+			glBindVertexArray(0);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	bool isOpen() const { return file.isOpen(); }
+	const std::vector<GltfPrimitive>& primitiveList() const { return primitives; }
+	const std::vector<GltfMesh>& meshList() const { return meshes; }
+	const std::vector<GltfMaterial>& materialList() const { return materials; }
+	const std::vector<GltfInstance>& instanceList() const { return instances; }
+	size_t imageCount() const { return images.size(); }
+	int64_t uploaded() const { return uploadedBytes; }
+	size_t size() const { return file.size(); }
+
+	// encoded bytes of an image stored in the BIN chunk, false if it is a separate file
+	bool imageBytes(int image, const unsigned char*& data, size_t& size) const
+	{
+		if (images[image].view < 0)
+			return false;
+		data = bin + views[images[image].view].offset;
+		size = views[images[image].view].length;
+		return true;
+	}
+
+	// path of an image stored as a file, relative to the model, empty if there is none
+	std::string imagePath(int image) const
+	{
+		const std::string& uri = images[image].uri;
+		if (uri.empty() || uri.compare(0, 5, "data:") == 0)
+			return std::string(); // base64 images are not worth decoding here, use the BIN chunk
+		size_t slash = path.find_last_of("/\\");
+		return slash == std::string::npos ? uri : path.substr(0, slash + 1) + uri;
+	}
+
+	// bounds of every instance in model space
+	void bounds(glm::vec3& low, glm::vec3& high) const
+	{
+		bool first = true;
+		low = high = glm::vec3(0.0f);
+		for (const GltfInstance& instance : instances) {
+			const GltfMesh& mesh = meshes[instance.mesh];
+			for (int p = mesh.firstPrimitive; p < mesh.firstPrimitive + mesh.primitiveCount; p++) {
+				const GltfAccessor& position = accessors[primitives[p].attributes[GltfPosition]];
+				for (int corner = 0; corner < 8; corner++) {
+					glm::vec3 local((corner & 1) ? position.max.x : position.min.x, (corner & 2) ? position.max.y : position.min.y,
+						(corner & 4) ? position.max.z : position.min.z);
+					glm::vec3 point = glm::vec3(instance.transform * glm::vec4(local, 1.0f));
+					low = first ? point : glm::min(low, point);
+					high = first ? point : glm::max(high, point);
+					first = false;
+				}
+			}
+		}
+	}
+
+private:
+	std::string path;
+	MappedFile file;
+	JsonDocument json;
+	const unsigned char* bin = nullptr;
+	size_t binSize = 0;
+	int64_t uploadedBytes = 0;
+	std::vector<GltfView> views;
+	std::vector<GltfAccessor> accessors;
+	std::vector<GltfPrimitive> primitives;
+	std::vector<GltfMesh> meshes;
+	std::vector<GltfMaterial> materials;
+	std::vector<GltfImage> images;
+	std::vector<GltfInstance> instances;
+
+	bool fail(const char* reason) const
+	{
+		std::cout << "ERROR::GLTF::INVALID_DATA: " << path << " " << reason << std::endl;
+		return false;
+	}
+
+	static uint32_t readU32(const unsigned char* at)
+	{
+		uint32_t value;
+		std::memcpy(&value, at, sizeof(value));
+		return value;
+	}
+
+	static int componentSize(GLenum type)
+	{
+		switch (type) {
+		case GL_BYTE: case GL_UNSIGNED_BYTE: return 1;
+		case GL_SHORT: case GL_UNSIGNED_SHORT: return 2;
+		case GL_UNSIGNED_INT: case GL_FLOAT: return 4;
+		default: return 0;
+		}
+	}
+
+	int componentCount(int node) const
+	{
+		static const char* names[] = { "SCALAR", "VEC2", "VEC3", "VEC4", "MAT2", "MAT3", "MAT4" };
+		static const int counts[] = { 1, 2, 3, 4, 4, 9, 16 };
+		for (int i = 0; i < 7; i++) {
+			if (json.equals(node, names[i]))
+				return counts[i];
+		}
+		return 0;
+	}
+
+	// header, JSON chunk and the optional BIN chunk, each 4 byte aligned
+	bool readContainer()
+	{
+		const unsigned char* bytes = file.data();
+		if (file.size() < 20)
+			return fail("too small for a glb header");
+		uint32_t length = readU32(bytes + 8);
+		if (readU32(bytes) != GLB_MAGIC || readU32(bytes + 4) != 2)
+			return fail("not a version 2 glb");
+		if (length > file.size())
+			return fail("truncated");
+		uint32_t jsonLength = readU32(bytes + 12);
+		if (readU32(bytes + 16) != GLB_CHUNK_JSON || 20 + (uint64_t)jsonLength > length)
+			return fail("first chunk is not JSON");
+		uint64_t binChunk = 20 + (((uint64_t)jsonLength + 3) & ~(uint64_t)3);
+		if (binChunk + 8 <= length && readU32(bytes + binChunk + 4) == GLB_CHUNK_BIN) {
+			uint32_t binLength = readU32(bytes + binChunk);
+			if (binChunk + 8 + binLength > length)
+				return fail("BIN chunk runs past the end");
+			bin = bytes + binChunk + 8;
+			binSize = binLength;
+		}
+		if (!json.parse((const char*)bytes + 20, jsonLength))
+			return fail("JSON syntax error");
+		std::string version = json.string(json.member(json.member(json.root(), "asset"), "version"));
+		if (version.compare(0, 2, "2.") != 0)
+			return fail("asset version is not 2.x");
+		return true;
+	}
+
+	bool readViews()
+	{
+		std::vector<int> buffers = json.elements(json.member(json.root(), "buffers"));
+		if (buffers.size() > 1 || (buffers.size() == 1 && json.member(buffers[0], "uri") >= 0))
+			return fail("only the BIN chunk is supported as a buffer");
+		for (int node : json.elements(json.member(json.root(), "bufferViews"))) {
+			GltfView view = {};
+			double offset = json.number(json.member(node, "byteOffset"), 0.0);
+			double length = json.number(json.member(node, "byteLength"), -1.0);
+			double stride = json.number(json.member(node, "byteStride"), 0.0);
+			if (json.integer(json.member(node, "buffer"), -1) != 0 || offset < 0.0 || length < 0.0 || offset + length > (double)binSize)
+				return fail("buffer view outside the BIN chunk");
+			if (stride != 0.0 && (stride < 4.0 || stride > 252.0 || (int)stride % 4 != 0))
+				return fail("buffer view stride");
+			view.offset = (uint32_t)offset;
+			view.length = (uint32_t)length;
+			view.stride = (uint32_t)stride;
+			views.push_back(view);
+		}
+		return true;
+	}
+
+	// every accessor has to fit its view, whether a primitive reads it or not
+	bool readAccessors()
+	{
+		for (int node : json.elements(json.member(json.root(), "accessors"))) {
+			GltfAccessor accessor = {};
+			accessor.view = json.integer(json.member(node, "bufferView"), -1);
+			double offset = json.number(json.member(node, "byteOffset"), 0.0);
+			double count = json.number(json.member(node, "count"), 0.0);
+			accessor.componentType = (GLenum)json.integer(json.member(node, "componentType"), 0);
+			accessor.components = componentCount(json.member(node, "type"));
+			accessor.normalized = json.boolean(json.member(node, "normalized"), false);
+			if (accessor.view < 0 || accessor.view >= (int)views.size() || json.member(node, "sparse") >= 0)
+				return fail("accessor without a buffer view, or sparse");
+			int size = componentSize(accessor.componentType);
+			if (size == 0 || accessor.components == 0 || count < 1.0 || count > 4294967295.0 || offset < 0.0 || offset > 4294967295.0
+				|| (int64_t)offset % size != 0)
+				return fail("accessor type, count or alignment");
+			accessor.offset = (uint32_t)offset;
+			accessor.count = (uint32_t)count;
+			const GltfView& view = views[accessor.view];
+			uint64_t element = (uint64_t)size * accessor.components;
+			uint64_t stride = view.stride != 0 ? view.stride : element;
+			if (stride < element || stride % size != 0 || accessor.offset + stride * (accessor.count - 1) + element > view.length)
+				return fail("accessor runs past its buffer view");
+			int min = json.member(node, "min");
+			int max = json.member(node, "max");
+			accessor.hasBounds = json.count(min) == 3 && json.count(max) == 3;
+			if (accessor.hasBounds) {
+				for (int i = 0, a = json.first(min), b = json.first(max); i < 3; i++, a = json.next(a), b = json.next(b)) {
+					accessor.min[i] = (float)json.number(a, 0.0);
+					accessor.max[i] = (float)json.number(b, 0.0);
+				}
+			}
+			accessors.push_back(accessor);
+		}
+		return true;
+	}
+
+	bool readImages()
+	{
+		for (int node : json.elements(json.member(json.root(), "images"))) {
+			GltfImage image;
+			image.view = json.integer(json.member(node, "bufferView"), -1);
+			image.uri = json.string(json.member(node, "uri"));
+			if (image.view >= (int)views.size())
+				return fail("image buffer view");
+			images.push_back(image);
+		}
+		return true;
+	}
+
+	// image of a texture reference such as baseColorTexture, -1 if there is none
+	int textureImage(int reference) const
+	{
+		std::vector<int> textures = json.elements(json.member(json.root(), "textures"));
+		int texture = json.integer(json.member(reference, "index"), -1);
+		if (texture < 0 || texture >= (int)textures.size())
+			return -1;
+		int image = json.integer(json.member(textures[texture], "source"), -1);
+		return image < (int)images.size() ? image : -1;
+	}
+
+	bool readMaterials()
+	{
+		for (int node : json.elements(json.member(json.root(), "materials"))) {
+			GltfMaterial material;
+			material.diffuseImage = textureImage(json.member(json.member(node, "pbrMetallicRoughness"), "baseColorTexture"));
+			int specular = json.member(json.member(node, "extensions"), "KHR_materials_specular");
+			material.specularImage = textureImage(json.member(specular, "specularColorTexture"));
+			if (material.specularImage < 0)
+				material.specularImage = textureImage(json.member(specular, "specularTexture"));
+			materials.push_back(material);
+		}
+		return true;
+	}
+
+	bool checkAttribute(int accessor, int components, bool allowNormalized) const
+	{
+		if (accessor < 0 || accessor >= (int)accessors.size())
+			return false;
+		const GltfAccessor& a = accessors[accessor];
+		if (a.components != components)
+			return false;
+		return a.componentType == GL_FLOAT
+			|| (allowNormalized && a.normalized && (a.componentType == GL_UNSIGNED_BYTE || a.componentType == GL_UNSIGNED_SHORT));
+	}
+
+	template <typename T>
+	bool indicesInRange(const GltfAccessor& accessor, uint32_t vertexCount) const
+	{
+		const T* index = (const T*)(bin + views[accessor.view].offset + accessor.offset);
+		for (uint32_t i = 0; i < accessor.count; i++) {
+			if (index[i] >= vertexCount)
+				return false;
+		}
+		return true;
+	}
+
+	bool readMeshes()
+	{
+		static const char* names[GLTF_ATTRIBUTE_COUNT] = { "POSITION", "NORMAL", "TEXCOORD_0", "TANGENT" };
+		static const int components[GLTF_ATTRIBUTE_COUNT] = { 3, 3, 2, 4 };
+		for (int node : json.elements(json.member(json.root(), "meshes"))) {
+			GltfMesh mesh;
+			mesh.firstPrimitive = (int)primitives.size();
+			for (int source : json.elements(json.member(node, "primitives"))) {
+				if (json.integer(json.member(source, "mode"), 4) != 4) {
+					std::cout << "glTF primitive that is not triangles skipped in " << path << std::endl;
+					continue;
+				}
+				GltfPrimitive primitive = {};
+				int attributes = json.member(source, "attributes");
+				for (int a = 0; a < GLTF_ATTRIBUTE_COUNT; a++) {
+					int member = json.member(attributes, names[a]);
+					primitive.attributes[a] = member < 0 ? -1 : json.integer(member, -1);
+					if (member >= 0 && !checkAttribute(primitive.attributes[a], components[a], a == GltfTexCoord))
+						return fail("vertex attribute type");
+				}
+				if (primitive.attributes[GltfPosition] < 0 || primitive.attributes[GltfNormal] < 0)
+					return fail("primitive without POSITION or NORMAL");
+				const GltfAccessor& position = accessors[primitive.attributes[GltfPosition]];
+				if (!position.hasBounds)
+					return fail("POSITION without min and max");
+				for (int attribute : primitive.attributes) {
+					if (attribute >= 0 && accessors[attribute].count != position.count)
+						return fail("vertex attributes of different counts");
+				}
+
+				primitive.count = position.count;
+				primitive.indices = -1;
+				int indices = json.member(source, "indices");
+				if (indices >= 0) {
+					primitive.indices = json.integer(indices, -1);
+					if (primitive.indices < 0 || primitive.indices >= (int)accessors.size())
+						return fail("index accessor");
+					const GltfAccessor& index = accessors[primitive.indices];
+					bool inRange = false;
+					if (index.components == 1 && views[index.view].stride == 0) {
+						if (index.componentType == GL_UNSIGNED_BYTE)
+							inRange = indicesInRange<uint8_t>(index, position.count);
+						else if (index.componentType == GL_UNSIGNED_SHORT)
+							inRange = indicesInRange<uint16_t>(index, position.count);
+						else if (index.componentType == GL_UNSIGNED_INT)
+							inRange = indicesInRange<uint32_t>(index, position.count);
+					}
+					if (!inRange)
+						return fail("indices of the wrong type or out of range");
+					primitive.indexType = index.componentType;
+					primitive.count = index.count;
+					primitive.indexOffset = index.offset;
+				}
+				primitive.material = json.integer(json.member(source, "material"), -1);
+				if (primitive.material >= (int)materials.size())
+					return fail("material index");
+				primitives.push_back(primitive);
+			}
+			mesh.primitiveCount = (int)primitives.size() - mesh.firstPrimitive;
+			meshes.push_back(mesh);
+		}
+		return true;
+	}
+
+	glm::mat4 localTransform(int node) const
+	{
+		int matrix = json.member(node, "matrix");
+		if (json.count(matrix) == 16) {
+			float values[16];
+			int i = 0;
+			for (int at = json.first(matrix); at >= 0; at = json.next(at))
+				values[i++] = (float)json.number(at, 0.0);
+			return glm::make_mat4(values); // column major, as glm stores it
+		}
+		float t[3] = { 0.0f, 0.0f, 0.0f };
+		float r[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		float s[3] = { 1.0f, 1.0f, 1.0f };
+		readNumbers(json.member(node, "translation"), t, 3);
+		readNumbers(json.member(node, "rotation"), r, 4);
+		readNumbers(json.member(node, "scale"), s, 3);
+		glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(t[0], t[1], t[2]));
+		transform *= glm::mat4_cast(glm::quat(r[3], r[0], r[1], r[2]));
+		return glm::scale(transform, glm::vec3(s[0], s[1], s[2]));
+	}
+
+	void readNumbers(int array, float* out, int count) const
+	{
+		if (json.count(array) != count)
+			return;
+		int i = 0;
+		for (int at = json.first(array); at >= 0; at = json.next(at), i++)
+			out[i] = (float)json.number(at, out[i]);
+	}
+
+	// instances of the default scene, or of every root node when there is no scene
+	bool readScene()
+	{
+		std::vector<int> nodes = json.elements(json.member(json.root(), "nodes"));
+		std::vector<int> roots;
+		std::vector<int> scenes = json.elements(json.member(json.root(), "scenes"));
+		int scene = json.integer(json.member(json.root(), "scene"), 0);
+		if (scene >= 0 && scene < (int)scenes.size()) {
+			for (int at = json.first(json.member(scenes[scene], "nodes")); at >= 0; at = json.next(at))
+				roots.push_back(json.integer(at, -1));
+		}
+		else {
+			std::vector<bool> child(nodes.size(), false);
+			for (int node : nodes) {
+				for (int at = json.first(json.member(node, "children")); at >= 0; at = json.next(at)) {
+					int index = json.integer(at, -1);
+					if (index >= 0 && index < (int)nodes.size())
+						child[index] = true;
+				}
+			}
+			for (size_t i = 0; i < nodes.size(); i++) {
+				if (!child[i])
+					roots.push_back((int)i);
+			}
+		}
+
+		struct Visit { int node; glm::mat4 parent; };
+		std::vector<Visit> stack;
+		std::vector<bool> visited(nodes.size(), false);
+		for (int root : roots)
+			stack.push_back({ root, glm::mat4(1.0f) });
+		while (!stack.empty()) {
+			Visit visit = stack.back();
+			stack.pop_back();
+			if (visit.node < 0 || visit.node >= (int)nodes.size() || visited[visit.node])
+				return fail("node hierarchy is not a tree");
+			visited[visit.node] = true;
+			int node = nodes[visit.node];
+			glm::mat4 world = visit.parent * localTransform(node);
+			int mesh = json.member(node, "mesh");
+			if (mesh >= 0) {
+				int index = json.integer(mesh, -1);
+				if (index < 0 || index >= (int)meshes.size())
+					return fail("node mesh index");
+				instances.push_back({ index, world });
+			}
+			for (int at = json.first(json.member(node, "children")); at >= 0; at = json.next(at))
+				stack.push_back({ json.integer(at, -1), world });
+		}
+		return true;
+	}
+};
+#endif
@@ -0,0 +1,138 @@
+#ifndef GPUTIMER_H
+#define GPUTIMER_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+
+#include "framereport.h"
+#include "profiler.h"
+#include "timing.h"
+
+// frames a query waits before it is read, by then the gpu has long finished it
+const int GPU_TIMER_FRAMES = 4;
+
+// Timestamp queries around every render pass, kept in a ring of GPU_TIMER_FRAMES frames.
+// Results are read back when a frame's slot comes round again, so the cpu never waits
+// on the gpu. A result that is still not ready then is dropped rather than waited for.
+class GpuTimer
+{
+public:
+	int64_t dropped = 0; // frames whose queries were not ready in time
+
+	GpuTimer()
+	{
+		glGenQueries(GPU_TIMER_FRAMES * RENDER_PASSES * 2, queries);
+#if HATCH_PROFILER
+		timeline = Profiler::get().namedRing("GPU");
+#endif
+	}
+
+	~GpuTimer() { release(); }
+
+	// deletes the queries, call it while the context is still current
+	void release()
+	{
+		if (!created)
+			return;
+		glDeleteQueries(GPU_TIMER_FRAMES * RENDER_PASSES * 2, queries);
+		created = false;
+	}
+
+	GpuTimer(const GpuTimer&) = delete;
+	GpuTimer& operator=(const GpuTimer&) = delete;
+
+	// reads back the frame that used this slot last, then reuses its queries
+	void beginFrame(int64_t frame, FrameReport& report)
+	{
+		slot = (int)(frame % GPU_TIMER_FRAMES);
+		if (issued[slot] != 0)
+			collect(report);
+		issued[slot] = 0;
+		frames[slot] = frame;
+
+		// the gpu clock is not the cpu clock, line them up every so often for the trace
+		if (frame % 256 == 0) {
+			GLint64 gpuNow = 0;
+			glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+			gpuToCpu = Clock::now() - gpuNow;
+		}
+	}
+
+	void begin(RenderPass pass) { glQueryCounter(query(slot, pass, 0), GL_TIMESTAMP); }
+
+	void end(RenderPass pass)
+	{
+		glQueryCounter(query(slot, pass, 1), GL_TIMESTAMP);
+		issued[slot] |= 1u << pass;
+	}
+
+private:
+	unsigned int queries[GPU_TIMER_FRAMES * RENDER_PASSES * 2];
+	bool created = true;
+	unsigned int issued[GPU_TIMER_FRAMES] = {}; // bit per pass with queries in flight
+	int64_t frames[GPU_TIMER_FRAMES] = {};
+	int slot = 0;
+	int64_t gpuToCpu = 0;
+	ProfileRing* timeline = nullptr;
+
+	unsigned int query(int frameSlot, int pass, int end) const { return queries[(frameSlot * RENDER_PASSES + pass) * 2 + end]; }
+
+	void collect(FrameReport& report)
+	{
+		for (int pass = 0; pass < RENDER_PASSES; pass++) {
+			if ((issued[slot] & (1u << pass)) == 0)
+				continue;
+			GLint available = 0;
+			glGetQueryObjectiv(query(slot, pass, 1), GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available) {
+				dropped++;
+				return;
+			}
+		}
+
+		for (int pass = 0; pass < RENDER_PASSES; pass++) {
+			if ((issued[slot] & (1u << pass)) == 0)
+				continue;
+			GLuint64 start = 0, end = 0;
+			glGetQueryObjectui64v(query(slot, pass, 0), GL_QUERY_RESULT, &start);
+			glGetQueryObjectui64v(query(slot, pass, 1), GL_QUERY_RESULT, &end);
+			report.addGpu(frames[slot], (RenderPass)pass, (float)((end - start) / 1.0e6));
+			if (timeline != nullptr)
+				timeline->push(RENDER_PASS_NAMES[pass], (int64_t)start + gpuToCpu, (int64_t)end + gpuToCpu, ProfileZoneEvent);
+		}
+	}
+};
+
+// Times one pass on the cpu and the gpu and adds it to the profiler trace
+class RenderPassScope
+{
+public:
+	RenderPassScope(GpuTimer& gpuTimer, FrameReport& frameReport, RenderPass renderPass)
+		: timer(gpuTimer), report(frameReport), pass(renderPass), start(Clock::now())
+	{
+		timer.begin(pass);
+	}
+
+	~RenderPassScope()
+	{
+		timer.end(pass);
+		int64_t end = Clock::now();
+		report.addCpu(pass, (float)((end - start) / 1.0e6));
+#if HATCH_PROFILER
+		profileThreadRing().push(RENDER_PASS_NAMES[pass], start, end, ProfileZoneEvent);
+#endif
+	}
+
+	RenderPassScope(const RenderPassScope&) = delete;
+	RenderPassScope& operator=(const RenderPassScope&) = delete;
+
+private:
+	GpuTimer& timer;
+	FrameReport& report;
+	RenderPass pass;
+	int64_t start;
+};
+
+#define RENDER_PASS(timer, report, pass) RenderPassScope PROFILE_CONCAT(renderPass, __COUNTER__)(timer, report, pass)
+#endif
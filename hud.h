@@ -0,0 +1,206 @@
+#ifndef HUD_H
+#define HUD_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "framereport.h"
+#include "hudfont.h"
+#include "renderstats.h"
+#include "shader.h"
+
+const int HUD_GRAPH_FRAMES = 120; // frames shown in the frame time graph
+const int HUD_MAX_QUADS = 4096;
+const int HUD_ATLAS_COLUMNS = 16;
+const int HUD_ATLAS_ROWS = 6; // 95 glyphs and a solid cell for bars
+
+struct HudVertex
+{
+	float x, y; // pixels from the top left
+	float u, v;
+	unsigned char r, g, b, a;
+};
+
+// Performance overlay. Every glyph and bar is a quad cut from one small atlas texture,
+// all of them are written into one buffer and drawn with a single draw call.
+class Hud
+{
+public:
+	Hud() : shader("Shaders/hud.vert", "Shaders/hud.frag")
+	{
+		// glyph atlas, one byte per texel
+		const int atlasWidth = HUD_ATLAS_COLUMNS * HUD_GLYPH_WIDTH;
+		const int atlasHeight = HUD_ATLAS_ROWS * HUD_GLYPH_HEIGHT;
+		std::vector<unsigned char> texels(atlasWidth * atlasHeight, 0);
+		for (int glyph = 0; glyph <= HUD_GLYPH_COUNT; glyph++) {
+			int cellX = (glyph % HUD_ATLAS_COLUMNS) * HUD_GLYPH_WIDTH;
+			int cellY = (glyph / HUD_ATLAS_COLUMNS) * HUD_GLYPH_HEIGHT;
+			for (int y = 0; y < HUD_GLYPH_HEIGHT; y++) {
+				unsigned char row = glyph == HUD_GLYPH_COUNT ? 0xFF : HUD_FONT[glyph][y];
+				for (int x = 0; x < HUD_GLYPH_WIDTH; x++) {
+					if (row & (0x80 >> x))
+						texels[(cellY + y) * atlasWidth + cellX + x] = 255;
+				}
+			}
+		}
+		glGenTextures(1, &atlas);
+		glBindTexture(GL_TEXTURE_2D, atlas);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlasWidth, atlasHeight, 0, GL_RED, GL_UNSIGNED_BYTE, texels.data());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		countTextureMemory(atlasWidth * atlasHeight);
+
+		// quads share one static index buffer, only vertices change each frame
+		std::vector<unsigned short> indices;
+		for (int quad = 0; quad < HUD_MAX_QUADS; quad++) {
+			unsigned short first = (unsigned short)(quad * 4);
+			unsigned short corners[6] = { first, (unsigned short)(first + 1), (unsigned short)(first + 2), first, (unsigned short)(first + 2), (unsigned short)(first + 3) };
+			indices.insert(indices.end(), corners, corners + 6);
+		}
+
+		glGenVertexArrays(1, &VAO);
+		glGenBuffers(1, &VBO);
+		glGenBuffers(1, &EBO);
+		glBindVertexArray(VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		glBufferData(GL_ARRAY_BUFFER, HUD_MAX_QUADS * 4 * sizeof(HudVertex), NULL, GL_STREAM_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), indices.data(), GL_STATIC_DRAW);
+		countBufferMemory(HUD_MAX_QUADS * 4 * sizeof(HudVertex) + indices.size() * sizeof(unsigned short));
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(HudVertex), (void*)0);
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(HudVertex), (void*)(2 * sizeof(float)));
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(HudVertex), (void*)(4 * sizeof(float)));
+		glBindVertexArray(0);
+
+		vertices.reserve(HUD_MAX_QUADS * 4);
+	}
+
+	// keeps the graph going while hidden so it is full when shown
+	void addFrame(float frameMs)
+	{
+		graph[graphHead] = frameMs;
+		graphHead = (graphHead + 1) % HUD_GRAPH_FRAMES;
+	}
+
+	// shows the newest frame the report has complete cpu and gpu times for
+	void draw(int width, int height, const FrameReport& report)
+	{
+		vertices.clear();
+		const FrameTimings* timings = report.complete();
+		RenderStats stats = timings != nullptr ? timings->stats : RenderStats();
+		char line[128];
+
+		rect(4.0f, 4.0f, 320.0f, 112.0f + 14.0f * RENDER_PASSES, 0, 0, 0, 160);
+
+		float x = 10.0f, y = 8.0f;
+		float frameMs = graph[(graphHead + HUD_GRAPH_FRAMES - 1) % HUD_GRAPH_FRAMES];
+		snprintf(line, sizeof(line), "%5.1f fps %6.2f ms", frameMs > 0.0f ? 1000.0f / frameMs : 0.0f, frameMs);
+		text(x, y, line, 255, 255, 255);
+
+		// frame time graph, 33ms is the top, green under 16.7ms
+		y += 14.0f;
+		for (int i = 0; i < HUD_GRAPH_FRAMES; i++) {
+			float ms = graph[(graphHead + i) % HUD_GRAPH_FRAMES];
+			float barHeight = std::min(ms / 33.3f, 1.0f) * 40.0f;
+			bool slow = ms > 16.7f;
+			rect(x + i * 2.0f, y + 40.0f - barHeight, 2.0f, barHeight, slow ? 230 : 80, slow ? 80 : 220, 80, 255);
+		}
+		y += 46.0f;
+
+		snprintf(line, sizeof(line), "draws %d  tris %lld  states %d", stats.draws, (long long)stats.triangles, stats.stateChanges);
+		text(x, y, line, 255, 255, 255);
+		y += 14.0f;
+		const GpuResourceStats& resources = gpuResources();
+		snprintf(line, sizeof(line), "buffers %.1f MB  textures %.1f MB", resources.bufferBytes.load() / 1048576.0, resources.textureBytes.load() / 1048576.0);
+		text(x, y, line, 255, 255, 255);
+		y += 18.0f;
+
+		text(x, y, "pass        cpu ms   gpu ms", 200, 200, 200);
+		y += 14.0f;
+		for (int i = 0; i < RENDER_PASSES; i++) {
+			float cpu = timings != nullptr ? timings->cpuMs[i] : 0.0f;
+			float gpu = timings != nullptr ? timings->gpuMs[i] : -1.0f;
+			if (gpu >= 0.0f)
+				snprintf(line, sizeof(line), "%-10s %7.3f  %7.3f", RENDER_PASS_NAMES[i], cpu, gpu);
+			else
+				snprintf(line, sizeof(line), "%-10s %7.3f        -", RENDER_PASS_NAMES[i], cpu);
+			text(x, y, line, 255, 255, 255);
+			y += 14.0f;
+		}
+
+		int quads = (int)(vertices.size() / 4);
+		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		glBufferData(GL_ARRAY_BUFFER, HUD_MAX_QUADS * 4 * sizeof(HudVertex), NULL, GL_STREAM_DRAW); // orphan last frame's quads
+		glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(HudVertex), vertices.data());
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		countUpload(vertices.size() * sizeof(HudVertex));
+
+		glDisable(GL_DEPTH_TEST);
+		shader.use();
+		shader.setVec2("screenSize", (float)width, (float)height);
+		shader.setInt("atlas", 0);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, atlas);
+		glBindVertexArray(VAO);
+		glDrawElements(GL_TRIANGLES, quads * 6, GL_UNSIGNED_SHORT, (void*)0);
+		countDraw(quads * 6);
+		countStateChange(2);
+		glBindVertexArray(0);
+		glEnable(GL_DEPTH_TEST);
+	}
+
+private:
+	Shader shader;
+	unsigned int atlas = 0;
+	unsigned int VAO = 0, VBO = 0, EBO = 0;
+	std::vector<HudVertex> vertices;
+	float graph[HUD_GRAPH_FRAMES] = {};
+	int graphHead = 0;
+
+	void quad(float x, float y, float w, float h, int cell, unsigned char r, unsigned char g, unsigned char b, unsigned char a)
+	{
+		if (vertices.size() + 4 > (size_t)HUD_MAX_QUADS * 4)
+			return;
+		const float cellU = 1.0f / HUD_ATLAS_COLUMNS, cellV = 1.0f / HUD_ATLAS_ROWS;
+		float u0 = (cell % HUD_ATLAS_COLUMNS) * cellU, v0 = (cell / HUD_ATLAS_COLUMNS) * cellV;
+		float u1 = u0 + cellU, v1 = v0 + cellV;
+		vertices.push_back({ x, y, u0, v0, r, g, b, a });
+		vertices.push_back({ x + w, y, u1, v0, r, g, b, a });
+		vertices.push_back({ x + w, y + h, u1, v1, r, g, b, a });
+		vertices.push_back({ x, y + h, u0, v1, r, g, b, a });
+	}
+
+	// solid quad, every corner samples the middle of the solid atlas cell
+	void rect(float x, float y, float w, float h, unsigned char r, unsigned char g, unsigned char b, unsigned char a)
+	{
+		if (vertices.size() + 4 > (size_t)HUD_MAX_QUADS * 4)
+			return;
+		float u = (HUD_GLYPH_COUNT % HUD_ATLAS_COLUMNS + 0.5f) / HUD_ATLAS_COLUMNS;
+		float v = (HUD_GLYPH_COUNT / HUD_ATLAS_COLUMNS + 0.5f) / HUD_ATLAS_ROWS;
+		vertices.push_back({ x, y, u, v, r, g, b, a });
+		vertices.push_back({ x + w, y, u, v, r, g, b, a });
+		vertices.push_back({ x + w, y + h, u, v, r, g, b, a });
+		vertices.push_back({ x, y + h, u, v, r, g, b, a });
+	}
+
+	void text(float x, float y, const char* string, unsigned char r, unsigned char g, unsigned char b)
+	{
+		for (const char* c = string; *c != '\0'; c++, x += HUD_GLYPH_WIDTH) {
+			int glyph = *c - HUD_FIRST_GLYPH;
+			if (glyph > 0 && glyph < HUD_GLYPH_COUNT) // spaces need no quad
+				quad(x, y, (float)HUD_GLYPH_WIDTH, (float)HUD_GLYPH_HEIGHT, glyph, r, g, b, 255);
+		}
+	}
+};
+#endif
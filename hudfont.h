@@ -0,0 +1,108 @@
+#ifndef HUDFONT_H
+#define HUDFONT_H
+
+// 8x12 bitmap font for printable ascii (32 to 126), rasterised from Source Code Pro at 12px.
+// one byte per row, most significant bit is the leftmost pixel
+const int HUD_GLYPH_WIDTH = 8;
+const int HUD_GLYPH_HEIGHT = 12;
+const int HUD_FIRST_GLYPH = 32;
+const int HUD_GLYPH_COUNT = 95;
+
+const unsigned char HUD_FONT[HUD_GLYPH_COUNT][HUD_GLYPH_HEIGHT] = {
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // space
+	{ 0x00, 0x00, 0x08, 0x08, 0x08, 0x08, 0x08, 0x00, 0x08, 0x08, 0x00, 0x00 }, // !
+	{ 0x00, 0x00, 0x36, 0x16, 0x16, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // "
+	{ 0x00, 0x00, 0x12, 0x10, 0x3e, 0x14, 0x14, 0x3e, 0x14, 0x14, 0x00, 0x00 }, // #
+	{ 0x00, 0x08, 0x08, 0x1c, 0x32, 0x18, 0x06, 0x22, 0x1e, 0x08, 0x08, 0x00 }, // $
+	{ 0x00, 0x00, 0x30, 0x49, 0x4a, 0x30, 0x06, 0x15, 0x25, 0x06, 0x00, 0x00 }, // %
+	{ 0x00, 0x00, 0x18, 0x34, 0x3c, 0x18, 0x31, 0x6e, 0x26, 0x3f, 0x00, 0x00 }, // &
+	{ 0x00, 0x00, 0x08, 0x08, 0x08, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // '
+	{ 0x00, 0x02, 0x04, 0x08, 0x08, 0x18, 0x18, 0x18, 0x08, 0x08, 0x04, 0x02 }, // (
+	{ 0x00, 0x10, 0x10, 0x08, 0x08, 0x04, 0x04, 0x04, 0x08, 0x08, 0x10, 0x10 }, // )
+	{ 0x00, 0x00, 0x00, 0x08, 0x08, 0x3e, 0x0c, 0x1c, 0x10, 0x00, 0x00, 0x00 }, // *
+	{ 0x00, 0x00, 0x00, 0x00, 0x08, 0x08, 0x3e, 0x08, 0x08, 0x00, 0x00, 0x00 }, // +
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x0c, 0x04, 0x08 }, // ,
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3e, 0x00, 0x00, 0x00, 0x00, 0x00 }, // -
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x08, 0x00, 0x00 }, // .
+	{ 0x00, 0x02, 0x06, 0x04, 0x04, 0x08, 0x08, 0x18, 0x10, 0x10, 0x20, 0x00 }, // /
+	{ 0x00, 0x00, 0x1c, 0x32, 0x22, 0x2a, 0x2a, 0x22, 0x32, 0x1c, 0x00, 0x00 }, // 0
+	{ 0x00, 0x00, 0x18, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x3e, 0x00, 0x00 }, // 1
+	{ 0x00, 0x00, 0x1c, 0x26, 0x02, 0x06, 0x04, 0x08, 0x10, 0x3e, 0x00, 0x00 }, // 2
+	{ 0x00, 0x00, 0x1c, 0x22, 0x06, 0x1c, 0x06, 0x02, 0x22, 0x1c, 0x00, 0x00 }, // 3
+	{ 0x00, 0x00, 0x04, 0x0c, 0x1c, 0x14, 0x24, 0x7f, 0x04, 0x04, 0x00, 0x00 }, // 4
+	{ 0x00, 0x00, 0x3e, 0x20, 0x20, 0x3c, 0x02, 0x02, 0x22, 0x3c, 0x00, 0x00 }, // 5
+	{ 0x00, 0x00, 0x1e, 0x32, 0x20, 0x2e, 0x32, 0x22, 0x32, 0x1c, 0x00, 0x00 }, // 6
+	{ 0x00, 0x00, 0x3e, 0x02, 0x04, 0x04, 0x08, 0x08, 0x08, 0x08, 0x00, 0x00 }, // 7
+	{ 0x00, 0x00, 0x1c, 0x32, 0x12, 0x1c, 0x26, 0x22, 0x22, 0x1e, 0x00, 0x00 }, // 8
+	{ 0x00, 0x00, 0x1c, 0x22, 0x22, 0x26, 0x1e, 0x02, 0x06, 0x3c, 0x00, 0x00 }, // 9
+	{ 0x00, 0x00, 0x00, 0x00, 0x08, 0x08, 0x00, 0x00, 0x08, 0x08, 0x00, 0x00 }, // :
+	{ 0x00, 0x00, 0x00, 0x00, 0x08, 0x08, 0x00, 0x00, 0x0c, 0x0c, 0x04, 0x08 }, // ;
+	{ 0x00, 0x00, 0x00, 0x02, 0x04, 0x18, 0x30, 0x18, 0x04, 0x02, 0x00, 0x00 }, // <
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x3e, 0x00, 0x3e, 0x00, 0x00, 0x00, 0x00 }, // =
+	{ 0x00, 0x00, 0x00, 0x20, 0x18, 0x0c, 0x06, 0x0c, 0x18, 0x20, 0x00, 0x00 }, // >
+	{ 0x00, 0x00, 0x1c, 0x06, 0x06, 0x0c, 0x08, 0x00, 0x08, 0x08, 0x00, 0x00 }, // ?
+	{ 0x00, 0x00, 0x1e, 0x32, 0x21, 0x27, 0x09, 0x2b, 0x2f, 0x20, 0x30, 0x1e }, // @
+	{ 0x00, 0x00, 0x08, 0x1c, 0x14, 0x14, 0x32, 0x3e, 0x22, 0x63, 0x00, 0x00 }, // A
+	{ 0x00, 0x00, 0x3c, 0x22, 0x22, 0x3c, 0x22, 0x23, 0x22, 0x3e, 0x00, 0x00 }, // B
+	{ 0x00, 0x00, 0x1e, 0x32, 0x20, 0x20, 0x20, 0x20, 0x32, 0x1e, 0x00, 0x00 }, // C
+	{ 0x00, 0x00, 0x3c, 0x26, 0x22, 0x23, 0x23, 0x22, 0x26, 0x3c, 0x00, 0x00 }, // D
+	{ 0x00, 0x00, 0x3e, 0x20, 0x20, 0x3e, 0x20, 0x20, 0x20, 0x3e, 0x00, 0x00 }, // E
+	{ 0x00, 0x00, 0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x10, 0x10, 0x00, 0x00 }, // F
+	{ 0x00, 0x00, 0x1e, 0x32, 0x20, 0x20, 0x26, 0x22, 0x32, 0x1e, 0x00, 0x00 }, // G
+	{ 0x00, 0x00, 0x22, 0x22, 0x22, 0x3e, 0x22, 0x22, 0x22, 0x22, 0x00, 0x00 }, // H
+	{ 0x00, 0x00, 0x3e, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x3e, 0x00, 0x00 }, // I
+	{ 0x00, 0x00, 0x1e, 0x02, 0x02, 0x02, 0x02, 0x02, 0x26, 0x1c, 0x00, 0x00 }, // J
+	{ 0x00, 0x00, 0x22, 0x26, 0x2c, 0x3c, 0x34, 0x26, 0x22, 0x23, 0x00, 0x00 }, // K
+	{ 0x00, 0x00, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1f, 0x00, 0x00 }, // L
+	{ 0x00, 0x00, 0x22, 0x32, 0x36, 0x36, 0x2a, 0x2a, 0x22, 0x22, 0x00, 0x00 }, // M
+	{ 0x00, 0x00, 0x22, 0x32, 0x32, 0x2a, 0x2a, 0x26, 0x26, 0x22, 0x00, 0x00 }, // N
+	{ 0x00, 0x00, 0x1c, 0x32, 0x23, 0x23, 0x23, 0x23, 0x32, 0x1c, 0x00, 0x00 }, // O
+	{ 0x00, 0x00, 0x3e, 0x22, 0x23, 0x22, 0x3e, 0x20, 0x20, 0x20, 0x00, 0x00 }, // P
+	{ 0x00, 0x00, 0x1c, 0x32, 0x22, 0x23, 0x23, 0x22, 0x32, 0x1c, 0x0c, 0x07 }, // Q
+	{ 0x00, 0x00, 0x3e, 0x22, 0x22, 0x22, 0x3e, 0x24, 0x26, 0x22, 0x00, 0x00 }, // R
+	{ 0x00, 0x00, 0x1e, 0x32, 0x30, 0x18, 0x06, 0x02, 0x22, 0x1e, 0x00, 0x00 }, // S
+	{ 0x00, 0x00, 0x7f, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x00, 0x00 }, // T
+	{ 0x00, 0x00, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x32, 0x1c, 0x00, 0x00 }, // U
+	{ 0x00, 0x00, 0x23, 0x22, 0x22, 0x12, 0x14, 0x14, 0x1c, 0x08, 0x00, 0x00 }, // V
+	{ 0x00, 0x00, 0x41, 0x41, 0x69, 0x2d, 0x37, 0x36, 0x36, 0x32, 0x00, 0x00 }, // W
+	{ 0x00, 0x00, 0x22, 0x16, 0x14, 0x0c, 0x0c, 0x14, 0x32, 0x22, 0x00, 0x00 }, // X
+	{ 0x00, 0x00, 0x23, 0x22, 0x16, 0x14, 0x0c, 0x08, 0x08, 0x08, 0x00, 0x00 }, // Y
+	{ 0x00, 0x00, 0x3e, 0x02, 0x04, 0x0c, 0x08, 0x10, 0x20, 0x3f, 0x00, 0x00 }, // Z
+	{ 0x00, 0x0e, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0e }, // [
+	{ 0x00, 0x20, 0x10, 0x10, 0x18, 0x08, 0x08, 0x04, 0x04, 0x06, 0x02, 0x00 }, // backslash
+	{ 0x00, 0x3c, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x3c }, // ]
+	{ 0x00, 0x00, 0x08, 0x0c, 0x14, 0x14, 0x22, 0x00, 0x00, 0x00, 0x00, 0x00 }, // ^
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3f }, // _
+	{ 0x00, 0x18, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // `
+	{ 0x00, 0x00, 0x00, 0x00, 0x1c, 0x02, 0x1e, 0x32, 0x22, 0x3e, 0x00, 0x00 }, // a
+	{ 0x00, 0x20, 0x20, 0x20, 0x3e, 0x32, 0x23, 0x22, 0x32, 0x3c, 0x00, 0x00 }, // b
+	{ 0x00, 0x00, 0x00, 0x00, 0x1e, 0x32, 0x20, 0x20, 0x32, 0x1e, 0x00, 0x00 }, // c
+	{ 0x00, 0x02, 0x02, 0x02, 0x1e, 0x32, 0x22, 0x22, 0x26, 0x1e, 0x00, 0x00 }, // d
+	{ 0x00, 0x00, 0x00, 0x00, 0x1e, 0x22, 0x3f, 0x20, 0x30, 0x1e, 0x00, 0x00 }, // e
+	{ 0x00, 0x07, 0x08, 0x08, 0x3e, 0x08, 0x08, 0x08, 0x08, 0x08, 0x00, 0x00 }, // f
+	{ 0x00, 0x00, 0x00, 0x00, 0x1f, 0x36, 0x36, 0x1c, 0x20, 0x3f, 0x23, 0x3e }, // g
+	{ 0x00, 0x20, 0x20, 0x20, 0x2e, 0x32, 0x22, 0x22, 0x22, 0x22, 0x00, 0x00 }, // h
+	{ 0x00, 0x0c, 0x0c, 0x00, 0x3c, 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x00 }, // i
+	{ 0x00, 0x0c, 0x0c, 0x00, 0x3c, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0c, 0x38 }, // j
+	{ 0x00, 0x20, 0x20, 0x20, 0x22, 0x24, 0x3c, 0x34, 0x22, 0x23, 0x00, 0x00 }, // k
+	{ 0x00, 0x38, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0e, 0x00, 0x00 }, // l
+	{ 0x00, 0x00, 0x00, 0x00, 0x3e, 0x2f, 0x29, 0x29, 0x29, 0x29, 0x00, 0x00 }, // m
+	{ 0x00, 0x00, 0x00, 0x00, 0x2e, 0x32, 0x22, 0x22, 0x22, 0x22, 0x00, 0x00 }, // n
+	{ 0x00, 0x00, 0x00, 0x00, 0x1c, 0x32, 0x22, 0x22, 0x32, 0x1c, 0x00, 0x00 }, // o
+	{ 0x00, 0x00, 0x00, 0x00, 0x3e, 0x32, 0x23, 0x22, 0x32, 0x3c, 0x20, 0x20 }, // p
+	{ 0x00, 0x00, 0x00, 0x00, 0x1e, 0x32, 0x22, 0x22, 0x26, 0x1e, 0x02, 0x02 }, // q
+	{ 0x00, 0x00, 0x00, 0x00, 0x16, 0x18, 0x10, 0x10, 0x10, 0x10, 0x00, 0x00 }, // r
+	{ 0x00, 0x00, 0x00, 0x00, 0x1c, 0x20, 0x18, 0x06, 0x22, 0x1e, 0x00, 0x00 }, // s
+	{ 0x00, 0x00, 0x00, 0x18, 0x3e, 0x18, 0x18, 0x18, 0x18, 0x0e, 0x00, 0x00 }, // t
+	{ 0x00, 0x00, 0x00, 0x00, 0x22, 0x22, 0x22, 0x22, 0x26, 0x3a, 0x00, 0x00 }, // u
+	{ 0x00, 0x00, 0x00, 0x00, 0x22, 0x22, 0x12, 0x14, 0x1c, 0x08, 0x00, 0x00 }, // v
+	{ 0x00, 0x00, 0x00, 0x00, 0x49, 0x69, 0x2d, 0x36, 0x36, 0x36, 0x00, 0x00 }, // w
+	{ 0x00, 0x00, 0x00, 0x00, 0x22, 0x14, 0x0c, 0x1c, 0x14, 0x22, 0x00, 0x00 }, // x
+	{ 0x00, 0x00, 0x00, 0x00, 0x23, 0x22, 0x12, 0x14, 0x0c, 0x08, 0x08, 0x30 }, // y
+	{ 0x00, 0x00, 0x00, 0x00, 0x3e, 0x06, 0x0c, 0x18, 0x30, 0x3e, 0x00, 0x00 }, // z
+	{ 0x00, 0x0e, 0x08, 0x08, 0x08, 0x08, 0x38, 0x08, 0x08, 0x08, 0x08, 0x0e }, // {
+	{ 0x00, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08 }, // |
+	{ 0x00, 0x38, 0x08, 0x08, 0x08, 0x08, 0x06, 0x08, 0x08, 0x08, 0x08, 0x38 }, // }
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x3a, 0x2e, 0x00, 0x00, 0x00, 0x00, 0x00 }, // ~
+};
+#endif
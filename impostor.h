@@ -0,0 +1,85 @@
+#ifndef IMPOSTOR_H
+#define IMPOSTOR_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "renderstats.h"
+#include "shader.h"
+
+// texture unit the ellipsoid matrices are bound to, after the bone palette
+const int IMPOSTOR_MODELS_UNIT = 3;
+
+// Spheres and ellipsoids drawn as one quad each (impostor.vert, impostor.frag) instead of a
+// sphere mesh. Each is the radius 0.5 sphere the meshes are, placed by its model matrix. The
+// fragment shader intersects the view ray with it and writes the depth, normal and texture
+// coords the mesh would have had, lit by lighting.glsl like room.frag, so it is exact at any
+// distance for 4 vertices. Like the skinned bone palette the matrices go in a texture buffer
+// and everything added since the last draw goes out as one instanced draw.
+class EllipsoidImpostors
+{
+public:
+	explicit EllipsoidImpostors(size_t capacity = 16)
+	{
+		models.reserve(capacity);
+		glGenVertexArrays(1, &VAO); // core profile draws need one bound, the quad has no attributes
+
+		glGenBuffers(1, &modelBuffer);
+		glGenTextures(1, &modelTexture);
+		glBindBuffer(GL_TEXTURE_BUFFER, modelBuffer);
+		modelCapacity = sizeof(glm::mat4) * capacity;
+		glBufferData(GL_TEXTURE_BUFFER, modelCapacity, NULL, GL_STREAM_DRAW);
+		countBufferMemory(modelCapacity);
+		glBindTexture(GL_TEXTURE_BUFFER, modelTexture);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, modelBuffer);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+	}
+
+	// adds one ellipsoid to this frame's batch
+	void add(const glm::mat4& model) { models.push_back(model); }
+
+	int size() const { return (int)models.size(); }
+
+	// uploads the matrices and draws every ellipsoid added since the last draw
+	void draw(Shader& shader)
+	{
+		if (models.empty())
+			return;
+
+		glBindBuffer(GL_TEXTURE_BUFFER, modelBuffer);
+		size_t bytes = models.size() * sizeof(glm::mat4);
+		if (bytes > modelCapacity) {
+			countBufferMemory(bytes - modelCapacity);
+			modelCapacity = bytes;
+		}
+		glBufferData(GL_TEXTURE_BUFFER, modelCapacity, NULL, GL_STREAM_DRAW); // orphan last frame's matrices
+		glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, models.data());
+		countUpload(bytes);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+		glActiveTexture(GL_TEXTURE0 + IMPOSTOR_MODELS_UNIT);
+		glBindTexture(GL_TEXTURE_BUFFER, modelTexture);
+
+		shader.use();
+		shader.setInt("impostorModels", IMPOSTOR_MODELS_UNIT);
+
+		glBindVertexArray(VAO);
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)models.size());
+		countDraw(6, (int)models.size()); // counted as the strip's 2 triangles
+		countStateChange(2); // matrix texture and vertex array
+		glBindVertexArray(0);
+
+		glActiveTexture(GL_TEXTURE0);
+		models.clear();
+	}
+
+private:
+	unsigned int VAO = 0;
+	unsigned int modelBuffer = 0, modelTexture = 0;
+	size_t modelCapacity = 0;
+	std::vector<glm::mat4> models;
+};
+#endif
@@ -0,0 +1,171 @@
+#ifndef INPUTRECORD_H
+#define INPUTRECORD_H
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// every key the scene reads, a recorded frame stores one bit per key in this order
+const int RECORDED_KEYS[] = {
+	GLFW_KEY_ESCAPE, GLFW_KEY_W, GLFW_KEY_A, GLFW_KEY_S, GLFW_KEY_D,
+	GLFW_KEY_E, GLFW_KEY_R, GLFW_KEY_Q, GLFW_KEY_T, GLFW_KEY_Y,
+	GLFW_KEY_G, GLFW_KEY_P, GLFW_KEY_MINUS, GLFW_KEY_EQUAL, GLFW_KEY_F9, GLFW_KEY_F8, GLFW_KEY_H, GLFW_KEY_I,
+};
+const int RECORDED_KEY_COUNT = sizeof(RECORDED_KEYS) / sizeof(RECORDED_KEYS[0]);
+
+const uint32_t INPUT_RECORDING_MAGIC = 0x504E4948; // "HINP"
+const uint32_t INPUT_RECORDING_VERSION = 1;
+
+// bit for a key in InputFrame::keys, 0 for keys that are never recorded
+inline uint32_t recordedKeyBit(int key)
+{
+	for (int i = 0; i < RECORDED_KEY_COUNT; i++) {
+		if (RECORDED_KEYS[i] == key)
+			return 1u << i;
+	}
+	return 0;
+}
+
+enum InputEventType : uint8_t
+{
+	InputMouseMove,
+	InputScroll
+};
+
+// a glfw callback that arrived during a frame, replayed in the same order
+struct InputEvent
+{
+	InputEventType type;
+	double x;
+	double y;
+};
+
+// everything that decides what a frame does: how long it took and what the user did
+struct InputFrame
+{
+	int64_t frameNanoseconds = 0;
+	uint32_t keys = 0;
+	std::vector<InputEvent> events;
+
+	bool keyDown(int key) const { return (keys & recordedKeyBit(key)) != 0; }
+};
+
+inline uint32_t pollRecordedKeys(GLFWwindow* window)
+{
+	uint32_t keys = 0;
+	for (int i = 0; i < RECORDED_KEY_COUNT; i++) {
+		if (glfwGetKey(window, RECORDED_KEYS[i]) == GLFW_PRESS)
+			keys |= 1u << i;
+	}
+	return keys;
+}
+
+// Writes one record per frame: frame time (int64), key bits (uint32), event count (uint16)
+// then per event its type (uint8) and two doubles. Little endian, like the clip library.
+class InputRecorder
+{
+public:
+	bool open(const std::string& path)
+	{
+		file.open(path, std::ios::binary);
+		if (!file) {
+			std::cout << "ERROR::INPUTRECORD::OPEN_FAILED: " << path << std::endl;
+			return false;
+		}
+		write(INPUT_RECORDING_MAGIC);
+		write(INPUT_RECORDING_VERSION);
+		return true;
+	}
+
+	bool isOpen() const { return file.is_open(); }
+
+	void record(const InputFrame& frame)
+	{
+		uint16_t eventCount = (uint16_t)std::min<size_t>(frame.events.size(), 0xFFFF);
+		write(frame.frameNanoseconds);
+		write(frame.keys);
+		write(eventCount);
+		for (uint16_t i = 0; i < eventCount; i++) {
+			write((uint8_t)frame.events[i].type);
+			write(frame.events[i].x);
+			write(frame.events[i].y);
+		}
+		frames++;
+	}
+
+	void close()
+	{
+		if (file.is_open()) {
+			file.close();
+			std::cout << "Recorded " << frames << " frames" << std::endl;
+		}
+	}
+
+	~InputRecorder() { close(); }
+
+private:
+	std::ofstream file;
+	int64_t frames = 0;
+
+	template <typename T>
+	void write(const T& value) { file.write((const char*)&value, sizeof(T)); }
+};
+
+// Reads a recording back frame by frame. Frames come out exactly as recorded,
+// so a replay takes the same decisions and simulation steps as the original run.
+class InputPlayback
+{
+public:
+	bool open(const std::string& path)
+	{
+		file.open(path, std::ios::binary);
+		uint32_t magic = 0, version = 0;
+		read(magic);
+		read(version);
+		if (!file || magic != INPUT_RECORDING_MAGIC || version != INPUT_RECORDING_VERSION) {
+			std::cout << "ERROR::INPUTRECORD::INVALID_RECORDING: " << path << std::endl;
+			file.close();
+			return false;
+		}
+		return true;
+	}
+
+	bool isOpen() const { return file.is_open(); }
+
+	// false once the recording runs out
+	bool next(InputFrame& frame)
+	{
+		uint16_t eventCount = 0;
+		read(frame.frameNanoseconds);
+		read(frame.keys);
+		read(eventCount);
+		frame.events.resize(eventCount);
+		for (uint16_t i = 0; i < eventCount; i++) {
+			uint8_t type = 0;
+			read(type);
+			read(frame.events[i].x);
+			read(frame.events[i].y);
+			frame.events[i].type = (InputEventType)type;
+		}
+		if (!file)
+			return false;
+		recordedNanoseconds += frame.frameNanoseconds;
+		return true;
+	}
+
+	// total frame time of every frame read so far, real time playback waits for this
+	int64_t elapsed() const { return recordedNanoseconds; }
+
+private:
+	std::ifstream file;
+	int64_t recordedNanoseconds = 0;
+
+	template <typename T>
+	void read(T& value) { file.read((char*)&value, sizeof(T)); }
+};
+#endif
@@ -0,0 +1,385 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "frustum.h"
+#include "profiler.h"
+#include "timing.h"
+
+// queues are searched in this order, so a high task anywhere runs before a normal one
+enum JobPriority
+{
+	JobHigh,
+	JobNormal,
+	JobLow,
+	JOB_PRIORITIES
+};
+
+const int JOB_QUEUE_SIZE = 1024; // tasks one thread can have queued at one priority, power of 2
+
+class TaskGraph;
+
+struct GraphTask
+{
+	const char* name;
+	std::function<void()> work;
+	JobPriority priority;
+	std::vector<GraphTask*> successors;
+	int predecessors = 0;
+	std::atomic<int> waiting{ 0 }; // predecessors still running this time round
+	TaskGraph* graph = nullptr;
+};
+
+// first and last task of something added to a graph, the same task for a single one
+struct TaskSpan
+{
+	GraphTask* entry;
+	GraphTask* exit;
+};
+
+// Tasks and the order between them. Built once and run as often as needed, every
+// run starts each task once all the tasks that precede it have finished.
+class TaskGraph
+{
+public:
+	TaskGraph() {}
+	TaskGraph(const TaskGraph&) = delete;
+	TaskGraph& operator=(const TaskGraph&) = delete;
+
+	TaskSpan add(const char* name, std::function<void()> work, JobPriority priority = JobNormal)
+	{
+		tasks.emplace_back();
+		GraphTask& task = tasks.back();
+		task.name = name;
+		task.work = std::move(work);
+		task.priority = priority;
+		task.graph = this;
+		return { &task, &task };
+	}
+
+	// work(begin, end) over count items in batches of batchSize, as one task per batch
+	TaskSpan addParallel(const char* name, int count, int batchSize, std::function<void(int, int)> work, JobPriority priority = JobNormal)
+	{
+		TaskSpan fork = add(name, []() {}, priority);
+		TaskSpan join = add(name, []() {}, priority);
+		for (int begin = 0; begin < count; begin += batchSize) {
+			int end = std::min(count, begin + batchSize);
+			TaskSpan batch = add(name, [work, begin, end]() { work(begin, end); }, priority);
+			precede(fork, batch);
+			precede(batch, join);
+		}
+		if (count <= 0)
+			precede(fork, join);
+		return { fork.entry, join.exit };
+	}
+
+	// after starts once before has finished
+	void precede(TaskSpan before, TaskSpan after)
+	{
+		before.exit->successors.push_back(after.entry);
+		after.entry->predecessors++;
+	}
+
+	int size() const { return (int)tasks.size(); }
+
+private:
+	friend class JobSystem;
+	std::deque<GraphTask> tasks; // never moves a task once added
+	std::atomic<int> remaining{ 0 };
+};
+
+// Fixed size double ended queue. The owner pushes and pops at the back, newest first while
+// its data is still in cache, thieves take the oldest task from the front. Each queue has
+// its own lock which only its owner and the odd thief ever take.
+class JobQueue
+{
+public:
+	bool push(GraphTask* task)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (bottom - top == JOB_QUEUE_SIZE)
+			return false;
+		items[bottom++ & (JOB_QUEUE_SIZE - 1)] = task;
+		return true;
+	}
+
+	GraphTask* pop()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (bottom == top)
+			return nullptr;
+		return items[--bottom & (JOB_QUEUE_SIZE - 1)];
+	}
+
+	GraphTask* steal()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (bottom == top)
+			return nullptr;
+		return items[top++ & (JOB_QUEUE_SIZE - 1)];
+	}
+
+private:
+	std::mutex mutex;
+	GraphTask* items[JOB_QUEUE_SIZE];
+	int64_t top = 0, bottom = 0;
+};
+
+// Work stealing scheduler. Every thread has a queue per priority, tasks made ready by a
+// thread go on its own queue and idle threads steal from the others. The thread that
+// calls run() works through the graph too, so JobSystem(0) runs everything inline.
+// Given a per thread allocation counter (threadHeapAllocations in allocationhook.h) it
+// also sums what tasks allocate on the workers, which the caller's own count misses.
+class JobSystem
+{
+public:
+	explicit JobSystem(int workers, int64_t& (*allocationCounter)() = nullptr)
+		: slotCount(std::max(0, workers) + 1), slots(new Slot[std::max(0, workers) + 1]), allocationCounter(allocationCounter)
+	{
+		for (int i = 1; i < slotCount; i++)
+			threads.emplace_back(&JobSystem::workerLoop, this, i);
+	}
+
+	~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (std::thread& thread : threads)
+			thread.join();
+	}
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	int threadCount() const { return slotCount; }
+
+	// heap allocations tasks have made on the worker threads so far, complete once run() returns
+	int64_t workerAllocations() const { return workerAllocationCount.load(std::memory_order_relaxed); }
+
+	// runs every task of the graph and returns when the last one is done
+	void run(TaskGraph& graph)
+	{
+		if (graph.tasks.empty())
+			return;
+		graph.remaining.store((int)graph.tasks.size(), std::memory_order_relaxed);
+		for (GraphTask& task : graph.tasks)
+			task.waiting.store(task.predecessors, std::memory_order_relaxed);
+		for (GraphTask& task : graph.tasks) {
+			if (task.predecessors == 0)
+				submit(&task);
+		}
+		while (graph.remaining.load(std::memory_order_acquire) > 0) {
+			GraphTask* task = find(0);
+			if (task != nullptr)
+				execute(task);
+			else
+				std::this_thread::yield();
+		}
+	}
+
+private:
+	struct Slot
+	{
+		JobQueue queues[JOB_PRIORITIES];
+	};
+
+	int slotCount;
+	std::unique_ptr<Slot[]> slots;
+	std::vector<std::thread> threads;
+	std::atomic<int> queued{ 0 };
+	std::atomic<int> sleeping{ 0 };
+	bool stopping = false;
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+	int64_t& (*allocationCounter)();
+	std::atomic<int64_t> workerAllocationCount{ 0 };
+
+	// queue of the calling thread, 0 for the thread calling run()
+	static int& currentSlot()
+	{
+		static thread_local int slot = 0;
+		return slot;
+	}
+
+	void submit(GraphTask* task)
+	{
+		if (!slots[currentSlot()].queues[task->priority].push(task)) {
+			execute(task); // queue full, no point waiting for room
+			return;
+		}
+		queued.fetch_add(1);
+		if (sleeping.load() > 0) {
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			wake.notify_one();
+		}
+	}
+
+	GraphTask* find(int slot)
+	{
+		for (int priority = 0; priority < JOB_PRIORITIES; priority++) {
+			GraphTask* task = slots[slot].queues[priority].pop();
+			for (int i = 1; task == nullptr && i < slotCount; i++)
+				task = slots[(slot + i) % slotCount].queues[priority].steal();
+			if (task != nullptr) {
+				queued.fetch_sub(1);
+				return task;
+			}
+		}
+		return nullptr;
+	}
+
+	void execute(GraphTask* task)
+	{
+		// the thread calling run() counts its own
+		bool counted = allocationCounter != nullptr && currentSlot() != 0;
+		int64_t allocations = counted ? allocationCounter() : 0;
+		{
+#if HATCH_PROFILER
+			ProfileScope zone(task->name);
+#endif
+			task->work();
+		}
+		if (counted)
+			workerAllocationCount.fetch_add(allocationCounter() - allocations, std::memory_order_relaxed);
+		for (GraphTask* next : task->successors) {
+			if (next->waiting.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				submit(next);
+		}
+		task->graph->remaining.fetch_sub(1, std::memory_order_release);
+	}
+
+	void workerLoop(int slot)
+	{
+		currentSlot() = slot;
+		for (;;) {
+			GraphTask* task = nullptr;
+			for (int spin = 0; task == nullptr && spin < 64; spin++) {
+				task = find(slot);
+				if (task == nullptr)
+					std::this_thread::yield();
+			}
+			if (task != nullptr) {
+				execute(task);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			sleeping.fetch_add(1);
+			wake.wait(lock, [this]() { return stopping || queued.load() > 0; });
+			sleeping.fetch_sub(1);
+			if (stopping)
+				return;
+		}
+	}
+};
+
+// Synthetic scene of many objects: update transforms, cull against a frustum, then
+// gather the visible ones into a draw list, each stage a parallel task set. Runs it on
+// 1 up to every core and checks every thread count builds the same draw list.
+inline bool runJobBenchmark(int objectCount, int frames = 50)
+{
+	struct Object
+	{
+		glm::vec3 position, axis;
+		float speed, scale;
+	};
+	std::vector<Object> objects(objectCount);
+	unsigned int seed = 12345u;
+	auto random = [&seed]() { seed = seed * 1664525u + 1013904223u; return (seed >> 8) / 16777216.0f; };
+	for (Object& object : objects) {
+		object.position = glm::vec3(random() * 200.0f - 100.0f, random() * 20.0f, random() * -200.0f);
+		object.axis = glm::normalize(glm::vec3(random(), random() + 0.1f, random()));
+		object.speed = random() * 2.0f;
+		object.scale = 0.5f + random();
+	}
+
+	std::vector<glm::mat4> models(objectCount), drawList(objectCount);
+	std::vector<glm::mat3> normals(objectCount);
+	std::vector<char> visible(objectCount);
+	const int batch = 512;
+	std::vector<int> batchVisible((objectCount + batch - 1) / batch);
+	float time = 0.0f;
+	int drawCount = 0;
+	glm::mat4 viewProjection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 150.0f)
+		* glm::lookAt(glm::vec3(0.0f, 5.0f, 10.0f), glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	Frustum frustum(viewProjection);
+
+	TaskGraph graph;
+	TaskSpan update = graph.addParallel("update objects", objectCount, batch, [&](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			glm::mat4 model = glm::translate(glm::mat4(1.0f), objects[i].position);
+			model = glm::rotate(model, time * objects[i].speed, objects[i].axis);
+			models[i] = glm::scale(model, glm::vec3(objects[i].scale));
+			normals[i] = glm::transpose(glm::inverse(glm::mat3(models[i])));
+		}
+	}, JobHigh);
+	TaskSpan cull = graph.addParallel("cull objects", objectCount, batch, [&](int begin, int end) {
+		for (int i = begin; i < end; i++)
+			visible[i] = frustum.intersectsSphere(glm::vec3(models[i][3]), 1.8f * objects[i].scale);
+	});
+	TaskSpan build = graph.addParallel("build draw list", objectCount, batch, [&](int begin, int end) {
+		int count = 0;
+		for (int i = begin; i < end; i++) {
+			if (visible[i])
+				drawList[begin + count++] = models[i];
+		}
+		batchVisible[begin / batch] = count;
+	});
+	TaskSpan submit = graph.add("submit", [&]() {
+		drawCount = 0;
+		for (int count : batchVisible)
+			drawCount += count;
+	}, JobHigh);
+	graph.precede(update, cull);
+	graph.precede(cull, build);
+	graph.precede(build, submit);
+
+	int maxThreads = (int)std::max(1u, std::thread::hardware_concurrency());
+	std::vector<int> threadCounts;
+	for (int threads = 1; threads < maxThreads; threads *= 2)
+		threadCounts.push_back(threads);
+	threadCounts.push_back(maxThreads);
+
+	std::cout << "job benchmark: " << objectCount << " objects, " << graph.size() << " tasks a frame" << std::endl;
+	double singleThread = 0.0;
+	std::vector<glm::mat4> reference;
+	bool deterministic = true;
+	for (int threads : threadCounts) {
+		JobSystem jobs(threads - 1);
+		time = 0.0f;
+		jobs.run(graph); // wake the workers before timing
+		int64_t start = Clock::now();
+		for (int frame = 0; frame < frames; frame++) {
+			time = frame / 60.0f;
+			jobs.run(graph);
+		}
+		double ms = (Clock::now() - start) / 1.0e6 / frames;
+		if (threads == 1) {
+			singleThread = ms;
+			reference = drawList;
+		}
+		bool same = drawList == reference;
+		deterministic = deterministic && same;
+		std::cout << "  threads " << threads << ": " << ms << " ms a frame, " << drawCount << " visible, speedup "
+			<< singleThread / ms << (same ? "" : " (OUTPUT DIFFERS)") << std::endl;
+	}
+	return deterministic;
+}
+#endif
@@ -0,0 +1,246 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+enum JsonType {
+	JsonNull,
+	JsonBool,
+	JsonNumber,
+	JsonString,
+	JsonArray,
+	JsonObject
+};
+
+// One value, its children linked through firstChild and next. Keys and strings point into
+// the parsed text and keep their escapes, which asset formats only use in file names.
+struct JsonNode {
+	JsonType type;
+	const char* key;
+	uint32_t keyLength;
+	const char* text;
+	uint32_t textLength;
+	double number;
+	int firstChild;
+	int next;
+	int count; // children of an array or object
+};
+
+// Minimal JSON reader for asset headers. The document is parsed once into a flat array of
+// nodes, nothing is copied out of the text, so the text has to outlive the document.
+class JsonDocument
+{
+public:
+	bool parse(const char* text, size_t length)
+	{
+		nodes.clear();
+		at = text;
+		end = text + length;
+		int root = parseValue(0);
+		skipSpace();
+		return root == 0 && at == end;
+	}
+
+	bool empty() const { return nodes.empty(); }
+	int root() const { return nodes.empty() ? -1 : 0; }
+	const JsonNode& node(int index) const { return nodes[index]; }
+	JsonType type(int index) const { return index < 0 ? JsonNull : nodes[index].type; }
+	int count(int index) const { return index < 0 ? 0 : nodes[index].count; }
+	int first(int index) const { return index < 0 ? -1 : nodes[index].firstChild; }
+	int next(int index) const { return nodes[index].next; }
+
+	// member of an object, -1 if it is missing or index is not an object
+	int member(int object, const char* key) const
+	{
+		if (type(object) != JsonObject)
+			return -1;
+		size_t length = std::strlen(key);
+		for (int child = nodes[object].firstChild; child >= 0; child = nodes[child].next) {
+			if (nodes[child].keyLength == length && std::memcmp(nodes[child].key, key, length) == 0)
+				return child;
+		}
+		return -1;
+	}
+
+	// the children of an array or object in order, for arrays indexed many times
+	std::vector<int> elements(int array) const
+	{
+		std::vector<int> out;
+		for (int child = first(array); child >= 0; child = nodes[child].next)
+			out.push_back(child);
+		return out;
+	}
+
+	double number(int index, double fallback) const { return type(index) == JsonNumber ? nodes[index].number : fallback; }
+	int integer(int index, int fallback) const { return type(index) == JsonNumber ? (int)nodes[index].number : fallback; }
+	bool boolean(int index, bool fallback) const { return type(index) == JsonBool ? nodes[index].number != 0.0 : fallback; }
+	std::string string(int index) const { return type(index) == JsonString ? std::string(nodes[index].text, nodes[index].textLength) : std::string(); }
+
+	bool equals(int index, const char* value) const
+	{
+		size_t length = std::strlen(value);
+		return type(index) == JsonString && nodes[index].textLength == length && std::memcmp(nodes[index].text, value, length) == 0;
+	}
+
+private:
+	static const int MAX_DEPTH = 64;
+
+	std::vector<JsonNode> nodes;
+	const char* at = nullptr;
+	const char* end = nullptr;
+
+	void skipSpace()
+	{
+		while (at < end && (*at == ' ' || *at == '\t' || *at == '\n' || *at == '\r'))
+			at++;
+	}
+
+	int addNode(JsonType type)
+	{
+		JsonNode node = {};
+		node.type = type;
+		node.firstChild = -1;
+		node.next = -1;
+		nodes.push_back(node);
+		return (int)nodes.size() - 1;
+	}
+
+	// the string starting at the cursor, without its quotes, false if it is malformed
+	bool parseString(const char*& text, uint32_t& length)
+	{
+		if (at >= end || *at != '"')
+			return false;
+		text = ++at;
+		while (at < end && *at != '"') {
+			if ((unsigned char)*at < 0x20)
+				return false;
+			if (*at == '\\') {
+				if (++at >= end)
+					return false;
+				if (*at == 'u') {
+					for (int i = 0; i < 4; i++) {
+						if (++at >= end || !std::isxdigit((unsigned char)*at))
+							return false;
+					}
+				}
+				else if (*at == 0 || std::strchr("\"\\/bfnrt", *at) == nullptr) {
+					return false;
+				}
+			}
+			at++;
+		}
+		if (at >= end)
+			return false;
+		length = (uint32_t)(at - text);
+		at++;
+		return true;
+	}
+
+	bool parseLiteral(const char* word)
+	{
+		size_t length = std::strlen(word);
+		if ((size_t)(end - at) < length || std::memcmp(at, word, length) != 0)
+			return false;
+		at += length;
+		return true;
+	}
+
+	// index of the parsed value, -1 on a syntax error
+	int parseValue(int depth)
+	{
+		skipSpace();
+		if (at >= end || depth > MAX_DEPTH)
+			return -1;
+		char c = *at;
+		if (c == '{' || c == '[') {
+			bool object = c == '{';
+			int index = addNode(object ? JsonObject : JsonArray);
+			at++;
+			skipSpace();
+			if (at < end && *at == (object ? '}' : ']')) {
+				at++;
+				return index;
+			}
+			int last = -1;
+			for (;;) {
+				const char* key = nullptr;
+				uint32_t keyLength = 0;
+				if (object) {
+					skipSpace();
+					if (!parseString(key, keyLength))
+						return -1;
+					skipSpace();
+					if (at >= end || *at != ':')
+						return -1;
+					at++;
+				}
+				int child = parseValue(depth + 1);
+				if (child < 0)
+					return -1;
+				nodes[child].key = key;
+				nodes[child].keyLength = keyLength;
+				if (last < 0)
+					nodes[index].firstChild = child;
+				else
+					nodes[last].next = child;
+				last = child;
+				nodes[index].count++;
+				skipSpace();
+				if (at < end && *at == ',') {
+					at++;
+					continue;
+				}
+				if (at < end && *at == (object ? '}' : ']')) {
+					at++;
+					return index;
+				}
+				return -1;
+			}
+		}
+		if (c == '"') {
+			int index = addNode(JsonString);
+			const char* text = nullptr;
+			uint32_t length = 0;
+			if (!parseString(text, length))
+				return -1;
+			nodes[index].text = text;
+			nodes[index].textLength = length;
+			return index;
+		}
+		if (c == 't' || c == 'f') {
+			bool value = c == 't';
+			if (!parseLiteral(value ? "true" : "false"))
+				return -1;
+			int index = addNode(JsonBool);
+			nodes[index].number = value ? 1.0 : 0.0;
+			return index;
+		}
+		if (c == 'n') {
+			return parseLiteral("null") ? addNode(JsonNull) : -1;
+		}
+		if (c == '-' || (c >= '0' && c <= '9')) {
+			// strtod needs a terminated string, numbers are short so copy at most 63 characters
+			char buffer[64];
+			size_t length = 0;
+			while (at + length < end && length < sizeof(buffer) - 1 && at[length] != 0 && std::strchr("+-.eE0123456789", at[length]) != nullptr)
+				length++;
+			std::memcpy(buffer, at, length);
+			buffer[length] = 0;
+			char* stop = nullptr;
+			double value = std::strtod(buffer, &stop);
+			if (stop == buffer)
+				return -1;
+			at += stop - buffer;
+			int index = addNode(JsonNumber);
+			nodes[index].number = value;
+			return index;
+		}
+		return -1;
+	}
+};
+#endif
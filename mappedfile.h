@@ -0,0 +1,111 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Read only memory mapping of a whole file. The OS pages data in on first touch,
+// so formats laid out for direct use need no parsing or copying on load.
+class MappedFile
+{
+public:
+	MappedFile() {}
+
+	MappedFile(const std::string& path) { open(path); }
+
+	~MappedFile() { close(); }
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::string& path)
+	{
+		close();
+#ifdef _WIN32
+		file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE) {
+			std::cout << "ERROR::MAPPEDFILE::OPEN_FAILED: " << path << std::endl;
+			return false;
+		}
+		LARGE_INTEGER fileSize;
+		GetFileSizeEx(file, &fileSize);
+		bytes = (size_t)fileSize.QuadPart;
+		if (bytes > 0) {
+			mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (mapping != NULL)
+				memory = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		}
+#else
+		descriptor = ::open(path.c_str(), O_RDONLY);
+		if (descriptor < 0) {
+			std::cout << "ERROR::MAPPEDFILE::OPEN_FAILED: " << path << std::endl;
+			return false;
+		}
+		struct stat info;
+		fstat(descriptor, &info);
+		bytes = (size_t)info.st_size;
+		if (bytes > 0) {
+			void* view = mmap(NULL, bytes, PROT_READ, MAP_PRIVATE, descriptor, 0);
+			memory = view == MAP_FAILED ? nullptr : (const unsigned char*)view;
+		}
+#endif
+		if (memory == nullptr) {
+			std::cout << "ERROR::MAPPEDFILE::MAP_FAILED: " << path << std::endl;
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	void close()
+	{
+#ifdef _WIN32
+		if (memory != nullptr)
+			UnmapViewOfFile(memory);
+		if (mapping != NULL)
+			CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+		mapping = NULL;
+		file = INVALID_HANDLE_VALUE;
+#else
+		if (memory != nullptr)
+			munmap((void*)memory, bytes);
+		if (descriptor >= 0)
+			::close(descriptor);
+		descriptor = -1;
+#endif
+		memory = nullptr;
+		bytes = 0;
+	}
+
+	const unsigned char* data() const { return memory; }
+	size_t size() const { return bytes; }
+	bool isOpen() const { return memory != nullptr; }
+
+private:
+	const unsigned char* memory = nullptr;
+	size_t bytes = 0;
+#ifdef _WIN32
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = NULL;
+#else
+	int descriptor = -1;
+#endif
+};
+#endif
@@ -0,0 +1,222 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "renderstats.h"
+#include "vertexformat.h"
+
+// every vertex is 8 floats: position (3), normal (3), texture coords (2)
+const int MESH_VERTEX_FLOATS = 8;
+
+// levels of detail kept per mesh, each about half the triangles of the one before
+const int MAX_MESH_LODS = 5;
+
+// one level of detail, a range of the mesh's indices
+struct MeshLod
+{
+	unsigned int firstIndex;
+	unsigned int indexCount;
+	float error; // furthest the surface moved from the full mesh, in mesh units
+};
+
+// cpu side geometry, kept around so it can be merged or processed before upload
+struct MeshData
+{
+	std::vector<float> vertices;
+	std::vector<unsigned int> indices;
+
+	unsigned int vertexCount() const { return (unsigned int)(vertices.size() / MESH_VERTEX_FLOATS); }
+};
+
+// triangles given vertex by vertex, indexed in order
+inline MeshData unindexedMesh(const float* vertices, size_t floatCount)
+{
+	MeshData mesh;
+	mesh.vertices.assign(vertices, vertices + floatCount);
+	for (unsigned int i = 0; i < mesh.vertexCount(); i++) {
+		mesh.indices.push_back(i);
+	}
+	return mesh;
+}
+
+// unit cube from -1 to 1, one vertex per face corner so normals stay flat
+inline MeshData makeCube()
+{
+	static const float cubeVertices[] = {
+		// vertex pos         // normal pos     // texture coords
+		// back face
+		-1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
+		 1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
+		 1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 0.0f, // bottom-right
+		 1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
+		-1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
+		-1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 1.0f, // top-left
+		// front face
+		-1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
+		 1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 0.0f, // bottom-right
+		 1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
+		 1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
+		-1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 1.0f, // top-left
+		-1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
+		// left face
+		-1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
+		-1.0f,  1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-left
+		-1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
+		-1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
+		-1.0f, -1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-right
+		-1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
+		// right face
+		 1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
+		 1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
+		 1.0f,  1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-right
+		 1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
+		 1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
+		 1.0f, -1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left
+		// bottom face
+		-1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
+		 1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 1.0f, // top-left
+		 1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
+		 1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
+		-1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 0.0f, // bottom-right
+		-1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
+		// top face
+		-1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
+		 1.0f,  1.0f , 1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
+		 1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 1.0f, // top-right
+		 1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
+		-1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
+		-1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 0.0f  // bottom-left
+	};
+
+	return unindexedMesh(cubeVertices, sizeof(cubeVertices) / sizeof(float));
+}
+
+// latitude/longitude sphere, xlong * ylat vertices
+inline MeshData makeUVSphere(int xlong = 30, int ylat = 30, double r = 0.5)
+{
+	MeshData mesh;
+	mesh.vertices.resize(xlong * ylat * MESH_VERTEX_FLOATS);
+	float* vertices = mesh.vertices.data();
+	const int step = MESH_VERTEX_FLOATS;
+
+	for (int j = 0; j < ylat; ++j) {
+		double b = glm::radians(-90 + 180 * (double)(j) / (ylat - 1));
+		for (int i = 0; i < xlong; ++i) {
+			double a = glm::radians(360 * (double)(i) / (xlong - 1));
+			double z = glm::cos(b) * glm::cos(a);
+			double x = glm::cos(b) * glm::sin(a);
+			double y = glm::sin(b);
+			int base = j * xlong * step;
+			vertices[base + i * step + 0] = (float)(r * x);
+			vertices[base + i * step + 1] = (float)(r * y);
+			vertices[base + i * step + 2] = (float)(r * z);
+
+			vertices[base + i * step + 3] = (float)x;
+			vertices[base + i * step + 4] = (float)y;
+			vertices[base + i * step + 5] = (float)z;
+
+			vertices[base + i * step + 6] = (float)(i) / (float)(xlong - 1);
+			vertices[base + i * step + 7] = (float)(j) / (float)(ylat - 1);
+		}
+	}
+
+	mesh.indices.resize((xlong - 1) * (ylat - 1) * 6);
+	unsigned int* indices = mesh.indices.data();
+	for (int j = 0; j < ylat - 1; ++j) {
+		for (int i = 0; i < xlong - 1; ++i) {
+			int base = j * (xlong - 1) * 6;
+			indices[base + i * 6 + 0] = j * xlong + i;
+			indices[base + i * 6 + 1] = j * xlong + i + 1;
+			indices[base + i * 6 + 2] = (j + 1) * xlong + i + 1;
+			indices[base + i * 6 + 3] = j * xlong + i;
+			indices[base + i * 6 + 4] = (j + 1) * xlong + i + 1;
+			indices[base + i * 6 + 5] = (j + 1) * xlong + i;
+		}
+	}
+	return mesh;
+}
+
+// gpu copy of a MeshData, uploaded once and drawn as many times as needed
+class Mesh
+{
+public:
+	unsigned int VAO = 0;
+	unsigned int VBO = 0;
+	unsigned int EBO = 0;
+	unsigned int indexCount = 0;
+
+	Mesh() {}
+
+	Mesh(const MeshData& data) : Mesh(data.vertices.data(), data.vertexCount(), data.indices.data(), (unsigned int)data.indices.size()) {}
+
+	// vertexFloats apart, starting with the MESH_VERTEX_FLOATS layout. A 12 float vertex
+	// (cooked meshes) also has its tangent and bitangent sign as attribute 4.
+	Mesh(const float* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount, int vertexFloats = MESH_VERTEX_FLOATS)
+	{
+		if (vertexFloats >= 12)
+			*this = fromVertices<CookedVertexFormat>(vertices, vertexCount, indices, indexCount);
+		else
+			*this = fromVertices<MeshVertexFormat>(vertices, vertexCount, indices, indexCount);
+	}
+
+	// vertices already laid out as Format (vertexformat.h), such as a cooked file's
+	template <class Format>
+	static Mesh fromVertices(const void* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount)
+	{
+		Mesh mesh;
+		mesh.upload(vertices, (size_t)vertexCount * Format::stride, indices, indexCount);
+		Format::setup();
+		glBindVertexArray(0);
+		return mesh;
+	}
+
+	// float vertices of vertexFloats each packed into Format before upload
+	template <class Format>
+	static Mesh encoded(const MeshData& data, int vertexFloats = MESH_VERTEX_FLOATS, const VertexQuantization& quantization = VertexQuantization())
+	{
+		std::vector<unsigned char> vertices = Format::encode(data.vertices.data(), data.vertices.size() / vertexFloats, vertexFloats, quantization);
+		return fromVertices<Format>(vertices.data(), (unsigned int)(data.vertices.size() / vertexFloats), data.indices.data(), (unsigned int)data.indices.size());
+	}
+
+	void draw() const
+	{
+		glBindVertexArray(VAO);
+		glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (void*)0);
+		countDraw(indexCount);
+		countStateChange();
+		glBindVertexArray(0);
+	}
+
+	// one level of detail, or any other range of the indices
+	void drawRange(unsigned int firstIndex, unsigned int count) const
+	{
+		glBindVertexArray(VAO);
+		glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, (void*)(firstIndex * sizeof(unsigned int)));
+		countDraw(count);
+		countStateChange();
+		glBindVertexArray(0);
+	}
+
+private:
+	// buffers filled and the VAO left bound for the attribute setup
+	void upload(const void* vertices, size_t vertexBytes, const unsigned int* indices, unsigned int count)
+	{
+		indexCount = count;
+		size_t indexBytes = (size_t)count * sizeof(unsigned int);
+		glGenVertexArrays(1, &VAO);
+		glGenBuffers(1, &VBO);
+		glGenBuffers(1, &EBO);
+		glBindVertexArray(VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		glBufferData(GL_ARRAY_BUFFER, vertexBytes, vertices, GL_STATIC_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, indices, GL_STATIC_DRAW);
+		countUpload(vertexBytes + indexBytes);
+		countBufferMemory(vertexBytes + indexBytes);
+	}
+};
+#endif
@@ -0,0 +1,223 @@
+#ifndef MESHFILE_H
+#define MESHFILE_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "mappedfile.h"
+#include "mesh.h"
+#include "meshlet.h"
+
+const uint32_t MESH_FILE_MAGIC = 0x4853454D; // "MESH"
+const uint32_t MESH_FILE_VERSION = 4; // 2 added levels of detail, 3 compact vertex formats, 4 meshlets
+
+// position (3), normal (3), texture coords (2), tangent (3) and bitangent sign (1)
+const int COOKED_VERTEX_FLOATS = 12;
+
+// how the vertices are stored, each packed from the same COOKED_VERTEX_FLOATS floats
+enum CookedVertexLayout : uint32_t
+{
+	CookedFloatVertices, // CookedVertexFormat, 48 bytes
+	CookedCompactVertices, // CompactCookedVertexFormat, 24 bytes
+	CookedQuantizedVertices // QuantizedCookedVertexFormat, 20 bytes, positions across the bounds
+};
+
+// bytes a vertex, 0 for a layout this build does not know
+inline size_t cookedVertexStride(uint32_t layout)
+{
+	switch (layout) {
+	case CookedFloatVertices: return CookedVertexFormat::stride;
+	case CookedCompactVertices: return CompactCookedVertexFormat::stride;
+	case CookedQuantizedVertices: return QuantizedCookedVertexFormat::stride;
+	}
+	return 0;
+}
+const int COOKED_PATH_LENGTH = 128;
+
+// file layout, little endian: header, submeshes, vertices, indices, meshlets, each 16 byte aligned
+struct CookedMeshHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	uint32_t submeshCount;
+	uint32_t submeshOffset;
+	uint32_t vertexOffset;
+	uint32_t indexOffset;
+	float boundsMin[3];
+	float boundsMax[3];
+	uint32_t vertexLayout; // CookedVertexLayout
+	uint32_t meshletCount;
+	uint32_t meshletOffset;
+};
+
+// the part of the mesh drawn with one material, each level of detail a range of the indices
+struct CookedSubmesh
+{
+	uint32_t lodCount;
+	MeshLod lods[MAX_MESH_LODS]; // full detail first
+	char diffuse[COOKED_PATH_LENGTH]; // texture paths as loadTexture takes them, empty if none
+	char specular[COOKED_PATH_LENGTH];
+	uint32_t firstMeshlet[MAX_MESH_LODS]; // each level split into meshlets (meshlet.h)
+	uint32_t meshletCount[MAX_MESH_LODS];
+};
+
+// The bytes of a cooked mesh file, vertices are COOKED_VERTEX_FLOATS each and stored in
+// layout. Every level of every submesh is split into meshlets here, the submeshes' own
+// meshlet ranges are filled in.
+inline std::vector<unsigned char> buildCookedMesh(const std::vector<float>& vertices, const std::vector<uint32_t>& indices, std::vector<CookedSubmesh> submeshes,
+	CookedVertexLayout layout = CookedCompactVertices)
+{
+	auto aligned = [](size_t offset) { return (offset + 15) & ~(size_t)15; };
+
+	CookedMeshHeader header = {};
+	header.magic = MESH_FILE_MAGIC;
+	header.version = MESH_FILE_VERSION;
+	header.vertexCount = (uint32_t)(vertices.size() / COOKED_VERTEX_FLOATS);
+	header.indexCount = (uint32_t)indices.size();
+	header.submeshCount = (uint32_t)submeshes.size();
+	header.submeshOffset = (uint32_t)aligned(sizeof(CookedMeshHeader));
+	header.vertexOffset = (uint32_t)aligned(header.submeshOffset + submeshes.size() * sizeof(CookedSubmesh));
+	header.vertexLayout = layout;
+	header.indexOffset = (uint32_t)aligned(header.vertexOffset + header.vertexCount * cookedVertexStride(layout));
+
+	std::vector<Meshlet> meshlets;
+	for (CookedSubmesh& submesh : submeshes) {
+		for (uint32_t lod = 0; lod < submesh.lodCount; lod++) {
+			std::vector<Meshlet> level = buildMeshlets(vertices.data(), COOKED_VERTEX_FLOATS, header.vertexCount, indices.data(),
+				submesh.lods[lod].firstIndex, submesh.lods[lod].indexCount);
+			submesh.firstMeshlet[lod] = (uint32_t)meshlets.size();
+			submesh.meshletCount[lod] = (uint32_t)level.size();
+			meshlets.insert(meshlets.end(), level.begin(), level.end());
+		}
+	}
+	header.meshletCount = (uint32_t)meshlets.size();
+	header.meshletOffset = (uint32_t)aligned(header.indexOffset + indices.size() * sizeof(uint32_t));
+
+	glm::vec3 low(0.0f), high(0.0f);
+	for (uint32_t i = 0; i < header.vertexCount; i++) {
+		glm::vec3 position(vertices[i * COOKED_VERTEX_FLOATS], vertices[i * COOKED_VERTEX_FLOATS + 1], vertices[i * COOKED_VERTEX_FLOATS + 2]);
+		low = i == 0 ? position : glm::min(low, position);
+		high = i == 0 ? position : glm::max(high, position);
+	}
+	for (int i = 0; i < 3; i++) {
+		header.boundsMin[i] = low[i];
+		header.boundsMax[i] = high[i];
+	}
+
+	std::vector<unsigned char> packed;
+	if (layout == CookedFloatVertices)
+		packed = CookedVertexFormat::encode(vertices.data(), header.vertexCount, COOKED_VERTEX_FLOATS);
+	else if (layout == CookedCompactVertices)
+		packed = CompactCookedVertexFormat::encode(vertices.data(), header.vertexCount, COOKED_VERTEX_FLOATS);
+	else
+		packed = QuantizedCookedVertexFormat::encode(vertices.data(), header.vertexCount, COOKED_VERTEX_FLOATS, quantizationFromBounds(low, high));
+
+	std::vector<unsigned char> bytes(aligned(header.meshletOffset + meshlets.size() * sizeof(Meshlet)), 0);
+	std::memcpy(bytes.data(), &header, sizeof(header));
+	if (!submeshes.empty())
+		std::memcpy(bytes.data() + header.submeshOffset, submeshes.data(), submeshes.size() * sizeof(CookedSubmesh));
+	if (!packed.empty())
+		std::memcpy(bytes.data() + header.vertexOffset, packed.data(), packed.size());
+	if (!indices.empty())
+		std::memcpy(bytes.data() + header.indexOffset, indices.data(), indices.size() * sizeof(uint32_t));
+	if (!meshlets.empty())
+		std::memcpy(bytes.data() + header.meshletOffset, meshlets.data(), meshlets.size() * sizeof(Meshlet));
+	return bytes;
+}
+
+// A cooked mesh mapped from disk. Opening checks the header and that every index is in
+// range, the vertex and index data are then handed to gl straight from the mapping.
+class CookedMesh
+{
+public:
+	bool open(const std::string& path)
+	{
+		if (!file.open(path))
+			return false;
+		if (!validate()) {
+			std::cout << "ERROR::COOKEDMESH::INVALID_DATA: " << path << std::endl;
+			file.close();
+			return false;
+		}
+		return true;
+	}
+
+	bool isOpen() const { return file.isOpen(); }
+	const CookedMeshHeader& header() const { return *(const CookedMeshHeader*)file.data(); }
+	const unsigned char* vertices() const { return file.data() + header().vertexOffset; }
+	const uint32_t* indices() const { return (const uint32_t*)(file.data() + header().indexOffset); }
+	const CookedSubmesh& submesh(int i) const { return ((const CookedSubmesh*)(file.data() + header().submeshOffset))[i]; }
+	const Meshlet* meshlets() const { return (const Meshlet*)(file.data() + header().meshletOffset); }
+	size_t size() const { return file.size(); }
+	size_t vertexStride() const { return cookedVertexStride(header().vertexLayout); }
+
+	// the vertices and indices handed to gl straight from the mapping, in the stored layout
+	Mesh upload() const
+	{
+		const CookedMeshHeader& h = header();
+		if (h.vertexLayout == CookedFloatVertices)
+			return Mesh::fromVertices<CookedVertexFormat>(vertices(), h.vertexCount, indices(), h.indexCount);
+		if (h.vertexLayout == CookedCompactVertices)
+			return Mesh::fromVertices<CompactCookedVertexFormat>(vertices(), h.vertexCount, indices(), h.indexCount);
+		return Mesh::fromVertices<QuantizedCookedVertexFormat>(vertices(), h.vertexCount, indices(), h.indexCount);
+	}
+
+	// stored positions to model space, goes between the model matrix and the vertices.
+	// Identity unless the positions are quantized.
+	glm::mat4 dequantize() const
+	{
+		const CookedMeshHeader& h = header();
+		if (h.vertexLayout != CookedQuantizedVertices)
+			return glm::mat4(1.0f);
+		return dequantizeMatrix(quantizationFromBounds(glm::vec3(h.boundsMin[0], h.boundsMin[1], h.boundsMin[2]),
+			glm::vec3(h.boundsMax[0], h.boundsMax[1], h.boundsMax[2])));
+	}
+
+private:
+	MappedFile file;
+
+	bool validate() const
+	{
+		if (file.size() < sizeof(CookedMeshHeader))
+			return false;
+		const CookedMeshHeader& h = header();
+		if (h.magic != MESH_FILE_MAGIC || h.version != MESH_FILE_VERSION || cookedVertexStride(h.vertexLayout) == 0)
+			return false;
+		if ((uint64_t)h.submeshOffset + (uint64_t)h.submeshCount * sizeof(CookedSubmesh) > file.size()
+			|| (uint64_t)h.vertexOffset + (uint64_t)h.vertexCount * cookedVertexStride(h.vertexLayout) > file.size()
+			|| (uint64_t)h.indexOffset + (uint64_t)h.indexCount * sizeof(uint32_t) > file.size()
+			|| (uint64_t)h.meshletOffset + (uint64_t)h.meshletCount * sizeof(Meshlet) > file.size())
+			return false;
+		for (uint32_t i = 0; i < h.indexCount; i++) {
+			if (indices()[i] >= h.vertexCount)
+				return false;
+		}
+		for (uint32_t i = 0; i < h.submeshCount; i++) {
+			const CookedSubmesh& part = submesh(i);
+			if (part.lodCount < 1 || part.lodCount > MAX_MESH_LODS
+				|| part.diffuse[COOKED_PATH_LENGTH - 1] != 0 || part.specular[COOKED_PATH_LENGTH - 1] != 0)
+				return false;
+			for (uint32_t lod = 0; lod < part.lodCount; lod++) {
+				if ((uint64_t)part.lods[lod].firstIndex + part.lods[lod].indexCount > h.indexCount
+					|| (uint64_t)part.firstMeshlet[lod] + part.meshletCount[lod] > h.meshletCount)
+					return false;
+				// meshlets draw ranges of their level and nothing else
+				for (uint32_t m = part.firstMeshlet[lod]; m < part.firstMeshlet[lod] + part.meshletCount[lod]; m++) {
+					const Meshlet& meshlet = meshlets()[m];
+					if (meshlet.firstIndex < part.lods[lod].firstIndex
+						|| (uint64_t)meshlet.firstIndex + meshlet.indexCount > (uint64_t)part.lods[lod].firstIndex + part.lods[lod].indexCount)
+						return false;
+				}
+			}
+		}
+		return true;
+	}
+};
+#endif
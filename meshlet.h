@@ -0,0 +1,236 @@
+#ifndef MESHLET_H
+#define MESHLET_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "frustum.h"
+
+// same instruction set detection as animation.h, 4 meshlets a test either way
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MESHLET_SIMD_SSE2
+#endif
+
+// limits of one meshlet, sized for mesh shader hardware so the same split would carry over
+const int MESHLET_MAX_VERTICES = 64;
+const int MESHLET_MAX_TRIANGLES = 124;
+
+// below this normal spread a cone can't cull anything, so none is kept
+const float MESHLET_MIN_CONE_DOT = 0.1f;
+
+// A run of triangles of one level of detail, stored as is in cooked files. The cone holds
+// every triangle normal, coneCutoff is the sine of its half angle, 1 if it culls nothing.
+struct Meshlet
+{
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	float center[3];
+	float radius;
+	float coneAxis[3];
+	float coneCutoff;
+};
+
+inline Meshlet meshletBounds(const float* vertices, int vertexFloats, const uint32_t* indices, uint32_t firstIndex, uint32_t indexCount)
+{
+	Meshlet meshlet = {};
+	meshlet.firstIndex = firstIndex;
+	meshlet.indexCount = indexCount;
+	auto position = [&](uint32_t v) { return glm::vec3(vertices[(size_t)v * vertexFloats], vertices[(size_t)v * vertexFloats + 1], vertices[(size_t)v * vertexFloats + 2]); };
+
+	glm::vec3 low = position(indices[firstIndex]), high = low;
+	for (uint32_t i = firstIndex; i < firstIndex + indexCount; i++) {
+		low = glm::min(low, position(indices[i]));
+		high = glm::max(high, position(indices[i]));
+	}
+	glm::vec3 center = (low + high) * 0.5f;
+	float radius = 0.0f;
+	for (uint32_t i = firstIndex; i < firstIndex + indexCount; i++)
+		radius = glm::max(radius, glm::length(position(indices[i]) - center));
+
+	std::vector<glm::vec3> normals;
+	normals.reserve(indexCount / 3);
+	glm::vec3 axis(0.0f);
+	for (uint32_t i = firstIndex; i + 2 < firstIndex + indexCount; i += 3) {
+		glm::vec3 a = position(indices[i]), b = position(indices[i + 1]), c = position(indices[i + 2]);
+		glm::vec3 normal = glm::cross(b - a, c - a);
+		float length = glm::length(normal);
+		if (length <= 0.0f)
+			continue; // degenerate triangles face nowhere
+		normals.push_back(normal / length);
+		axis += normal / length;
+	}
+	float minimumDot = 1.0f;
+	float axisLength = glm::length(axis);
+	if (axisLength > 0.0f) {
+		axis /= axisLength;
+		for (const glm::vec3& normal : normals)
+			minimumDot = glm::min(minimumDot, glm::dot(normal, axis));
+	}
+
+	for (int i = 0; i < 3; i++)
+		meshlet.center[i] = center[i];
+	meshlet.radius = radius;
+	if (axisLength <= 0.0f || minimumDot <= MESHLET_MIN_CONE_DOT) {
+		meshlet.coneCutoff = 1.0f; // axis 0, the test never passes
+	}
+	else {
+		for (int i = 0; i < 3; i++)
+			meshlet.coneAxis[i] = axis[i];
+		meshlet.coneCutoff = std::sqrt(1.0f - minimumDot * minimumDot);
+	}
+	return meshlet;
+}
+
+// Splits a range of indices into meshlets in the order the triangles already are, starting
+// a new one when the next triangle would go over either limit. The range is put in vertex
+// cache order first (meshoptimize.h), which keeps neighbouring triangles together, so the
+// index buffer stays as it is and every meshlet is a range of it.
+inline std::vector<Meshlet> buildMeshlets(const float* vertices, int vertexFloats, size_t vertexCount, const uint32_t* indices, uint32_t firstIndex, uint32_t indexCount)
+{
+	std::vector<Meshlet> meshlets;
+	std::vector<uint32_t> usedBy(vertexCount, ~0u); // meshlet that last took each vertex
+	uint32_t start = firstIndex;
+	int vertexTotal = 0;
+	for (uint32_t i = firstIndex; i + 2 < firstIndex + indexCount; i += 3) {
+		uint32_t id = (uint32_t)meshlets.size();
+		int added = 0;
+		for (int k = 0; k < 3; k++)
+			added += usedBy[indices[i + k]] != id ? 1 : 0;
+		if (i > start && (vertexTotal + added > MESHLET_MAX_VERTICES || (i - start) / 3 + 1 > (uint32_t)MESHLET_MAX_TRIANGLES)) {
+			meshlets.push_back(meshletBounds(vertices, vertexFloats, indices, start, i - start));
+			start = i;
+			vertexTotal = 0;
+			id++;
+		}
+		for (int k = 0; k < 3; k++) {
+			if (usedBy[indices[i + k]] != id) {
+				usedBy[indices[i + k]] = id;
+				vertexTotal++;
+			}
+		}
+	}
+	if (firstIndex + indexCount > start)
+		meshlets.push_back(meshletBounds(vertices, vertexFloats, indices, start, firstIndex + indexCount - start));
+	return meshlets;
+}
+
+// The meshlets of one level laid out for culling 4 at a time, and the draw ranges the
+// visible ones make. Everything is sized when it is built, culling never allocates.
+class MeshletSet
+{
+public:
+	MeshletSet() {}
+
+	MeshletSet(const Meshlet* meshlets, size_t count) : count(count)
+	{
+		size_t padded = (count + 3) & ~(size_t)3;
+		for (std::vector<float>* lane : { &centerX, &centerY, &centerZ, &radius, &axisX, &axisY, &axisZ, &cutoff })
+			lane->assign(padded, 0.0f);
+		first.resize(count);
+		indexCounts.resize(count);
+		for (size_t i = 0; i < count; i++) {
+			centerX[i] = meshlets[i].center[0];
+			centerY[i] = meshlets[i].center[1];
+			centerZ[i] = meshlets[i].center[2];
+			radius[i] = meshlets[i].radius;
+			axisX[i] = meshlets[i].coneAxis[0];
+			axisY[i] = meshlets[i].coneAxis[1];
+			axisZ[i] = meshlets[i].coneAxis[2];
+			cutoff[i] = meshlets[i].coneCutoff;
+			first[i] = meshlets[i].firstIndex;
+			indexCounts[i] = meshlets[i].indexCount;
+		}
+		drawCounts.reserve(count);
+		drawOffsets.reserve(count);
+	}
+
+	size_t size() const { return count; }
+
+	// Culls against the frustum and camera position, both in the meshlet's model space.
+	// Visible meshlets next to each other in the index buffer become one range, the ranges
+	// are left in counts() and offsets() ready for glMultiDrawElements. Returns how many.
+	int cull(const Frustum& frustum, const glm::vec3& camera)
+	{
+		drawCounts.clear();
+		drawOffsets.clear();
+		visibleTriangles = 0;
+		visibleMeshlets = 0;
+		for (size_t base = 0; base < count; base += 4) {
+			int mask = visibleMask(frustum, camera, base);
+			for (size_t lane = 0; lane < 4 && base + lane < count; lane++) {
+				if (mask & (1 << lane))
+					addRange(base + lane);
+			}
+		}
+		return (int)drawCounts.size();
+	}
+
+	const GLsizei* counts() const { return drawCounts.data(); }
+	const void* const* offsets() const { return drawOffsets.data(); }
+	unsigned int triangles() const { return visibleTriangles; }
+	int visible() const { return visibleMeshlets; }
+
+private:
+	size_t count = 0;
+	std::vector<float> centerX, centerY, centerZ, radius, axisX, axisY, axisZ, cutoff;
+	std::vector<uint32_t> first, indexCounts;
+	std::vector<GLsizei> drawCounts;
+	std::vector<const void*> drawOffsets;
+	unsigned int visibleTriangles = 0;
+	int visibleMeshlets = 0;
+
+	void addRange(size_t meshlet)
+	{
+		visibleTriangles += indexCounts[meshlet] / 3;
+		visibleMeshlets++;
+		const void* offset = (const void*)((size_t)first[meshlet] * sizeof(uint32_t));
+		if (!drawCounts.empty() && (const char*)drawOffsets.back() + drawCounts.back() * sizeof(uint32_t) == offset) {
+			drawCounts.back() += indexCounts[meshlet];
+			return;
+		}
+		drawCounts.push_back((GLsizei)indexCounts[meshlet]);
+		drawOffsets.push_back(offset);
+	}
+
+	// bit per lane of base..base+3 that is inside the frustum and not facing away
+#if defined(MESHLET_SIMD_SSE2)
+	int visibleMask(const Frustum& frustum, const glm::vec3& camera, size_t base) const
+	{
+		__m128 x = _mm_loadu_ps(&centerX[base]), y = _mm_loadu_ps(&centerY[base]), z = _mm_loadu_ps(&centerZ[base]);
+		__m128 r = _mm_loadu_ps(&radius[base]);
+		__m128 negativeR = _mm_sub_ps(_mm_setzero_ps(), r);
+		__m128 outside = _mm_setzero_ps();
+		for (const glm::vec4& plane : frustum.planes) {
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)), _mm_mul_ps(y, _mm_set1_ps(plane.y))),
+				_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negativeR));
+		}
+		__m128 dx = _mm_sub_ps(x, _mm_set1_ps(camera.x)), dy = _mm_sub_ps(y, _mm_set1_ps(camera.y)), dz = _mm_sub_ps(z, _mm_set1_ps(camera.z));
+		__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+		__m128 along = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, _mm_loadu_ps(&axisX[base])), _mm_mul_ps(dy, _mm_loadu_ps(&axisY[base]))),
+			_mm_mul_ps(dz, _mm_loadu_ps(&axisZ[base])));
+		__m128 away = _mm_cmpge_ps(along, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&cutoff[base]), length), r));
+		return ~_mm_movemask_ps(_mm_or_ps(outside, away)) & 0xF;
+	}
+#else
+	int visibleMask(const Frustum& frustum, const glm::vec3& camera, size_t base) const
+	{
+		int mask = 0;
+		for (size_t lane = 0; lane < 4; lane++) {
+			size_t i = base + lane;
+			glm::vec3 center(centerX[i], centerY[i], centerZ[i]);
+			glm::vec3 toCenter = center - camera;
+			bool away = glm::dot(toCenter, glm::vec3(axisX[i], axisY[i], axisZ[i])) >= cutoff[i] * glm::length(toCenter) + radius[i];
+			if (!away && frustum.intersectsSphere(center, radius[i]))
+				mask |= 1 << lane;
+		}
+		return mask;
+	}
+#endif
+};
+#endif
@@ -0,0 +1,396 @@
+#ifndef MESHLOD_H
+#define MESHLOD_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "mesh.h"
+
+// position, normal and texture coords, the part of every vertex layout the error measures
+const int LOD_ATTRIBUTES = 8;
+
+// how far normals and texture coords may move for the same cost as positions, in mesh radii
+const float LOD_NORMAL_WEIGHT = 0.5f;
+const float LOD_UV_WEIGHT = 0.5f;
+
+// a level is drawn once its error projects to less than this many pixels
+const float LOD_PIXEL_ERROR = 1.0f;
+
+// no level is kept that moves the surface further than this fraction of the mesh radius,
+// it would only be drawn at a pixel or two across
+const float LOD_MAX_RELATIVE_ERROR = 0.25f;
+
+// Edge collapse simplification driven by quadric error metrics (Garland and Heckbert). Each
+// vertex is a point in 8 dimensions, position plus weighted normal and texture coords, so
+// the error covers shading and texturing as well as shape. Vertices only ever collapse onto
+// neighbours, every level indexes the original vertices and attributes are never
+// interpolated. Vertices on a border, a non manifold edge or a seam (a position shared by
+// vertices with different normals or texture coords) stay where they are so no cracks open.
+class QuadricSimplifier
+{
+public:
+	// vertices vertexFloats apart, starting with the MESH_VERTEX_FLOATS layout
+	QuadricSimplifier(const float* vertices, unsigned int vertexCount, int vertexFloats, const unsigned int* indices, unsigned int indexCount)
+		: points(vertexCount * LOD_ATTRIBUTES), positionIds(vertexCount, 0), locked(vertexCount, false), quadrics(vertexCount)
+	{
+		std::map<std::tuple<float, float, float>, unsigned int> positions;
+		glm::vec3 low(0.0f), high(0.0f);
+		for (unsigned int i = 0; i < indexCount; i++) {
+			const float* v = vertices + (size_t)indices[i] * vertexFloats;
+			glm::vec3 position(v[0], v[1], v[2]);
+			low = i == 0 ? position : glm::min(low, position);
+			high = i == 0 ? position : glm::max(high, position);
+		}
+		radius = glm::max((double)glm::length(high - low) * 0.5, 1e-6);
+
+		// one id per distinct position, a seam is a position used by more than one vertex
+		std::vector<unsigned int> positionUsers;
+		std::vector<bool> seen(vertexCount, false);
+		for (unsigned int i = 0; i < indexCount; i++) {
+			unsigned int index = indices[i];
+			if (seen[index])
+				continue;
+			seen[index] = true;
+			const float* v = vertices + (size_t)index * vertexFloats;
+			auto found = positions.insert(std::make_pair(std::make_tuple(v[0], v[1], v[2]), (unsigned int)positions.size()));
+			positionIds[index] = found.first->second;
+			if (found.second)
+				positionUsers.push_back(0);
+			positionUsers[positionIds[index]]++;
+			double* point = &points[(size_t)index * LOD_ATTRIBUTES];
+			for (int a = 0; a < 3; a++) {
+				point[a] = v[a];
+				point[3 + a] = v[3 + a] * LOD_NORMAL_WEIGHT * radius;
+			}
+			point[6] = v[6] * LOD_UV_WEIGHT * radius;
+			point[7] = v[7] * LOD_UV_WEIGHT * radius;
+		}
+		for (unsigned int index = 0; index < vertexCount; index++) {
+			if (seen[index] && positionUsers[positionIds[index]] > 1)
+				locked[index] = true;
+		}
+
+		// edges between positions, anything not shared by exactly two triangles is a border
+		std::map<std::pair<unsigned int, unsigned int>, int> edges;
+		for (unsigned int t = 0; t + 2 < indexCount; t += 3) {
+			if (degenerate(indices[t], indices[t + 1], indices[t + 2]))
+				continue;
+			current.insert(current.end(), indices + t, indices + t + 3);
+			for (int e = 0; e < 3; e++) {
+				unsigned int a = positionIds[indices[t + e]], b = positionIds[indices[t + (e + 1) % 3]];
+				edges[std::make_pair(std::min(a, b), std::max(a, b))]++;
+			}
+			addTriangleQuadric(indices[t], indices[t + 1], indices[t + 2]);
+		}
+		std::vector<bool> borderPosition(positions.size(), false);
+		for (const auto& edge : edges) {
+			if (edge.second != 2) {
+				borderPosition[edge.first.first] = true;
+				borderPosition[edge.first.second] = true;
+			}
+		}
+		for (unsigned int index = 0; index < vertexCount; index++) {
+			if (seen[index] && borderPosition[positionIds[index]])
+				locked[index] = true;
+		}
+	}
+
+	// Collapses the cheapest edges until at most targetIndexCount indices are left, or no
+	// collapse is possible without moving a locked vertex or flipping a triangle. Runs in
+	// passes, each collapsing every independent edge it can in order of cost.
+	void simplify(unsigned int targetIndexCount)
+	{
+		struct Collapse {
+			unsigned int from;
+			unsigned int to;
+			double cost;
+		};
+		std::vector<Collapse> collapses;
+		std::vector<unsigned int> firstTriangle, triangles;
+		std::vector<unsigned int> remap(locked.size());
+		std::vector<bool> touched(locked.size());
+		while (current.size() > targetIndexCount) {
+			buildAdjacency(firstTriangle, triangles);
+			collapses.clear();
+			for (size_t t = 0; t < current.size(); t += 3) {
+				for (int e = 0; e < 3; e++) {
+					unsigned int a = current[t + e], b = current[t + (e + 1) % 3];
+					if (!locked[a])
+						collapses.push_back({ a, b, collapseCost(a, b) });
+					if (!locked[b])
+						collapses.push_back({ b, a, collapseCost(b, a) });
+				}
+			}
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+			for (size_t i = 0; i < remap.size(); i++)
+				remap[i] = (unsigned int)i;
+			std::fill(touched.begin(), touched.end(), false);
+			size_t removable = (current.size() - targetIndexCount + 2) / 3;
+			size_t removed = 0;
+			for (const Collapse& collapse : collapses) {
+				if (removed >= removable)
+					break;
+				if (touched[collapse.from] || touched[collapse.to] || flips(collapse.from, collapse.to, firstTriangle, triangles))
+					continue;
+				// the triangles around from change shape, so none of their corners move again this pass
+				for (unsigned int i = firstTriangle[collapse.from]; i < firstTriangle[collapse.from + 1]; i++) {
+					const unsigned int* triangle = &current[triangles[i] * 3];
+					bool shared = false;
+					for (int c = 0; c < 3; c++) {
+						touched[triangle[c]] = true;
+						shared = shared || triangle[c] == collapse.to;
+					}
+					if (shared)
+						removed++;
+				}
+				remap[collapse.from] = collapse.to;
+				addQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+				maxCost = std::max(maxCost, collapse.cost);
+			}
+			if (removed == 0)
+				break;
+
+			size_t kept = 0;
+			for (size_t t = 0; t < current.size(); t += 3) {
+				unsigned int a = remap[current[t]], b = remap[current[t + 1]], c = remap[current[t + 2]];
+				if (degenerate(a, b, c))
+					continue;
+				current[kept++] = a;
+				current[kept++] = b;
+				current[kept++] = c;
+			}
+			current.resize(kept);
+		}
+	}
+
+	const std::vector<unsigned int>& indices() const { return current; }
+
+	// largest distance any collapse so far moved the surface, in mesh units
+	float error() const { return (float)std::sqrt(maxCost); }
+
+	// half the diagonal of the bounds of the indexed vertices
+	float meshRadius() const { return (float)radius; }
+
+private:
+	// upper triangle of the symmetric matrix A, then b and c of v'Av + 2b'v + c, and the
+	// total triangle area so the cost is a mean squared distance
+	struct Quadric {
+		double a[LOD_ATTRIBUTES * (LOD_ATTRIBUTES + 1) / 2];
+		double b[LOD_ATTRIBUTES];
+		double c;
+		double weight;
+	};
+
+	std::vector<double> points;
+	std::vector<unsigned int> positionIds;
+	std::vector<bool> locked;
+	std::vector<Quadric> quadrics;
+	std::vector<unsigned int> current;
+	double maxCost = 0.0;
+	double radius = 0.0;
+
+	bool degenerate(unsigned int a, unsigned int b, unsigned int c) const
+	{
+		return positionIds[a] == positionIds[b] || positionIds[b] == positionIds[c] || positionIds[a] == positionIds[c];
+	}
+
+	glm::dvec3 position(unsigned int index) const
+	{
+		const double* point = &points[(size_t)index * LOD_ATTRIBUTES];
+		return glm::dvec3(point[0], point[1], point[2]);
+	}
+
+	static void addQuadric(Quadric& to, const Quadric& from)
+	{
+		for (int i = 0; i < LOD_ATTRIBUTES * (LOD_ATTRIBUTES + 1) / 2; i++)
+			to.a[i] += from.a[i];
+		for (int i = 0; i < LOD_ATTRIBUTES; i++)
+			to.b[i] += from.b[i];
+		to.c += from.c;
+		to.weight += from.weight;
+	}
+
+	// squared distance to the plane of the triangle in attribute space, weighted by its area
+	void addTriangleQuadric(unsigned int i0, unsigned int i1, unsigned int i2)
+	{
+		const double* p = &points[(size_t)i0 * LOD_ATTRIBUTES];
+		const double* q = &points[(size_t)i1 * LOD_ATTRIBUTES];
+		const double* r = &points[(size_t)i2 * LOD_ATTRIBUTES];
+		double e1[LOD_ATTRIBUTES], e2[LOD_ATTRIBUTES];
+		double length1 = 0.0, along = 0.0, length2 = 0.0;
+		for (int i = 0; i < LOD_ATTRIBUTES; i++) {
+			e1[i] = q[i] - p[i];
+			length1 += e1[i] * e1[i];
+		}
+		length1 = std::sqrt(length1);
+		if (length1 < 1e-12)
+			return;
+		for (int i = 0; i < LOD_ATTRIBUTES; i++) {
+			e1[i] /= length1;
+			along += e1[i] * (r[i] - p[i]);
+		}
+		for (int i = 0; i < LOD_ATTRIBUTES; i++) {
+			e2[i] = r[i] - p[i] - along * e1[i];
+			length2 += e2[i] * e2[i];
+		}
+		length2 = std::sqrt(length2);
+		if (length2 < 1e-12)
+			return;
+		for (int i = 0; i < LOD_ATTRIBUTES; i++)
+			e2[i] /= length2;
+
+		double area = glm::length(glm::cross(position(i1) - position(i0), position(i2) - position(i0))) * 0.5;
+		double pe1 = 0.0, pe2 = 0.0, pp = 0.0;
+		for (int i = 0; i < LOD_ATTRIBUTES; i++) {
+			pe1 += p[i] * e1[i];
+			pe2 += p[i] * e2[i];
+			pp += p[i] * p[i];
+		}
+		Quadric quadric;
+		int k = 0;
+		for (int i = 0; i < LOD_ATTRIBUTES; i++) {
+			for (int j = i; j < LOD_ATTRIBUTES; j++)
+				quadric.a[k++] = area * ((i == j ? 1.0 : 0.0) - e1[i] * e1[j] - e2[i] * e2[j]);
+			quadric.b[i] = area * (pe1 * e1[i] + pe2 * e2[i] - p[i]);
+		}
+		quadric.c = area * (pp - pe1 * pe1 - pe2 * pe2);
+		quadric.weight = area;
+		addQuadric(quadrics[i0], quadric);
+		addQuadric(quadrics[i1], quadric);
+		addQuadric(quadrics[i2], quadric);
+	}
+
+	// mean squared error of moving from onto to, under both vertices' quadrics
+	double collapseCost(unsigned int from, unsigned int to) const
+	{
+		const Quadric& qa = quadrics[from];
+		const Quadric& qb = quadrics[to];
+		const double* v = &points[(size_t)to * LOD_ATTRIBUTES];
+		double sum = qa.c + qb.c;
+		int k = 0;
+		for (int i = 0; i < LOD_ATTRIBUTES; i++) {
+			for (int j = i; j < LOD_ATTRIBUTES; j++, k++)
+				sum += (qa.a[k] + qb.a[k]) * v[i] * v[j] * (i == j ? 1.0 : 2.0);
+			sum += 2.0 * (qa.b[i] + qb.b[i]) * v[i];
+		}
+		double weight = qa.weight + qb.weight;
+		return weight > 0.0 ? std::max(sum / weight, 0.0) : 0.0;
+	}
+
+	// the triangles of every vertex, in compressed rows
+	void buildAdjacency(std::vector<unsigned int>& firstTriangle, std::vector<unsigned int>& triangles) const
+	{
+		firstTriangle.assign(locked.size() + 1, 0);
+		for (unsigned int index : current)
+			firstTriangle[index + 1]++;
+		for (size_t i = 1; i < firstTriangle.size(); i++)
+			firstTriangle[i] += firstTriangle[i - 1];
+		triangles.resize(current.size());
+		std::vector<unsigned int> filled(firstTriangle.begin(), firstTriangle.end() - 1);
+		for (size_t i = 0; i < current.size(); i++)
+			triangles[filled[current[i]]++] = (unsigned int)(i / 3);
+	}
+
+	// true if moving from onto to turns any triangle that survives the collapse over, or nearly
+	bool flips(unsigned int from, unsigned int to, const std::vector<unsigned int>& firstTriangle, const std::vector<unsigned int>& triangles) const
+	{
+		for (unsigned int i = firstTriangle[from]; i < firstTriangle[from + 1]; i++) {
+			const unsigned int* triangle = &current[triangles[i] * 3];
+			if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+				continue; // removed by the collapse
+			glm::dvec3 corners[3], moved[3];
+			for (int c = 0; c < 3; c++) {
+				corners[c] = position(triangle[c]);
+				moved[c] = triangle[c] == from ? position(to) : corners[c];
+			}
+			glm::dvec3 before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+			glm::dvec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+			// turning more than about 75 degrees folds the surface even if it does not flip
+			if (glm::dot(before, after) <= 0.25 * glm::length(before) * glm::length(after))
+				return true;
+		}
+		return false;
+	}
+};
+
+// Simplifies indices[first, first + count) into coarser levels appended to indices, each
+// about half the one before. lods[0] is the range given. Stops at maxLods, once locked
+// vertices keep a level from shrinking or once the error grows past
+// LOD_MAX_RELATIVE_ERROR. Returns the number of levels.
+inline int appendLods(const float* vertices, unsigned int vertexCount, int vertexFloats, std::vector<unsigned int>& indices,
+	unsigned int first, unsigned int count, MeshLod* lods, int maxLods = MAX_MESH_LODS)
+{
+	lods[0] = { first, count, 0.0f };
+	QuadricSimplifier simplifier(vertices, vertexCount, vertexFloats, indices.data() + first, count);
+	int levels = 1;
+	while (levels < maxLods) {
+		unsigned int target = lods[levels - 1].indexCount / 6 * 3;
+		if (target < 3)
+			break;
+		simplifier.simplify(target);
+		const std::vector<unsigned int>& simplified = simplifier.indices();
+		if (simplified.empty() || simplified.size() > (size_t)lods[levels - 1].indexCount * 9 / 10
+			|| simplifier.error() > LOD_MAX_RELATIVE_ERROR * simplifier.meshRadius())
+			break;
+		lods[levels++] = { (unsigned int)indices.size(), (unsigned int)simplified.size(), simplifier.error() };
+		indices.insert(indices.end(), simplified.begin(), simplified.end());
+	}
+	return levels;
+}
+
+// a mesh with its levels of detail, one vertex buffer and each level a range of its indices
+struct MeshLodChain
+{
+	MeshData mesh;
+	MeshLod lods[MAX_MESH_LODS];
+	int lodCount = 0;
+
+	// one level as a mesh of its own, for code that takes MeshData
+	MeshData level(int lod) const
+	{
+		MeshData data;
+		data.vertices = mesh.vertices;
+		data.indices.assign(mesh.indices.begin() + lods[lod].firstIndex, mesh.indices.begin() + lods[lod].firstIndex + lods[lod].indexCount);
+		return data;
+	}
+};
+
+inline MeshLodChain buildLodChain(const MeshData& mesh)
+{
+	MeshLodChain chain;
+	chain.mesh = mesh;
+	chain.lodCount = appendLods(mesh.vertices.data(), mesh.vertexCount(), MESH_VERTEX_FLOATS, chain.mesh.indices,
+		0, (unsigned int)mesh.indices.size(), chain.lods);
+	return chain;
+}
+
+// largest axis scale of a model matrix, how much it grows errors measured in mesh units
+inline float modelScale(const glm::mat4& model)
+{
+	return glm::max(glm::length(glm::vec3(model[0])), glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+}
+
+// Screen pixels one mesh unit covers at center, for a mesh drawn scale times its size, from
+// the vertical field of view in projection.
+inline float lodPixelsPerUnit(const glm::mat4& projection, const glm::mat4& view, const glm::vec3& center, float scale, float viewportHeight)
+{
+	float distance = glm::length(glm::vec3(view * glm::vec4(center, 1.0f)));
+	return projection[1][1] * viewportHeight * 0.5f * scale / glm::max(distance, 0.001f);
+}
+
+// the coarsest level whose error stays under LOD_PIXEL_ERROR pixels
+inline int selectLod(const MeshLod* lods, int lodCount, float pixelsPerUnit)
+{
+	int lod = 0;
+	while (lod + 1 < lodCount && lods[lod + 1].error * pixelsPerUnit <= LOD_PIXEL_ERROR)
+		lod++;
+	return lod;
+}
+#endif
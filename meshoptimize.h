@@ -0,0 +1,314 @@
+#ifndef MESHOPTIMIZE_H
+#define MESHOPTIMIZE_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+#include "mesh.h"
+
+// post transform cache modelled when ordering and measuring, a FIFO of this many vertices
+const int MESH_CACHE_SIZE = 16;
+
+// cluster order is kept only if the cache costs at most this much more than without it
+const float MESH_OVERDRAW_THRESHOLD = 1.05f;
+
+// transformed vertices of one index order through a FIFO cache
+struct MeshCacheStats {
+	size_t transformed = 0;
+	size_t triangles = 0;
+	size_t vertices = 0; // distinct vertices referenced
+
+	// average cache miss ratio, vertices transformed per triangle, 0.5 at best on large meshes
+	float acmr() const { return triangles == 0 ? 0.0f : (float)transformed / triangles; }
+	// average transform to vertex ratio, 1 when every vertex is transformed once
+	float atvr() const { return vertices == 0 ? 0.0f : (float)transformed / vertices; }
+
+	void add(const MeshCacheStats& other)
+	{
+		transformed += other.transformed;
+		triangles += other.triangles;
+		vertices += other.vertices;
+	}
+};
+
+struct MeshOptimizeReport {
+	size_t verticesBefore = 0;
+	size_t verticesAfter = 0;
+	MeshCacheStats before;
+	MeshCacheStats after;
+};
+
+inline MeshCacheStats analyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount, int cacheSize = MESH_CACHE_SIZE)
+{
+	MeshCacheStats stats;
+	std::vector<size_t> cachedAt(vertexCount, 0); // when each vertex went into the fifo, 0 if never
+	std::vector<bool> seen(vertexCount, false);
+	size_t time = (size_t)cacheSize + 1;
+	for (size_t i = 0; i < indexCount; i++) {
+		unsigned int v = indices[i];
+		if (cachedAt[v] == 0 || time - cachedAt[v] > (size_t)cacheSize) {
+			cachedAt[v] = time++;
+			stats.transformed++;
+		}
+		if (!seen[v]) {
+			seen[v] = true;
+			stats.vertices++;
+		}
+	}
+	stats.triangles = indexCount / 3;
+	return stats;
+}
+
+// Merges vertices whose every float is bit for bit the same. Returns the vertex count left.
+inline size_t deduplicateVertices(std::vector<float>& vertices, int vertexFloats, std::vector<unsigned int>& indices)
+{
+	size_t count = vertices.size() / vertexFloats;
+	const size_t bytes = vertexFloats * sizeof(float);
+	std::vector<unsigned int> order(count);
+	std::iota(order.begin(), order.end(), 0u);
+	std::sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) {
+		int compare = std::memcmp(&vertices[(size_t)a * vertexFloats], &vertices[(size_t)b * vertexFloats], bytes);
+		return compare < 0 || (compare == 0 && a < b);
+	});
+	// every vertex points at the first of its duplicates, which keeps its place
+	std::vector<unsigned int> remap(count);
+	for (size_t i = 0; i < count; i++) {
+		bool same = i > 0 && std::memcmp(&vertices[(size_t)order[i] * vertexFloats], &vertices[(size_t)order[i - 1] * vertexFloats], bytes) == 0;
+		remap[order[i]] = same ? remap[order[i - 1]] : order[i];
+	}
+	std::vector<unsigned int> packed(count, 0);
+	size_t kept = 0;
+	for (size_t v = 0; v < count; v++) {
+		if (remap[v] != v)
+			continue;
+		packed[v] = (unsigned int)kept;
+		std::memmove(&vertices[kept * vertexFloats], &vertices[v * vertexFloats], bytes);
+		kept++;
+	}
+	vertices.resize(kept * vertexFloats);
+	for (unsigned int& index : indices)
+		index = packed[remap[index]];
+	return kept;
+}
+
+// Tipsify (Sander, Nehab and Barczak 2007): fans around one vertex at a time, moving on to
+// a neighbour still in the cache. Linear time. The first triangle of every cluster, where
+// the walk had to jump because no neighbour was left in the cache, goes in clusters.
+inline std::vector<unsigned int> tipsifyOrder(const unsigned int* indices, size_t indexCount, size_t vertexCount, std::vector<size_t>& clusters,
+	int cacheSize = MESH_CACHE_SIZE)
+{
+	std::vector<unsigned int> out;
+	clusters.clear();
+	if (indexCount < 3)
+		return out;
+	std::vector<unsigned int> live(vertexCount, 0), firstTriangle(vertexCount + 1, 0), triangles(indexCount);
+	for (size_t i = 0; i < indexCount; i++)
+		live[indices[i]]++;
+	for (size_t v = 0; v < vertexCount; v++)
+		firstTriangle[v + 1] = firstTriangle[v] + live[v];
+	std::vector<unsigned int> filled(firstTriangle.begin(), firstTriangle.end() - 1);
+	for (size_t i = 0; i < indexCount; i++)
+		triangles[filled[indices[i]]++] = (unsigned int)(i / 3);
+
+	std::vector<size_t> cachedAt(vertexCount, 0);
+	std::vector<bool> emitted(indexCount / 3, false);
+	std::vector<unsigned int> deadEnd, candidates;
+	size_t time = (size_t)cacheSize + 1;
+	size_t cursor = 0;
+	long fan = (long)indices[0];
+	out.reserve(indexCount);
+	clusters.push_back(0);
+	while (fan >= 0) {
+		candidates.clear();
+		for (unsigned int a = firstTriangle[fan]; a < firstTriangle[fan + 1]; a++) {
+			unsigned int triangle = triangles[a];
+			if (emitted[triangle])
+				continue;
+			for (int c = 0; c < 3; c++) {
+				unsigned int v = indices[triangle * 3 + c];
+				out.push_back(v);
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				live[v]--;
+				if (time - cachedAt[v] > (size_t)cacheSize)
+					cachedAt[v] = time++;
+			}
+			emitted[triangle] = true;
+		}
+
+		// the neighbour that will still be cached once its own triangles are out, oldest first
+		fan = -1;
+		size_t best = 0;
+		for (unsigned int v : candidates) {
+			if (live[v] == 0)
+				continue;
+			size_t priority = 0;
+			if (time - cachedAt[v] + 2 * live[v] <= (size_t)cacheSize)
+				priority = time - cachedAt[v];
+			if (priority > best) {
+				best = priority;
+				fan = v;
+			}
+		}
+		if (fan >= 0)
+			continue;
+		while (fan < 0 && !deadEnd.empty()) {
+			unsigned int v = deadEnd.back();
+			deadEnd.pop_back();
+			if (live[v] > 0)
+				fan = v;
+		}
+		while (fan < 0 && cursor < vertexCount) {
+			if (live[cursor] > 0)
+				fan = (long)cursor;
+			else
+				cursor++;
+		}
+		if (fan >= 0)
+			clusters.push_back(out.size() / 3);
+	}
+	return out;
+}
+
+// Splits clusters further wherever the cluster so far, starting from a cold cache, already
+// costs no more than the whole order, so sorting them later loses little cache efficiency.
+inline void splitClusters(const std::vector<unsigned int>& indices, size_t vertexCount, std::vector<size_t>& clusters, int cacheSize = MESH_CACHE_SIZE)
+{
+	float overall = analyzeVertexCache(indices.data(), indices.size(), vertexCount, cacheSize).acmr();
+	std::vector<size_t> split;
+	std::vector<size_t> cachedAt(vertexCount, 0);
+	size_t time = (size_t)cacheSize + 1;
+	size_t triangleCount = indices.size() / 3;
+	for (size_t c = 0; c < clusters.size(); c++) {
+		size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+		size_t start = clusters[c];
+		size_t transformed = 0;
+		time += cacheSize + 1; // cold cache
+		split.push_back(start);
+		for (size_t t = start; t < end; t++) {
+			for (int k = 0; k < 3; k++) {
+				unsigned int v = indices[t * 3 + k];
+				if (time - cachedAt[v] > (size_t)cacheSize) {
+					cachedAt[v] = time++;
+					transformed++;
+				}
+			}
+			size_t done = t + 1 - start;
+			if (t + 1 < end && done >= 8 && (float)transformed / done <= overall) {
+				split.push_back(t + 1);
+				start = t + 1;
+				transformed = 0;
+				time += cacheSize + 1;
+			}
+		}
+	}
+	clusters.swap(split);
+}
+
+// Sorts clusters so the ones facing out from the middle of the mesh draw first, they are
+// the most likely to hide the rest (Sander et al.). Kept only if the cache cost stays under
+// MESH_OVERDRAW_THRESHOLD times the order it started from.
+inline void optimizeOverdraw(std::vector<unsigned int>& indices, const float* vertices, int vertexFloats, size_t vertexCount,
+	const std::vector<size_t>& clusters)
+{
+	size_t triangleCount = indices.size() / 3;
+	if (clusters.size() < 2)
+		return;
+	auto position = [&](unsigned int v) { return glm::vec3(vertices[(size_t)v * vertexFloats], vertices[(size_t)v * vertexFloats + 1], vertices[(size_t)v * vertexFloats + 2]); };
+
+	std::vector<glm::vec3> centers(clusters.size()), normals(clusters.size());
+	std::vector<float> areas(clusters.size());
+	glm::vec3 meshCenter(0.0f);
+	float meshArea = 0.0f;
+	for (size_t c = 0; c < clusters.size(); c++) {
+		size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+		glm::vec3 center(0.0f), normal(0.0f);
+		float area = 0.0f;
+		for (size_t t = clusters[c]; t < end; t++) {
+			glm::vec3 a = position(indices[t * 3]), b = position(indices[t * 3 + 1]), d = position(indices[t * 3 + 2]);
+			glm::vec3 cross = glm::cross(b - a, d - a);
+			float triangleArea = glm::length(cross) * 0.5f;
+			center += (a + b + d) / 3.0f * triangleArea;
+			normal += cross;
+			area += triangleArea;
+		}
+		centers[c] = area > 0.0f ? center / area : position(indices[clusters[c] * 3]);
+		normals[c] = glm::length(normal) > 0.0f ? glm::normalize(normal) : glm::vec3(0.0f);
+		meshCenter += center;
+		meshArea += area;
+	}
+	if (meshArea > 0.0f)
+		meshCenter /= meshArea;
+
+	std::vector<float> outward(clusters.size());
+	for (size_t c = 0; c < clusters.size(); c++)
+		outward[c] = glm::dot(centers[c] - meshCenter, normals[c]);
+	std::vector<size_t> order(clusters.size());
+	std::iota(order.begin(), order.end(), (size_t)0);
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return outward[a] > outward[b]; });
+
+	std::vector<unsigned int> sorted;
+	sorted.reserve(indices.size());
+	for (size_t c : order) {
+		size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+		sorted.insert(sorted.end(), indices.begin() + clusters[c] * 3, indices.begin() + end * 3);
+	}
+	float before = analyzeVertexCache(indices.data(), indices.size(), vertexCount).acmr();
+	float after = analyzeVertexCache(sorted.data(), sorted.size(), vertexCount).acmr();
+	if (after <= before * MESH_OVERDRAW_THRESHOLD)
+		indices.swap(sorted);
+}
+
+// Renumbers vertices in the order the indices first use them so fetches walk memory
+// forwards, and drops any vertex nothing uses. Returns the vertex count left.
+inline size_t optimizeVertexFetch(std::vector<float>& vertices, int vertexFloats, std::vector<unsigned int>& indices)
+{
+	size_t count = vertices.size() / vertexFloats;
+	const unsigned int unused = ~0u;
+	std::vector<unsigned int> remap(count, unused);
+	std::vector<float> ordered;
+	ordered.reserve(vertices.size());
+	unsigned int next = 0;
+	for (unsigned int& index : indices) {
+		if (remap[index] == unused) {
+			remap[index] = next++;
+			ordered.insert(ordered.end(), vertices.begin() + (size_t)index * vertexFloats, vertices.begin() + (size_t)(index + 1) * vertexFloats);
+		}
+		index = remap[index];
+	}
+	vertices.swap(ordered);
+	return next;
+}
+
+// The whole pass: duplicate vertices merged, every range of indices (each level of detail
+// of each submesh) put in Tipsify order then cluster sorted for overdraw, and the vertices
+// renumbered for fetch. Ranges keep their place in the index buffer. The report sums every
+// range, before and after.
+inline MeshOptimizeReport optimizeMesh(std::vector<float>& vertices, int vertexFloats, std::vector<unsigned int>& indices,
+	const MeshLod* ranges, int rangeCount)
+{
+	MeshOptimizeReport report;
+	report.verticesBefore = vertices.size() / vertexFloats;
+	for (int r = 0; r < rangeCount; r++)
+		report.before.add(analyzeVertexCache(indices.data() + ranges[r].firstIndex, ranges[r].indexCount, report.verticesBefore));
+
+	size_t vertexCount = deduplicateVertices(vertices, vertexFloats, indices);
+	std::vector<size_t> clusters;
+	for (int r = 0; r < rangeCount; r++) {
+		unsigned int* range = indices.data() + ranges[r].firstIndex;
+		std::vector<unsigned int> ordered = tipsifyOrder(range, ranges[r].indexCount, vertexCount, clusters);
+		splitClusters(ordered, vertexCount, clusters);
+		optimizeOverdraw(ordered, vertices.data(), vertexFloats, vertexCount, clusters);
+		std::copy(ordered.begin(), ordered.end(), range);
+	}
+	report.verticesAfter = optimizeVertexFetch(vertices, vertexFloats, indices);
+
+	for (int r = 0; r < rangeCount; r++)
+		report.after.add(analyzeVertexCache(indices.data() + ranges[r].firstIndex, ranges[r].indexCount, report.verticesAfter));
+	return report;
+}
+#endif
@@ -0,0 +1,70 @@
+#ifndef MESHREGISTRY_H
+#define MESHREGISTRY_H
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mesh.h"
+#include "meshlod.h"
+#include "meshoptimize.h"
+
+// A mesh built on the cpu, optimised and uploaded once. chain keeps the optimised vertices
+// and indices for code that builds on them, such as the skinned lamp rig.
+struct RegisteredMesh {
+	std::string name;
+	MeshLodChain chain;
+	Mesh mesh;
+	MeshOptimizeReport report;
+};
+
+// Every generated mesh the renderer draws goes through add, which runs the optimisation
+// pass (meshoptimize.h) over each level, prints its cache figures before and after and
+// uploads it as CompactVertexFormat, 20 bytes a vertex instead of 32.
+// Entries never move, so pointers to them stay valid. Needs a current gl context.
+class MeshRegistry
+{
+public:
+	const RegisteredMesh* add(const std::string& name, const MeshLodChain& chain)
+	{
+		std::unique_ptr<RegisteredMesh> entry(new RegisteredMesh());
+		entry->name = name;
+		entry->chain = chain;
+		entry->report = optimizeMesh(entry->chain.mesh.vertices, MESH_VERTEX_FLOATS, entry->chain.mesh.indices, entry->chain.lods, entry->chain.lodCount);
+		entry->mesh = Mesh::encoded<CompactVertexFormat>(entry->chain.mesh);
+		printReport(*entry);
+		meshes.push_back(std::move(entry));
+		return meshes.back().get();
+	}
+
+	const RegisteredMesh* add(const std::string& name, const MeshData& mesh)
+	{
+		MeshLodChain chain;
+		chain.mesh = mesh;
+		chain.lods[0] = { 0, (unsigned int)mesh.indices.size(), 0.0f };
+		chain.lodCount = 1;
+		return add(name, chain);
+	}
+
+	const RegisteredMesh* find(const std::string& name) const
+	{
+		for (const std::unique_ptr<RegisteredMesh>& entry : meshes) {
+			if (entry->name == name)
+				return entry.get();
+		}
+		return nullptr;
+	}
+
+	static void printReport(const RegisteredMesh& entry)
+	{
+		const MeshOptimizeReport& report = entry.report;
+		std::cout << "mesh " << entry.name << ": " << report.verticesBefore << " -> " << report.verticesAfter << " vertices, ACMR "
+			<< report.before.acmr() << " -> " << report.after.acmr() << ", ATVR " << report.before.atvr() << " -> " << report.after.atvr()
+			<< " over " << entry.chain.lodCount << (entry.chain.lodCount == 1 ? " level" : " levels") << std::endl;
+	}
+
+private:
+	std::vector<std::unique_ptr<RegisteredMesh>> meshes;
+};
+#endif
@@ -0,0 +1,240 @@
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "Ws2_32.lib")
+#endif
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "renderstats.h"
+
+const int METRICS_FRAME_WINDOW = 1024; // frames the frame time percentiles are taken over, power of 2
+
+// Everything the metrics endpoint reports. The render loop writes with relaxed atomics
+// and never waits, the server thread reads whenever it is scraped.
+class LiveMetrics
+{
+public:
+	LiveMetrics()
+	{
+		for (std::atomic<int64_t>& time : frameTimes)
+			time.store(0, std::memory_order_relaxed);
+	}
+
+	void recordFrame(int64_t frameNanoseconds, const RenderStats& stats)
+	{
+		uint64_t frame = frames.load(std::memory_order_relaxed);
+		frameTimes[frame & (METRICS_FRAME_WINDOW - 1)].store(frameNanoseconds, std::memory_order_relaxed);
+		frameTimeSum.fetch_add(frameNanoseconds, std::memory_order_relaxed);
+		lastDraws.store(stats.draws, std::memory_order_relaxed);
+		lastTriangles.store(stats.triangles, std::memory_order_relaxed);
+		drawsTotal.fetch_add(stats.draws, std::memory_order_relaxed);
+		trianglesTotal.fetch_add(stats.triangles, std::memory_order_relaxed);
+		uploadTotal.fetch_add(stats.uploadBytes, std::memory_order_relaxed);
+		frames.store(frame + 1, std::memory_order_release);
+	}
+
+	// Prometheus text exposition format, version 0.0.4
+	std::string prometheusText() const
+	{
+		uint64_t count = frames.load(std::memory_order_acquire);
+		int window = (int)std::min<uint64_t>(count, METRICS_FRAME_WINDOW);
+		double sorted[METRICS_FRAME_WINDOW];
+		for (int i = 0; i < window; i++)
+			sorted[i] = frameTimes[i].load(std::memory_order_relaxed) / 1.0e9;
+		std::sort(sorted, sorted + window);
+
+		const GpuResourceStats& resources = gpuResources();
+		std::ostringstream out;
+		out << "# HELP hatch_frame_time_seconds Frame time over the last " << METRICS_FRAME_WINDOW << " frames.\n";
+		out << "# TYPE hatch_frame_time_seconds summary\n";
+		const double quantiles[] = { 0.5, 0.9, 0.95, 0.99 };
+		for (double q : quantiles) {
+			out << "hatch_frame_time_seconds{quantile=\"" << q << "\"} ";
+			if (window > 0)
+				out << sorted[std::min(window - 1, (int)(q * window))] << "\n";
+			else
+				out << "NaN\n";
+		}
+		out << "hatch_frame_time_seconds_sum " << frameTimeSum.load(std::memory_order_relaxed) / 1.0e9 << "\n";
+		out << "hatch_frame_time_seconds_count " << count << "\n";
+
+		metric(out, "hatch_draw_calls", "gauge", "Draw calls in the last frame.", lastDraws.load(std::memory_order_relaxed));
+		metric(out, "hatch_draw_calls_total", "counter", "Draw calls since start.", drawsTotal.load(std::memory_order_relaxed));
+		metric(out, "hatch_triangles", "gauge", "Triangles drawn in the last frame.", lastTriangles.load(std::memory_order_relaxed));
+		metric(out, "hatch_triangles_total", "counter", "Triangles drawn since start.", trianglesTotal.load(std::memory_order_relaxed));
+		metric(out, "hatch_upload_bytes_total", "counter", "Bytes uploaded to buffers during frames.", uploadTotal.load(std::memory_order_relaxed));
+		metric(out, "hatch_buffer_memory_bytes", "gauge", "Bytes allocated in gpu buffers.", resources.bufferBytes.load(std::memory_order_relaxed));
+		metric(out, "hatch_texture_memory_bytes", "gauge", "Estimated bytes of texture memory.", resources.textureBytes.load(std::memory_order_relaxed));
+		metric(out, "hatch_shader_compiles_total", "counter", "Shader stages compiled.", resources.shaderCompiles.load(std::memory_order_relaxed));
+		metric(out, "hatch_shader_compile_failures_total", "counter", "Shader stages that failed to compile.", resources.shaderFailures.load(std::memory_order_relaxed));
+		return out.str();
+	}
+
+private:
+	std::atomic<int64_t> frameTimes[METRICS_FRAME_WINDOW];
+	std::atomic<uint64_t> frames{ 0 };
+	std::atomic<int64_t> frameTimeSum{ 0 };
+	std::atomic<int64_t> lastDraws{ 0 }, lastTriangles{ 0 };
+	std::atomic<int64_t> drawsTotal{ 0 }, trianglesTotal{ 0 }, uploadTotal{ 0 };
+
+	static void metric(std::ostringstream& out, const char* name, const char* type, const char* help, int64_t value)
+	{
+		out << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n" << name << " " << value << "\n";
+	}
+};
+
+// Answers every http request on 127.0.0.1:port with the metrics, on its own thread
+// so a slow scraper never holds up a frame.
+class MetricsServer
+{
+public:
+	MetricsServer(const LiveMetrics& liveMetrics) : metrics(liveMetrics) {}
+
+	~MetricsServer() { stop(); }
+
+	MetricsServer(const MetricsServer&) = delete;
+	MetricsServer& operator=(const MetricsServer&) = delete;
+
+	bool start(int port)
+	{
+#ifdef _WIN32
+		WSADATA wsaData;
+		if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+			std::cout << "ERROR::METRICS::WSASTARTUP_FAILED" << std::endl;
+			return false;
+		}
+		started = true;
+#endif
+		listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		if (listener == INVALID_METRICS_SOCKET) {
+			std::cout << "ERROR::METRICS::SOCKET_FAILED" << std::endl;
+			return false;
+		}
+		int reuse = 1;
+		setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+		sockaddr_in address;
+		std::memset(&address, 0, sizeof(address));
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // local scrapers only
+		address.sin_port = htons((unsigned short)port);
+		if (bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 8) != 0) {
+			std::cout << "ERROR::METRICS::BIND_FAILED: port " << port << std::endl;
+			closeSocket(listener);
+			listener = INVALID_METRICS_SOCKET;
+			return false;
+		}
+
+		running = true;
+		thread = std::thread(&MetricsServer::serve, this);
+		std::cout << "Metrics on http://127.0.0.1:" << port << "/metrics" << std::endl;
+		return true;
+	}
+
+	void stop()
+	{
+		running = false;
+		if (thread.joinable())
+			thread.join();
+		if (listener != INVALID_METRICS_SOCKET) {
+			closeSocket(listener);
+			listener = INVALID_METRICS_SOCKET;
+		}
+#ifdef _WIN32
+		if (started)
+			WSACleanup();
+		started = false;
+#endif
+	}
+
+private:
+#ifdef _WIN32
+	typedef SOCKET Socket;
+	static const Socket INVALID_METRICS_SOCKET = INVALID_SOCKET;
+	static void closeSocket(Socket s) { closesocket(s); }
+	bool started = false;
+#else
+	typedef int Socket;
+	static const Socket INVALID_METRICS_SOCKET = -1;
+	static void closeSocket(Socket s) { close(s); }
+#endif
+
+	const LiveMetrics& metrics;
+	Socket listener = INVALID_METRICS_SOCKET;
+	std::atomic<bool> running{ false };
+	std::thread thread;
+
+	void serve()
+	{
+		while (running) {
+			// wake up regularly so stop() does not wait for a scrape
+			fd_set readable;
+			FD_ZERO(&readable);
+			FD_SET(listener, &readable);
+			timeval timeout = { 0, 200000 };
+			if (select((int)listener + 1, &readable, NULL, NULL, &timeout) <= 0)
+				continue;
+
+			Socket client = accept(listener, NULL, NULL);
+			if (client == INVALID_METRICS_SOCKET)
+				continue;
+
+			// whatever was asked for the answer is the metrics, but do not wait forever for the request
+			fd_set requested;
+			FD_ZERO(&requested);
+			FD_SET(client, &requested);
+			timeval requestTimeout = { 1, 0 };
+			if (select((int)client + 1, &requested, NULL, NULL, &requestTimeout) > 0) {
+				char request[2048];
+				recv(client, request, sizeof(request), 0);
+			}
+
+			std::string body = metrics.prometheusText();
+			std::string response = "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+				+ std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+			sendAll(client, response);
+			closeSocket(client);
+		}
+	}
+
+	static void sendAll(Socket client, const std::string& data)
+	{
+		size_t sent = 0;
+		while (sent < data.size()) {
+#ifdef MSG_NOSIGNAL
+			int n = (int)send(client, data.data() + sent, (int)(data.size() - sent), MSG_NOSIGNAL);
+#else
+			int n = (int)send(client, data.data() + sent, (int)(data.size() - sent), 0);
+#endif
+			if (n <= 0)
+				return;
+			sent += n;
+		}
+	}
+};
+#endif
@@ -0,0 +1,180 @@
+#ifndef MICROBENCH_H
+#define MICROBENCH_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "timing.h"
+
+// keeps a result alive so the compiler cannot drop the work that made it
+template <typename T>
+inline void benchmarkKeep(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "r"(&value) : "memory");
+#else
+	static const void* volatile sink;
+	sink = &value;
+#endif
+}
+
+struct MicroBenchmarkResult
+{
+	std::string name;
+	int64_t iterations = 0; // per repetition
+	double medianNs = 0.0, minNs = 0.0, maxNs = 0.0; // per operation
+};
+
+// Times small operations on the cpu. Each one is run until a repetition takes about
+// targetNs, then timed over several repetitions. The median is the number to compare,
+// min and max show how noisy the machine was.
+class MicroBenchmarkSuite
+{
+public:
+	int repetitions = 9;
+	int64_t targetNs = 20000000;
+
+	void add(const std::string& name, std::function<void()> operation) { benchmarks.push_back({ name, operation }); }
+
+	std::vector<MicroBenchmarkResult> run(const std::string& filter = "") const
+	{
+		std::vector<MicroBenchmarkResult> results;
+		for (const Benchmark& benchmark : benchmarks) {
+			if (!filter.empty() && benchmark.name.find(filter) == std::string::npos)
+				continue;
+			results.push_back(measure(benchmark));
+			const MicroBenchmarkResult& result = results.back();
+			std::cout << std::left << std::setw(32) << result.name << std::right << std::fixed << std::setprecision(1)
+				<< std::setw(12) << result.medianNs << " ns  (min " << result.minNs << ", max " << result.maxNs << ", "
+				<< result.iterations << " iterations)" << std::defaultfloat << std::endl;
+		}
+		return results;
+	}
+
+private:
+	struct Benchmark
+	{
+		std::string name;
+		std::function<void()> operation;
+	};
+	std::vector<Benchmark> benchmarks;
+
+	static int64_t timeRun(const Benchmark& benchmark, int64_t iterations)
+	{
+		int64_t start = Clock::now();
+		for (int64_t i = 0; i < iterations; i++)
+			benchmark.operation();
+		return Clock::now() - start;
+	}
+
+	MicroBenchmarkResult measure(const Benchmark& benchmark) const
+	{
+		// grow the iteration count until a run is long enough to time, this also warms caches
+		int64_t iterations = 1;
+		int64_t elapsed = timeRun(benchmark, iterations);
+		while (elapsed < targetNs / 10 && iterations < ((int64_t)1 << 40)) {
+			iterations *= 2;
+			elapsed = timeRun(benchmark, iterations);
+		}
+		iterations = std::max<int64_t>(1, (int64_t)((double)iterations * targetNs / std::max<int64_t>(elapsed, 1)));
+
+		std::vector<double> perOperation(repetitions);
+		for (double& ns : perOperation)
+			ns = (double)timeRun(benchmark, iterations) / iterations;
+		std::sort(perOperation.begin(), perOperation.end());
+
+		MicroBenchmarkResult result;
+		result.name = benchmark.name;
+		result.iterations = iterations;
+		result.medianNs = perOperation[perOperation.size() / 2];
+		result.minNs = perOperation.front();
+		result.maxNs = perOperation.back();
+		return result;
+	}
+};
+
+// one object per benchmark, the same shape every run so results can be diffed by tools
+inline bool writeMicroBenchmarkJson(const std::string& file, const std::vector<MicroBenchmarkResult>& results)
+{
+	std::ofstream out(file);
+	if (!out) {
+		std::cout << "ERROR::MICROBENCH::WRITE_FAILED: " << file << std::endl;
+		return false;
+	}
+	out << std::fixed << std::setprecision(2);
+	out << "{\n  \"unit\": \"ns\",\n  \"benchmarks\": [\n";
+	for (size_t i = 0; i < results.size(); i++) {
+		const MicroBenchmarkResult& result = results[i];
+		out << "    { \"name\": \"" << result.name << "\", \"iterations\": " << result.iterations << ", \"median\": " << result.medianNs
+			<< ", \"min\": " << result.minNs << ", \"max\": " << result.maxNs << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	out << "  ]\n}\n";
+	return true;
+}
+
+// Stand ins for the gl calls Shader makes, so uniform setting can be timed without a
+// context. Uniform locations are looked up by name like a driver would, at a fraction of the cost.
+namespace stubgl
+{
+	inline GLuint APIENTRY createShader(GLenum) { return 1; }
+	inline void APIENTRY shaderSource(GLuint, GLsizei, const GLchar* const*, const GLint*) {}
+	inline void APIENTRY compileShader(GLuint) {}
+	inline void APIENTRY getShaderiv(GLuint, GLenum, GLint* value) { *value = GL_TRUE; }
+	inline GLuint APIENTRY createProgram() { return 1; }
+	inline void APIENTRY attachShader(GLuint, GLuint) {}
+	inline void APIENTRY linkProgram(GLuint) {}
+	inline void APIENTRY getProgramiv(GLuint, GLenum, GLint* value) { *value = GL_TRUE; }
+	inline void APIENTRY deleteShader(GLuint) {}
+	inline void APIENTRY useProgram(GLuint) {}
+	inline GLint APIENTRY getUniformLocation(GLuint, const GLchar* name)
+	{
+		uint32_t hash = 2166136261u;
+		for (const GLchar* c = name; *c != '\0'; c++)
+			hash = (hash ^ (uint8_t)*c) * 16777619u;
+		return (GLint)(hash & 0xFF);
+	}
+	inline void APIENTRY uniform1i(GLint, GLint) {}
+	inline void APIENTRY uniform1f(GLint, GLfloat) {}
+	inline void APIENTRY uniform2f(GLint, GLfloat, GLfloat) {}
+	inline void APIENTRY uniform3f(GLint, GLfloat, GLfloat, GLfloat) {}
+	inline void APIENTRY uniform4f(GLint, GLfloat, GLfloat, GLfloat, GLfloat) {}
+	inline void APIENTRY uniformfv(GLint, GLsizei, const GLfloat*) {}
+	inline void APIENTRY uniformMatrixfv(GLint, GLsizei, GLboolean, const GLfloat*) {}
+}
+
+// points glad at the stubs, only for benchmark runs that never create a window
+inline void useStubGL()
+{
+	glad_glCreateShader = stubgl::createShader;
+	glad_glShaderSource = stubgl::shaderSource;
+	glad_glCompileShader = stubgl::compileShader;
+	glad_glGetShaderiv = stubgl::getShaderiv;
+	glad_glCreateProgram = stubgl::createProgram;
+	glad_glAttachShader = stubgl::attachShader;
+	glad_glLinkProgram = stubgl::linkProgram;
+	glad_glGetProgramiv = stubgl::getProgramiv;
+	glad_glDeleteShader = stubgl::deleteShader;
+	glad_glUseProgram = stubgl::useProgram;
+	glad_glGetUniformLocation = stubgl::getUniformLocation;
+	glad_glUniform1i = stubgl::uniform1i;
+	glad_glUniform1f = stubgl::uniform1f;
+	glad_glUniform2f = stubgl::uniform2f;
+	glad_glUniform3f = stubgl::uniform3f;
+	glad_glUniform4f = stubgl::uniform4f;
+	glad_glUniform2fv = stubgl::uniformfv;
+	glad_glUniform3fv = stubgl::uniformfv;
+	glad_glUniform4fv = stubgl::uniformfv;
+	glad_glUniformMatrix2fv = stubgl::uniformMatrixfv;
+	glad_glUniformMatrix3fv = stubgl::uniformMatrixfv;
+	glad_glUniformMatrix4fv = stubgl::uniformMatrixfv;
+}
+#endif
@@ -0,0 +1,149 @@
+#ifndef MODELIMPORT_H
+#define MODELIMPORT_H
+
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+
+#include <glm/glm.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "meshfile.h"
+#include "meshlod.h"
+#include "meshoptimize.h"
+
+// texture of a material as a path loadTexture can open, next to the model file
+inline void importTexturePath(const aiMaterial* material, aiTextureType type, const std::string& directory, char (&out)[COOKED_PATH_LENGTH])
+{
+	out[0] = 0;
+	aiString name;
+	if (material->GetTexture(type, 0, &name) != AI_SUCCESS)
+		return;
+	std::string path = name.C_Str();
+	if (!path.empty() && path[0] == '*') {
+		std::cout << "Embedded texture " << path << " skipped, export it next to the model" << std::endl;
+		return;
+	}
+	for (char& c : path) {
+		if (c == '\\')
+			c = '/';
+	}
+	path = directory + path;
+	if (path.size() >= COOKED_PATH_LENGTH) {
+		std::cout << "ERROR::MODELIMPORT::PATH_TOO_LONG: " << path << std::endl;
+		return;
+	}
+	std::snprintf(out, COOKED_PATH_LENGTH, "%s", path.c_str());
+}
+
+// Loads any format assimp reads, triangulated, with identical vertices merged, tangents
+// generated, the node hierarchy baked in and every level ordered for the vertex cache.
+// Writes it as one cooked mesh with a submesh per material and the vertices packed in
+// layout, then maps the file back to check it. Run once per asset, the game only ever
+// opens the cooked file.
+inline bool importModel(const std::string& source, const std::string& out, CookedVertexLayout layout = CookedCompactVertices)
+{
+	Assimp::Importer importer;
+	const aiScene* scene = importer.ReadFile(source,
+		aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace
+		| aiProcess_PreTransformVertices | aiProcess_SortByPType | aiProcess_FindDegenerates | aiProcess_RemoveRedundantMaterials
+		| aiProcess_ValidateDataStructure);
+	if (scene == nullptr || (scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) || scene->mNumMeshes == 0) {
+		std::cout << "ERROR::MODELIMPORT::READ_FAILED: " << source << " " << importer.GetErrorString() << std::endl;
+		return false;
+	}
+	size_t slash = source.find_last_of("/\\");
+	std::string directory = slash == std::string::npos ? "" : source.substr(0, slash + 1);
+
+	std::vector<float> vertices;
+	std::vector<uint32_t> indices;
+	std::vector<CookedSubmesh> submeshes;
+	for (unsigned int m = 0; m < scene->mNumMeshes; m++) {
+		const aiMesh* mesh = scene->mMeshes[m];
+		if (!(mesh->mPrimitiveTypes & aiPrimitiveType_TRIANGLE))
+			continue; // points and lines, sorted into their own meshes
+		uint32_t baseVertex = (uint32_t)(vertices.size() / COOKED_VERTEX_FLOATS);
+		for (unsigned int v = 0; v < mesh->mNumVertices; v++) {
+			glm::vec3 position(mesh->mVertices[v].x, mesh->mVertices[v].y, mesh->mVertices[v].z);
+			glm::vec3 normal = mesh->HasNormals() ? glm::vec3(mesh->mNormals[v].x, mesh->mNormals[v].y, mesh->mNormals[v].z) : glm::vec3(0.0f, 1.0f, 0.0f);
+			glm::vec2 uv = mesh->HasTextureCoords(0) ? glm::vec2(mesh->mTextureCoords[0][v].x, mesh->mTextureCoords[0][v].y) : glm::vec2(0.0f);
+			glm::vec3 tangent(1.0f, 0.0f, 0.0f);
+			float handedness = 1.0f;
+			if (mesh->HasTangentsAndBitangents()) {
+				tangent = glm::vec3(mesh->mTangents[v].x, mesh->mTangents[v].y, mesh->mTangents[v].z);
+				glm::vec3 bitangent(mesh->mBitangents[v].x, mesh->mBitangents[v].y, mesh->mBitangents[v].z);
+				handedness = glm::dot(glm::cross(normal, tangent), bitangent) < 0.0f ? -1.0f : 1.0f;
+			}
+			const float vertex[COOKED_VERTEX_FLOATS] = {
+				position.x, position.y, position.z,
+				normal.x, normal.y, normal.z,
+				uv.x, uv.y,
+				tangent.x, tangent.y, tangent.z, handedness,
+			};
+			vertices.insert(vertices.end(), vertex, vertex + COOKED_VERTEX_FLOATS);
+		}
+
+		CookedSubmesh submesh = {};
+		uint32_t firstIndex = (uint32_t)indices.size();
+		for (unsigned int f = 0; f < mesh->mNumFaces; f++) {
+			const aiFace& face = mesh->mFaces[f];
+			if (face.mNumIndices != 3)
+				continue;
+			for (int i = 0; i < 3; i++)
+				indices.push_back(baseVertex + face.mIndices[i]);
+		}
+		submesh.lodCount = 1;
+		submesh.lods[0] = { firstIndex, (uint32_t)indices.size() - firstIndex, 0.0f };
+		const aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+		importTexturePath(material, aiTextureType_DIFFUSE, directory, submesh.diffuse);
+		importTexturePath(material, aiTextureType_SPECULAR, directory, submesh.specular);
+		submeshes.push_back(submesh);
+	}
+
+	// levels of detail go after every submesh's full detail indices
+	for (CookedSubmesh& submesh : submeshes) {
+		submesh.lodCount = appendLods(vertices.data(), (unsigned int)(vertices.size() / COOKED_VERTEX_FLOATS), COOKED_VERTEX_FLOATS, indices,
+			submesh.lods[0].firstIndex, submesh.lods[0].indexCount, submesh.lods);
+	}
+
+	// every level of every submesh reordered for the vertex cache and overdraw, then the
+	// shared vertices renumbered for fetch (meshoptimize.h)
+	std::vector<MeshLod> ranges;
+	for (const CookedSubmesh& submesh : submeshes)
+		ranges.insert(ranges.end(), submesh.lods, submesh.lods + submesh.lodCount);
+	MeshOptimizeReport optimized = optimizeMesh(vertices, COOKED_VERTEX_FLOATS, indices, ranges.data(), (int)ranges.size());
+
+	std::vector<unsigned char> bytes = buildCookedMesh(vertices, indices, submeshes, layout);
+	std::ofstream file(out, std::ios::binary);
+	file.write((const char*)bytes.data(), bytes.size());
+	file.close();
+	if (!file) {
+		std::cout << "ERROR::MODELIMPORT::WRITE_FAILED: " << out << std::endl;
+		return false;
+	}
+
+	CookedMesh cooked;
+	if (!cooked.open(out))
+		return false;
+	const CookedMeshHeader& header = cooked.header();
+	std::cout << "imported " << source << ": " << submeshes.size() << " submeshes, " << header.vertexCount << " vertices, "
+		<< header.indexCount / 3 << " triangles in every level, " << cooked.size() << " bytes written to " << out << std::endl;
+	std::cout << "  " << cooked.vertexStride() << " bytes a vertex (" << CookedVertexFormat::stride << " as floats), "
+		<< header.vertexCount * cooked.vertexStride() << " bytes of vertices" << std::endl;
+	for (size_t i = 0; i < submeshes.size(); i++) {
+		std::cout << "  submesh " << i << ":";
+		for (uint32_t lod = 0; lod < submeshes[i].lodCount; lod++)
+			std::cout << " " << submeshes[i].lods[lod].indexCount / 3 << " (error " << submeshes[i].lods[lod].error << ", "
+				<< cooked.submesh((int)i).meshletCount[lod] << " meshlets)";
+		std::cout << std::endl;
+	}
+	std::cout << "  ACMR " << optimized.before.acmr() << " -> " << optimized.after.acmr() << ", ATVR " << optimized.before.atvr() << " -> "
+		<< optimized.after.atvr() << ", " << optimized.verticesBefore << " -> " << optimized.verticesAfter << " vertices" << std::endl;
+	return true;
+}
+#endif
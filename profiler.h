@@ -0,0 +1,266 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// build with HATCH_PROFILER=0 and every PROFILE_ macro compiles to nothing
+#ifndef HATCH_PROFILER
+#define HATCH_PROFILER 1
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "timing.h"
+
+enum ProfileEventType : uint8_t
+{
+	ProfileZoneEvent,
+	ProfileCounterEvent,
+	ProfileFrameEvent
+};
+
+struct ProfileEvent
+{
+	const char* name; // must be a string literal, only the pointer is stored
+	int64_t start;
+	int64_t value; // end time of a zone, value of a counter, number of a frame
+	ProfileEventType type;
+};
+
+const int PROFILE_RING_SIZE = 1 << 16; // events kept per thread, power of 2
+
+// Written by a single thread without locks, read by whichever thread dumps.
+// Old events are overwritten, so a dump holds the last PROFILE_RING_SIZE events.
+struct ProfileRing
+{
+	ProfileEvent events[PROFILE_RING_SIZE];
+	std::atomic<uint64_t> head{ 0 };
+	std::atomic<bool> inUse{ false };
+	int index = 0;
+	const char* name = nullptr; // shown instead of the thread number, e.g. the gpu timeline
+
+	void push(const char* name, int64_t start, int64_t value, ProfileEventType type)
+	{
+		uint64_t h = head.load(std::memory_order_relaxed);
+		ProfileEvent& event = events[h & (PROFILE_RING_SIZE - 1)];
+		event.name = name;
+		event.start = start;
+		event.value = value;
+		event.type = type;
+		head.store(h + 1, std::memory_order_release);
+	}
+
+	// copies out every event the owning thread cannot have been overwriting meanwhile
+	void snapshot(std::vector<ProfileEvent>& out) const
+	{
+		uint64_t end = head.load(std::memory_order_acquire);
+		uint64_t begin = end > PROFILE_RING_SIZE ? end - PROFILE_RING_SIZE : 0;
+		std::vector<ProfileEvent> copied;
+		for (uint64_t i = begin; i < end; i++)
+			copied.push_back(events[i & (PROFILE_RING_SIZE - 1)]);
+
+		uint64_t after = head.load(std::memory_order_acquire);
+		uint64_t safe = after + 1 > PROFILE_RING_SIZE ? after + 1 - PROFILE_RING_SIZE : 0;
+		for (uint64_t i = std::max(begin, safe); i < end; i++)
+			out.push_back(copied[(size_t)(i - begin)]);
+	}
+};
+
+// Owns one ring per live thread. A thread takes a ring on its first event and hands it
+// back when it exits, so short lived worker threads reuse rings instead of adding more.
+class Profiler
+{
+public:
+	static Profiler& get()
+	{
+		static Profiler profiler;
+		return profiler;
+	}
+
+	ProfileRing* acquireRing()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (std::unique_ptr<ProfileRing>& ring : rings) {
+			bool free = false;
+			if (ring->inUse.compare_exchange_strong(free, true))
+				return ring.get();
+		}
+		rings.emplace_back(new ProfileRing());
+		rings.back()->index = (int)rings.size() - 1;
+		rings.back()->inUse = true;
+		return rings.back().get();
+	}
+
+	// a ring that is not tied to a thread, its single writer is whoever asked for it
+	ProfileRing* namedRing(const char* name)
+	{
+		ProfileRing* ring = acquireRing();
+		ring->name = name;
+		return ring;
+	}
+
+	// asks the frame marker to write a trace, safe to call from a signal handler
+	void requestDump() { dumpRequested.store(true); }
+
+	bool takeDumpRequest() { return dumpRequested.exchange(false); }
+
+	// writes every ring as Chrome trace JSON, open it in chrome://tracing or ui.perfetto.dev
+	bool dump(const std::string& path)
+	{
+		std::ofstream file(path);
+		if (!file) {
+			std::cout << "ERROR::PROFILER::OPEN_FAILED: " << path << std::endl;
+			return false;
+		}
+		file << std::fixed << std::setprecision(3);
+		file << "{\"traceEvents\":[\n";
+		bool first = true;
+		std::lock_guard<std::mutex> lock(mutex);
+		std::vector<ProfileEvent> events;
+		for (std::unique_ptr<ProfileRing>& ring : rings) {
+			events.clear();
+			ring->snapshot(events);
+			int tid = ring->index;
+			std::string threadName = ring->name != nullptr ? ring->name : tid == 0 ? "main" : "thread " + std::to_string(tid);
+			file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << tid
+				<< ",\"args\":{\"name\":\"" << threadName << "\"}}";
+			first = false;
+			for (const ProfileEvent& event : events) {
+				file << ",\n{\"name\":\"" << event.name << "\",\"pid\":0,\"tid\":" << tid << ",\"ts\":" << microseconds(event.start);
+				if (event.type == ProfileZoneEvent)
+					file << ",\"ph\":\"X\",\"dur\":" << (event.value - event.start) / 1000.0 << "}";
+				else if (event.type == ProfileCounterEvent)
+					file << ",\"ph\":\"C\",\"args\":{\"value\":" << event.value << "}}";
+				else
+					file << ",\"ph\":\"i\",\"s\":\"g\",\"args\":{\"frame\":" << event.value << "}}";
+			}
+		}
+		file << "\n]}\n";
+		std::cout << "Profile written to " << path << std::endl;
+		return true;
+	}
+
+private:
+	std::mutex mutex;
+	std::vector<std::unique_ptr<ProfileRing>> rings;
+	std::atomic<bool> dumpRequested{ false };
+	int64_t origin = Clock::now();
+
+	double microseconds(int64_t time) const { return (time - origin) / 1000.0; }
+};
+
+inline ProfileRing& profileThreadRing()
+{
+	struct Owner
+	{
+		ProfileRing* ring = nullptr;
+		~Owner()
+		{
+			if (ring != nullptr)
+				ring->inUse.store(false);
+		}
+	};
+	thread_local Owner owner;
+	if (owner.ring == nullptr)
+		owner.ring = Profiler::get().acquireRing();
+	return *owner.ring;
+}
+
+// times the enclosing scope
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const char* zoneName) : name(zoneName), start(Clock::now()) {}
+	~ProfileScope() { profileThreadRing().push(name, start, Clock::now(), ProfileZoneEvent); }
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+	const char* name;
+	int64_t start;
+};
+
+inline void profileCounter(const char* name, int64_t value)
+{
+	profileThreadRing().push(name, Clock::now(), value, ProfileCounterEvent);
+}
+
+// marks the end of a frame and writes a trace if one was asked for
+inline void profileFrame()
+{
+	static int64_t frame = 0;
+	profileThreadRing().push("frame", Clock::now(), frame, ProfileFrameEvent);
+	if (Profiler::get().takeDumpRequest())
+		Profiler::get().dump("profile_" + std::to_string(frame) + ".json");
+	frame++;
+}
+
+inline void profileSignalHandler(int)
+{
+	Profiler::get().requestDump();
+}
+
+// Ctrl+Break on Windows, kill -USR1 elsewhere
+inline void installProfileSignal()
+{
+#ifdef _WIN32
+	std::signal(SIGBREAK, profileSignalHandler);
+#else
+	std::signal(SIGUSR1, profileSignalHandler);
+#endif
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#if HATCH_PROFILER
+#define PROFILE_ZONE(name) ProfileScope PROFILE_CONCAT(profileZone, __COUNTER__)(name)
+#define PROFILE_COUNTER(name, value) profileCounter(name, (int64_t)(value))
+#define PROFILE_FRAME() profileFrame()
+#define PROFILE_REQUEST_DUMP() Profiler::get().requestDump()
+#define PROFILE_INSTALL_SIGNAL() installProfileSignal()
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_COUNTER(name, value) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+#define PROFILE_REQUEST_DUMP() ((void)0)
+#define PROFILE_INSTALL_SIGNAL() ((void)0)
+#endif
+
+// cost of one zone and one counter, printed by --bench-profiler
+inline void runProfilerBenchmark(int iterations = 1000000)
+{
+	volatile int sink = 0;
+	int64_t start = Clock::now();
+	for (int i = 0; i < iterations; i++)
+		sink = sink + 1;
+	int64_t empty = Clock::now() - start;
+
+	start = Clock::now();
+	for (int i = 0; i < iterations; i++) {
+		PROFILE_ZONE("benchmark zone");
+		sink = sink + 1;
+	}
+	int64_t zones = Clock::now() - start;
+
+	start = Clock::now();
+	for (int i = 0; i < iterations; i++) {
+		PROFILE_COUNTER("benchmark counter", i);
+		sink = sink + 1;
+	}
+	int64_t counters = Clock::now() - start;
+
+	std::cout << "Profiler " << (HATCH_PROFILER ? "enabled" : "disabled") << ", " << iterations << " iterations" << std::endl;
+	std::cout << "zone:    " << (double)(zones - empty) / iterations << " ns" << std::endl;
+	std::cout << "counter: " << (double)(counters - empty) / iterations << " ns" << std::endl;
+}
+#endif
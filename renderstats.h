@@ -0,0 +1,64 @@
+#ifndef RENDERSTATS_H
+#define RENDERSTATS_H
+
+#include <atomic>
+#include <cstdint>
+
+// what one frame asked of the gpu, counted at every draw call and buffer or texture upload
+struct RenderStats
+{
+	int draws = 0;
+	int64_t triangles = 0;
+	int64_t uploadBytes = 0;
+	int stateChanges = 0; // program, texture and vertex array binds
+};
+
+// stats of the frame being drawn, main() hands them to the frame report and clears them every frame
+inline RenderStats& renderStats()
+{
+	static RenderStats stats;
+	return stats;
+}
+
+inline void countDraw(int vertices, int instances = 1)
+{
+	RenderStats& stats = renderStats();
+	stats.draws++;
+	stats.triangles += (int64_t)(vertices / 3) * instances;
+}
+
+inline void countUpload(int64_t bytes)
+{
+	renderStats().uploadBytes += bytes;
+}
+
+inline void countStateChange(int changes = 1)
+{
+	renderStats().stateChanges += changes;
+}
+
+// running totals that outlive a frame, atomic so the metrics thread can read them any time
+struct GpuResourceStats
+{
+	std::atomic<int64_t> bufferBytes{ 0 };
+	std::atomic<int64_t> textureBytes{ 0 }; // estimated, driver padding and formats are not known
+	std::atomic<int64_t> shaderCompiles{ 0 };
+	std::atomic<int64_t> shaderFailures{ 0 };
+};
+
+inline GpuResourceStats& gpuResources()
+{
+	static GpuResourceStats resources;
+	return resources;
+}
+
+inline void countBufferMemory(int64_t bytes)
+{
+	gpuResources().bufferBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+inline void countTextureMemory(int64_t bytes)
+{
+	gpuResources().textureBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+#endif
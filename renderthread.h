@@ -0,0 +1,127 @@
+#ifndef RENDERTHREAD_H
+#define RENDERTHREAD_H
+
+#include <glad/glad.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "profiler.h"
+
+// Hands finished frames from the main thread to the render thread. With the default two
+// slots the main thread writes frame N+1 into one while the render thread reads frame N
+// from the other, and waits only when the render thread is a whole frame behind.
+// A published slot is never written again until the reader has finished with it.
+template <typename T, int Slots = 2>
+class SnapshotBuffer
+{
+public:
+	// slot for the next frame, waits until the render thread has let go of it
+	T& beginWrite()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		changed.wait(lock, [this]() { return written - read < Slots; });
+		return slots[written % Slots];
+	}
+
+	void publish()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			written++;
+		}
+		changed.notify_all();
+	}
+
+	// oldest published frame, nullptr once closed and every frame has been read
+	const T* beginRead()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		changed.wait(lock, [this]() { return closed || read < written; });
+		if (read == written)
+			return nullptr;
+		return &slots[read % Slots];
+	}
+
+	void endRead()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			read++;
+		}
+		changed.notify_all();
+	}
+
+	// no more frames, the reader finishes what is published then stops
+	void close()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			closed = true;
+		}
+		changed.notify_all();
+	}
+
+private:
+	T slots[Slots];
+	int64_t written = 0;
+	int64_t read = 0;
+	bool closed = false;
+	std::mutex mutex;
+	std::condition_variable changed;
+};
+
+// Keeps the driver at most framesInFlight frames ahead of the gpu. A fence goes in after
+// each frame's commands, and before frame N is submitted the render thread waits for the
+// fence of frame N - framesInFlight. Needs the gl context current on the calling thread.
+class FrameFences
+{
+public:
+	explicit FrameFences(int framesInFlight) : fences(framesInFlight < 1 ? 1 : framesInFlight, nullptr) {}
+
+	~FrameFences() { clear(); }
+
+	FrameFences(const FrameFences&) = delete;
+	FrameFences& operator=(const FrameFences&) = delete;
+
+	void wait(int64_t frame)
+	{
+		GLsync& fence = fences[frame % fences.size()];
+		if (fence == nullptr)
+			return;
+		PROFILE_ZONE("wait for gpu");
+		GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		for (;;) {
+			GLenum result = glClientWaitSync(fence, flags, 100000000); // 100ms, then ask again
+			if (result != GL_TIMEOUT_EXPIRED)
+				break; // signalled, or the wait failed and there is nothing left to wait for
+			flags = 0;
+		}
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	void signal(int64_t frame)
+	{
+		GLsync& fence = fences[frame % fences.size()];
+		if (fence != nullptr)
+			glDeleteSync(fence);
+		fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	// deletes every fence, call it while the context is still current
+	void clear()
+	{
+		for (GLsync& fence : fences) {
+			if (fence != nullptr)
+				glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+
+private:
+	std::vector<GLsync> fences;
+};
+#endif
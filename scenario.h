@@ -0,0 +1,283 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "camera.h"
+#include "timing.h"
+
+// camera position and direction at a time in the scenario
+struct CameraKey
+{
+	float time;
+	glm::vec3 position;
+	float yaw;
+	float pitch;
+};
+
+template <typename T>
+inline T catmullRom(const T& p0, const T& p1, const T& p2, const T& p3, float t)
+{
+	float t2 = t * t, t3 = t2 * t;
+	return 0.5f * ((2.0f * p1) + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 + (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+}
+
+// Catmull-Rom spline through the keys, the curve passes through every key at its time.
+// The first and last key are repeated so the path starts and ends on them.
+class CameraPath
+{
+public:
+	std::vector<CameraKey> keys; // in time order
+
+	void evaluate(float time, glm::vec3& position, float& yaw, float& pitch) const
+	{
+		if (keys.empty())
+			return;
+		if (keys.size() == 1 || time <= keys.front().time) {
+			set(keys.front(), position, yaw, pitch);
+			return;
+		}
+		if (time >= keys.back().time) {
+			set(keys.back(), position, yaw, pitch);
+			return;
+		}
+
+		int last = (int)keys.size() - 1;
+		int segment = 0;
+		while (segment < last - 1 && time >= keys[segment + 1].time)
+			segment++;
+		const CameraKey& k0 = keys[std::max(segment - 1, 0)];
+		const CameraKey& k1 = keys[segment];
+		const CameraKey& k2 = keys[segment + 1];
+		const CameraKey& k3 = keys[std::min(segment + 2, last)];
+		float t = (time - k1.time) / (k2.time - k1.time);
+		position = catmullRom(k0.position, k1.position, k2.position, k3.position, t);
+		yaw = catmullRom(k0.yaw, k1.yaw, k2.yaw, k3.yaw, t);
+		pitch = glm::clamp(catmullRom(k0.pitch, k1.pitch, k2.pitch, k3.pitch, t), -89.0f, 89.0f);
+	}
+
+private:
+	static void set(const CameraKey& key, glm::vec3& position, float& yaw, float& pitch)
+	{
+		position = key.position;
+		yaw = key.yaw;
+		pitch = key.pitch;
+	}
+};
+
+// something the scene does at a time, what the action means is up to the renderer
+struct ScenarioEvent
+{
+	float time;
+	std::string action; // lamp1, lamp2, lamp1light, lamp2light, dirlight, egg
+	std::string value;
+};
+
+// A benchmark run. Text file, one entry per line, # starts a comment:
+//   frames 1200           frames that are measured
+//   warmup 60             frames run first and not measured
+//   framerate 60          simulation steps this much time every frame, whatever the real frame time
+//   camera t x y z yaw pitch
+//   event t action value  e.g. event 4.5 lamp1 Other1, event 6 dirlight off, event 8 egg jump
+class Scenario
+{
+public:
+	std::string name;
+	int frames = 600;
+	int warmup = 60;
+	float framerate = 60.0f;
+	CameraPath path;
+	std::vector<ScenarioEvent> events; // in time order
+
+	bool load(const std::string& file)
+	{
+		std::ifstream in(file);
+		if (!in) {
+			std::cout << "ERROR::SCENARIO::OPEN_FAILED: " << file << std::endl;
+			return false;
+		}
+		name = file;
+		std::string line;
+		int lineNumber = 0;
+		while (std::getline(in, line)) {
+			lineNumber++;
+			line = line.substr(0, line.find('#'));
+			std::istringstream fields(line);
+			std::string entry;
+			if (!(fields >> entry))
+				continue;
+
+			bool ok = true;
+			if (entry == "frames")
+				ok = (bool)(fields >> frames) && frames > 0;
+			else if (entry == "warmup")
+				ok = (bool)(fields >> warmup) && warmup >= 0;
+			else if (entry == "framerate")
+				ok = (bool)(fields >> framerate) && framerate > 0.0f;
+			else if (entry == "camera") {
+				CameraKey key;
+				ok = (bool)(fields >> key.time >> key.position.x >> key.position.y >> key.position.z >> key.yaw >> key.pitch);
+				path.keys.push_back(key);
+			}
+			else if (entry == "event") {
+				ScenarioEvent event;
+				ok = (bool)(fields >> event.time >> event.action >> event.value);
+				events.push_back(event);
+			}
+			else
+				ok = false;
+			if (!ok) {
+				std::cout << "ERROR::SCENARIO::BAD_LINE: " << file << ":" << lineNumber << std::endl;
+				return false;
+			}
+		}
+		std::stable_sort(path.keys.begin(), path.keys.end(), [](const CameraKey& a, const CameraKey& b) { return a.time < b.time; });
+		std::stable_sort(events.begin(), events.end(), [](const ScenarioEvent& a, const ScenarioEvent& b) { return a.time < b.time; });
+		return true;
+	}
+
+	int64_t frameNanoseconds() const { return (int64_t)(NANOSECONDS_PER_SECOND / framerate); }
+};
+
+struct BenchmarkResult
+{
+	int frames = 0;
+	double p50 = 0.0, p95 = 0.0, p99 = 0.0; // frame times in ms
+	double mean = 0.0, max = 0.0;
+};
+
+inline BenchmarkResult frameTimePercentiles(std::vector<float> frameMs)
+{
+	BenchmarkResult result;
+	result.frames = (int)frameMs.size();
+	if (frameMs.empty())
+		return result;
+	std::sort(frameMs.begin(), frameMs.end());
+	int last = result.frames - 1;
+	result.p50 = frameMs[(int)(0.50 * last + 0.5)];
+	result.p95 = frameMs[(int)(0.95 * last + 0.5)];
+	result.p99 = frameMs[(int)(0.99 * last + 0.5)];
+	result.max = frameMs[last];
+	double total = 0.0;
+	for (float ms : frameMs)
+		total += ms;
+	result.mean = total / result.frames;
+	return result;
+}
+
+inline bool writeBenchmarkJson(const std::string& file, const std::string& scenario, const BenchmarkResult& result)
+{
+	std::ofstream out(file);
+	if (!out) {
+		std::cout << "ERROR::SCENARIO::WRITE_FAILED: " << file << std::endl;
+		return false;
+	}
+	std::string name;
+	for (char c : scenario)
+		name += (c == '\\' || c == '"') ? '/' : c;
+	out << std::fixed << std::setprecision(4);
+	out << "{\n  \"scenario\": \"" << name << "\",\n  \"frames\": " << result.frames
+		<< ",\n  \"p50_ms\": " << result.p50 << ",\n  \"p95_ms\": " << result.p95 << ",\n  \"p99_ms\": " << result.p99
+		<< ",\n  \"mean_ms\": " << result.mean << ",\n  \"max_ms\": " << result.max << "\n}\n";
+	return true;
+}
+
+// reads back what writeBenchmarkJson wrote, only the keys it needs
+inline bool readBenchmarkJson(const std::string& file, BenchmarkResult& result)
+{
+	std::ifstream in(file);
+	if (!in) {
+		std::cout << "ERROR::SCENARIO::BASELINE_NOT_FOUND: " << file << std::endl;
+		return false;
+	}
+	std::stringstream buffer;
+	buffer << in.rdbuf();
+	std::string json = buffer.str();
+	auto number = [&](const char* key, double& value) {
+		size_t at = json.find(std::string("\"") + key + "\"");
+		if (at == std::string::npos)
+			return false;
+		at = json.find(':', at);
+		if (at == std::string::npos)
+			return false;
+		std::istringstream field(json.substr(at + 1));
+		return (bool)(field >> value);
+	};
+	if (!number("p50_ms", result.p50) || !number("p95_ms", result.p95) || !number("p99_ms", result.p99)) {
+		std::cout << "ERROR::SCENARIO::INVALID_BASELINE: " << file << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// false when any percentile is more than tolerance slower than the baseline
+inline bool compareToBaseline(const BenchmarkResult& result, const BenchmarkResult& baseline, double tolerance)
+{
+	const char* names[] = { "p50", "p95", "p99" };
+	double current[] = { result.p50, result.p95, result.p99 };
+	double previous[] = { baseline.p50, baseline.p95, baseline.p99 };
+	bool passed = true;
+	std::cout << std::fixed << std::setprecision(3);
+	for (int i = 0; i < 3; i++) {
+		double change = previous[i] > 0.0 ? current[i] / previous[i] - 1.0 : 0.0;
+		bool regressed = change > tolerance;
+		passed = passed && !regressed;
+		std::cout << "  " << names[i] << " " << current[i] << "ms, baseline " << previous[i] << "ms ("
+			<< (change >= 0.0 ? "+" : "") << change * 100.0 << "%)" << (regressed ? " REGRESSION" : "") << std::endl;
+	}
+	std::cout << std::defaultfloat;
+	return passed;
+}
+
+// Plays a scenario one frame at a time. Scenario time advances by the fixed frame time,
+// so the camera and events land on the same frames in every run.
+class ScenarioRun
+{
+public:
+	explicit ScenarioRun(const Scenario& played) : scenario(played)
+	{
+		frameMs.reserve(scenario.frames);
+	}
+
+	bool finished() const { return frame >= scenario.warmup + scenario.frames; }
+
+	float time() const { return frame / scenario.framerate; }
+
+	// puts the camera on the path and returns the events due by this frame
+	const std::vector<ScenarioEvent>& beginFrame(Camera& camera)
+	{
+		scenario.path.evaluate(time(), camera.Position, camera.Yaw, camera.Pitch);
+		camera.updateCameraVectors();
+		due.clear();
+		while (nextEvent < scenario.events.size() && scenario.events[nextEvent].time <= time())
+			due.push_back(scenario.events[nextEvent++]);
+		return due;
+	}
+
+	// warmup frames are run but not measured
+	void endFrame(float ms)
+	{
+		if (frame >= scenario.warmup)
+			frameMs.push_back(ms);
+		frame++;
+	}
+
+	BenchmarkResult result() const { return frameTimePercentiles(frameMs); }
+
+private:
+	const Scenario& scenario;
+	int frame = 0;
+	size_t nextEvent = 0;
+	std::vector<ScenarioEvent> due;
+	std::vector<float> frameMs;
+};
+#endif
@@ -0,0 +1,135 @@
+#ifndef SKINNING_H
+#define SKINNING_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "mesh.h"
+#include "renderstats.h"
+#include "shader.h"
+#include "vertexformat.h"
+
+// every skinned vertex is a normal mesh vertex plus the bone it follows
+const int SKINNED_VERTEX_FLOATS = MESH_VERTEX_FLOATS + 1;
+
+// as uploaded: float position, 2_10_10_10 normal, half texture coords and a byte bone index,
+// 24 bytes instead of 36
+typedef VertexFormat<VertexAttribute<0, FloatAttribute<3>, 0>, VertexAttribute<1, PackedNormalAttribute<3>, 3>,
+	VertexAttribute<2, HalfAttribute<2>, 6>, VertexAttribute<3, ByteAttribute, 8>> SkinnedVertexFormat;
+
+// texture unit the bone palette is bound to, 0 and 1 are the material samplers
+const int BONE_PALETTE_UNIT = 2;
+
+// one rigid part of a rig, e.g. the lamp base or a horn
+struct SkinnedPart
+{
+	const MeshData* mesh;
+	int bone;
+};
+
+// Merges all parts of an articulated rig into a single mesh tagged with bone indices.
+// Every rig drawn in a frame adds its bone matrices to a palette stored in a texture buffer,
+// then all of them are drawn with one instanced draw call.
+class SkinnedRig
+{
+public:
+	int boneCount;
+	unsigned int indexCount = 0;
+
+	SkinnedRig(const std::vector<SkinnedPart>& parts, int bones) : boneCount(bones)
+	{
+		std::vector<float> vertices;
+		std::vector<unsigned int> indices;
+
+		for (const SkinnedPart& part : parts) {
+			unsigned int firstVertex = (unsigned int)(vertices.size() / SKINNED_VERTEX_FLOATS);
+			const std::vector<float>& src = part.mesh->vertices;
+			for (size_t v = 0; v < src.size(); v += MESH_VERTEX_FLOATS) {
+				vertices.insert(vertices.end(), src.begin() + v, src.begin() + v + MESH_VERTEX_FLOATS);
+				vertices.push_back((float)part.bone);
+			}
+			for (unsigned int index : part.mesh->indices) {
+				indices.push_back(firstVertex + index);
+			}
+		}
+		indexCount = (unsigned int)indices.size();
+		std::vector<unsigned char> packed = SkinnedVertexFormat::encode(vertices.data(), vertices.size() / SKINNED_VERTEX_FLOATS, SKINNED_VERTEX_FLOATS);
+
+		glGenVertexArrays(1, &VAO);
+		glGenBuffers(1, &VBO);
+		glGenBuffers(1, &EBO);
+		glBindVertexArray(VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		glBufferData(GL_ARRAY_BUFFER, packed.size(), packed.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+		countUpload(packed.size() + indices.size() * sizeof(unsigned int));
+		countBufferMemory(packed.size() + indices.size() * sizeof(unsigned int));
+		SkinnedVertexFormat::setup();
+		glBindVertexArray(0);
+
+		// palette lives in a texture buffer so the number of rigs is not limited by uniform space
+		glGenBuffers(1, &paletteBuffer);
+		glGenTextures(1, &paletteTexture);
+		glBindBuffer(GL_TEXTURE_BUFFER, paletteBuffer);
+		glBufferData(GL_TEXTURE_BUFFER, sizeof(glm::mat4) * boneCount, NULL, GL_STREAM_DRAW);
+		paletteCapacity = sizeof(glm::mat4) * boneCount;
+		countBufferMemory(paletteCapacity);
+		glBindTexture(GL_TEXTURE_BUFFER, paletteTexture);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, paletteBuffer);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+	}
+
+	// adds one rig to this frame's batch, bones must hold boneCount world matrices
+	void addInstance(const glm::mat4* bones)
+	{
+		palette.insert(palette.end(), bones, bones + boneCount);
+	}
+
+	int instanceCount() const { return (int)(palette.size() / boneCount); }
+
+	// uploads the palette and draws every rig added since the last draw
+	void draw(Shader& shader)
+	{
+		int instances = instanceCount();
+		if (instances == 0)
+			return;
+
+		glBindBuffer(GL_TEXTURE_BUFFER, paletteBuffer);
+		size_t bytes = palette.size() * sizeof(glm::mat4);
+		if (bytes > paletteCapacity) {
+			countBufferMemory(bytes - paletteCapacity);
+			paletteCapacity = bytes;
+		}
+		glBufferData(GL_TEXTURE_BUFFER, paletteCapacity, NULL, GL_STREAM_DRAW); // orphan last frame's palette
+		glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, palette.data());
+		countUpload(bytes);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+		glActiveTexture(GL_TEXTURE0 + BONE_PALETTE_UNIT);
+		glBindTexture(GL_TEXTURE_BUFFER, paletteTexture);
+
+		shader.use();
+		shader.setInt("bonePalette", BONE_PALETTE_UNIT);
+		shader.setInt("bonesPerRig", boneCount);
+
+		glBindVertexArray(VAO);
+		glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (void*)0, instances);
+		countDraw(indexCount, instances);
+		countStateChange(2); // palette texture and vertex array
+		glBindVertexArray(0);
+
+		glActiveTexture(GL_TEXTURE0);
+		palette.clear();
+	}
+
+private:
+	unsigned int VAO = 0, VBO = 0, EBO = 0;
+	unsigned int paletteBuffer = 0, paletteTexture = 0;
+	size_t paletteCapacity = 0;
+	std::vector<glm::mat4> palette;
+};
+#endif
@@ -0,0 +1,116 @@
+#ifndef STATICBATCH_H
+#define STATICBATCH_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <vector>
+
+#include "mesh.h"
+#include "renderstats.h"
+#include "vertexformat.h"
+
+// what a static draw binds: diffuse on unit 0, specular on unit 1 and its shininess
+struct StaticMaterial {
+	unsigned int diffuse;
+	unsigned int specular;
+	float shininess;
+
+	bool operator==(const StaticMaterial& other) const
+	{
+		return diffuse == other.diffuse && specular == other.specular && shininess == other.shininess;
+	}
+};
+
+// every piece added with one material, a range of the merged indices
+struct StaticBatch {
+	StaticMaterial material;
+	unsigned int firstIndex;
+	unsigned int indexCount;
+	int pieces;
+};
+
+// Geometry that never moves, merged at load instead of drawn piece by piece. add transforms
+// each piece into world space with its model matrix and appends it to the batch of its
+// material, in the order the materials were first seen. build uploads every batch into one
+// CompactVertexFormat mesh, after which each batch is one draw with an identity model and
+// nothing about it is rebuilt per frame. Needs a current gl context for build and draw.
+class StaticBatcher
+{
+public:
+	// index of the batch the piece joined, or -1 once the batches are built
+	int add(const MeshData& piece, const glm::mat4& model, const StaticMaterial& material)
+	{
+		if (built) {
+			std::cout << "ERROR::STATICBATCH::ALREADY_BUILT: pieces must be added before build" << std::endl;
+			return -1;
+		}
+		int batch = 0;
+		while (batch < (int)batches.size() && !(batches[batch].material == material))
+			batch++;
+		if (batch == (int)batches.size()) {
+			batches.push_back({ material, 0, 0, 0 });
+			geometry.push_back(MeshData());
+		}
+
+		MeshData& merged = geometry[batch];
+		unsigned int base = merged.vertexCount();
+		glm::mat3 normalModel = glm::transpose(glm::inverse(glm::mat3(model)));
+		for (unsigned int v = 0; v < piece.vertexCount(); v++) {
+			const float* vertex = &piece.vertices[v * MESH_VERTEX_FLOATS];
+			glm::vec3 position = glm::vec3(model * glm::vec4(vertex[0], vertex[1], vertex[2], 1.0f));
+			glm::vec3 normal = glm::normalize(normalModel * glm::vec3(vertex[3], vertex[4], vertex[5])); // packed normals need unit length
+			const float world[MESH_VERTEX_FLOATS] = { position.x, position.y, position.z, normal.x, normal.y, normal.z, vertex[6], vertex[7] };
+			merged.vertices.insert(merged.vertices.end(), world, world + MESH_VERTEX_FLOATS);
+		}
+		for (unsigned int index : piece.indices)
+			merged.indices.push_back(base + index);
+		batches[batch].pieces++;
+		return batch;
+	}
+
+	// every batch into one vertex and index buffer
+	void build()
+	{
+		MeshData merged;
+		for (size_t i = 0; i < batches.size(); i++) {
+			unsigned int base = merged.vertexCount();
+			batches[i].firstIndex = (unsigned int)merged.indices.size();
+			batches[i].indexCount = (unsigned int)geometry[i].indices.size();
+			merged.vertices.insert(merged.vertices.end(), geometry[i].vertices.begin(), geometry[i].vertices.end());
+			for (unsigned int index : geometry[i].indices)
+				merged.indices.push_back(base + index);
+		}
+		mesh = Mesh::encoded<CompactVertexFormat>(merged);
+		geometry.clear();
+		geometry.shrink_to_fit();
+		built = true;
+	}
+
+	int batchCount() const { return (int)batches.size(); }
+
+	const StaticBatch& batch(int i) const { return batches[i]; }
+
+	// binds the batch's textures and draws it, the caller binds its draw constants
+	void draw(int i) const
+	{
+		const StaticBatch& batch = batches[i];
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, batch.material.diffuse);
+		countStateChange();
+
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, batch.material.specular);
+		countStateChange();
+
+		mesh.drawRange(batch.firstIndex, batch.indexCount);
+	}
+
+private:
+	std::vector<StaticBatch> batches;
+	std::vector<MeshData> geometry; // world space pieces of each batch until build
+	Mesh mesh;
+	bool built = false;
+};
+#endif
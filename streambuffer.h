@@ -0,0 +1,155 @@
+#ifndef STREAMBUFFER_H
+#define STREAMBUFFER_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#include "renderstats.h"
+#include "renderthread.h"
+
+// glad is generated for 3.3, so ARB_buffer_storage is loaded by hand
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+typedef void (APIENTRYP HatchBufferStorageProc)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+// Buffer for data written by the cpu every frame, split into regions used in turn, three by
+// default so the gpu can still read two frames while the third is written. With
+// ARB_buffer_storage the whole buffer is mapped once for good and each region is guarded
+// by a fence. On plain 3.3 each frame maps only its region, unsynchronized, and the buffer
+// is orphaned whenever the ring wraps so the driver hands over fresh storage instead of
+// waiting. The mapping ends at endWrites() then, so write everything before drawing.
+class StreamBuffer
+{
+public:
+	StreamBuffer(GLenum target, GLsizeiptr regionBytes, GLADloadproc load, int regions = 3)
+		: target(target), regionBytes(regionBytes), regions(regions), fences(regions)
+	{
+		HatchBufferStorageProc bufferStorage = nullptr;
+		if (hasExtension("GL_ARB_buffer_storage"))
+			bufferStorage = (HatchBufferStorageProc)load("glBufferStorage");
+
+		glGenBuffers(1, &buffer);
+		glBindBuffer(target, buffer);
+		if (bufferStorage != nullptr) {
+			GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			bufferStorage(target, size(), nullptr, flags);
+			mapped = (unsigned char*)glMapBufferRange(target, 0, size(), flags);
+			if (mapped == nullptr) {
+				// immutable storage can't be orphaned, so the 3.3 path needs a buffer of its own
+				std::cout << "ERROR::STREAMBUFFER::MAP_FAILED: persistent mapping refused, mapping per frame" << std::endl;
+				glBindBuffer(target, 0);
+				glDeleteBuffers(1, &buffer);
+				glGenBuffers(1, &buffer);
+				glBindBuffer(target, buffer);
+				bufferStorage = nullptr;
+			}
+		}
+		if (bufferStorage == nullptr)
+			glBufferData(target, size(), nullptr, GL_STREAM_DRAW);
+		glBindBuffer(target, 0);
+		countBufferMemory(size());
+	}
+
+	~StreamBuffer() { release(); }
+
+	// deletes the fences and the buffer, call it while the context is still current
+	void release()
+	{
+		if (buffer == 0)
+			return;
+		fences.clear();
+		if (mapped != nullptr || regionMapped) {
+			glBindBuffer(target, buffer);
+			glUnmapBuffer(target);
+			glBindBuffer(target, 0);
+		}
+		glDeleteBuffers(1, &buffer);
+		countBufferMemory(-size());
+		buffer = 0;
+		mapped = nullptr;
+		regionMapped = false;
+	}
+
+	StreamBuffer(const StreamBuffer&) = delete;
+	StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+	bool persistent() const { return mapped != nullptr; }
+	GLuint id() const { return buffer; }
+	GLsizeiptr size() const { return regionBytes * regions; }
+
+	// region of this frame, nullptr if it could not be mapped
+	unsigned char* beginFrame(int64_t frame)
+	{
+		PROFILE_ZONE("stream buffer");
+		this->frame = frame;
+		region = (GLintptr)(frame % regions) * regionBytes;
+		if (persistent()) {
+			fences.wait(frame); // the gpu is done with what was last written here
+			return mapped + region;
+		}
+		glBindBuffer(target, buffer);
+		if (region == 0)
+			glBufferData(target, size(), nullptr, GL_STREAM_DRAW); // orphan, the gpu keeps the old storage
+		unsigned char* write = (unsigned char*)glMapBufferRange(target, region, regionBytes,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		glBindBuffer(target, 0);
+		regionMapped = write != nullptr;
+		return write;
+	}
+
+	void endWrites(GLsizeiptr written)
+	{
+		if (persistent()) {
+			countUpload(written);
+			return; // coherent, nothing to flush
+		}
+		if (!regionMapped)
+			return; // the map failed, nothing was written
+		countUpload(written);
+		glBindBuffer(target, buffer);
+		glUnmapBuffer(target);
+		glBindBuffer(target, 0);
+		regionMapped = false;
+	}
+
+	// after the last draw reading this frame's region
+	void endFrame()
+	{
+		if (persistent())
+			fences.signal(frame);
+	}
+
+	// offset of the frame's region in the buffer
+	GLintptr regionOffset() const { return region; }
+
+private:
+	GLenum target;
+	GLsizeiptr regionBytes;
+	int regions;
+	GLuint buffer = 0;
+	unsigned char* mapped = nullptr;
+	bool regionMapped = false; // this frame's region, without persistent mapping
+	FrameFences fences;
+	int64_t frame = 0;
+	GLintptr region = 0;
+
+	static bool hasExtension(const char* name)
+	{
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+		for (GLint i = 0; i < count; i++) {
+			const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+			if (extension != nullptr && std::strcmp(extension, name) == 0)
+				return true;
+		}
+		return false;
+	}
+};
+#endif
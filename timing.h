@@ -0,0 +1,76 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+
+const int64_t NANOSECONDS_PER_SECOND = 1000000000;
+
+// Monotonic 64 bit nanosecond clock. Unlike a float seconds value it keeps full
+// precision for centuries of uptime, only differences are ever turned into floats.
+class Clock
+{
+public:
+	Clock() : start(now()) {}
+
+	static int64_t now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// nanoseconds since the clock was created
+	int64_t elapsed() const { return now() - start; }
+
+	static double toSeconds(int64_t nanoseconds) { return (double)nanoseconds / (double)NANOSECONDS_PER_SECOND; }
+
+private:
+	int64_t start;
+};
+
+// Turns variable frame times into a whole number of fixed simulation steps.
+// Simulation only ever sees step(), so its results do not depend on the frame rate;
+// rendering blends the last two simulated states with alpha().
+class FixedStepTimer
+{
+public:
+	double timeScale = 1.0; // 0.5 runs the simulation at half speed
+	bool paused = false;
+
+	FixedStepTimer(int stepsPerSecond = 120, int maxSteps = 8)
+		: stepNanoseconds(NANOSECONDS_PER_SECOND / stepsPerSecond), maxStepsPerFrame(maxSteps) {}
+
+	// adds one frame of real time, returns how many fixed steps to simulate
+	int advance(int64_t frameNanoseconds)
+	{
+		if (!paused) {
+			accumulator += (int64_t)((double)frameNanoseconds * timeScale);
+		}
+
+		int64_t steps = accumulator / stepNanoseconds;
+		if (steps > maxStepsPerFrame) {
+			// after a long stall drop the time rather than spiral trying to catch up
+			steps = maxStepsPerFrame;
+			accumulator = steps * stepNanoseconds;
+		}
+		accumulator -= steps * stepNanoseconds;
+		ticks += steps;
+		return (int)steps;
+	}
+
+	// seconds per step
+	float step() const { return (float)Clock::toSeconds(stepNanoseconds); }
+
+	// how far rendering is between the previous and the current simulated state
+	float alpha() const { return (float)((double)accumulator / (double)stepNanoseconds); }
+
+	int64_t steps() const { return ticks; }
+	double simulationTime() const { return Clock::toSeconds(ticks * stepNanoseconds); }
+
+private:
+	int64_t stepNanoseconds;
+	int maxStepsPerFrame;
+	int64_t accumulator = 0;
+	int64_t ticks = 0;
+};
+#endif
@@ -0,0 +1,231 @@
+#ifndef VERTEXFORMAT_H
+#define VERTEXFORMAT_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Positions quantized to 16 bits cover the mesh's bounds, position = offset + q * scale with
+// q in 0..1. The transform is folded into the model matrix, see dequantizeMatrix.
+struct VertexQuantization
+{
+	glm::vec3 offset = glm::vec3(0.0f);
+	glm::vec3 scale = glm::vec3(1.0f);
+};
+
+inline VertexQuantization quantizationFromBounds(const glm::vec3& low, const glm::vec3& high)
+{
+	VertexQuantization quantization;
+	quantization.offset = low;
+	for (int i = 0; i < 3; i++)
+		quantization.scale[i] = high[i] > low[i] ? high[i] - low[i] : 1.0f;
+	return quantization;
+}
+
+inline glm::mat4 dequantizeMatrix(const VertexQuantization& quantization)
+{
+	glm::mat4 matrix(1.0f);
+	for (int i = 0; i < 3; i++) {
+		matrix[i][i] = quantization.scale[i];
+		matrix[3][i] = quantization.offset[i];
+	}
+	return matrix;
+}
+
+// round to nearest even, overflow goes to infinity and tiny values to half subnormals
+inline uint16_t floatToHalf(float value)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+	uint32_t exponent = (bits >> 23) & 0xFF;
+	uint32_t mantissa = bits & 0x7FFFFF;
+	if (exponent == 0xFF)
+		return sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0);
+	int halfExponent = (int)exponent - 127 + 15;
+	if (halfExponent >= 31)
+		return sign | 0x7C00;
+	if (halfExponent <= 0) {
+		if (halfExponent < -10)
+			return sign;
+		mantissa |= 0x800000;
+		int shift = 14 - halfExponent;
+		uint32_t half = mantissa >> shift;
+		uint32_t rest = mantissa & ((1u << shift) - 1);
+		uint32_t halfway = 1u << (shift - 1);
+		if (rest > halfway || (rest == halfway && (half & 1)))
+			half++;
+		return sign | (uint16_t)half;
+	}
+	uint32_t half = ((uint32_t)halfExponent << 10) | (mantissa >> 13);
+	uint32_t rest = mantissa & 0x1FFF;
+	if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+		half++; // may carry into the exponent, which rounds up to the next power of two or infinity
+	return sign | (uint16_t)half;
+}
+
+// Attribute encodings. Each writes one attribute of Bytes bytes from floats of the source
+// vertex and says how gl reads it back. Bytes are kept multiples of 4 so every attribute
+// stays aligned.
+template <int Components>
+struct FloatAttribute
+{
+	static const int components = Components;
+	static const GLenum type = GL_FLOAT;
+	static const GLboolean normalized = GL_FALSE;
+	static const size_t bytes = Components * sizeof(float);
+	static void encode(const float* in, unsigned char* out, const VertexQuantization&) { std::memcpy(out, in, bytes); }
+};
+
+template <int Components>
+struct HalfAttribute
+{
+	static const int components = Components;
+	static const GLenum type = GL_HALF_FLOAT;
+	static const GLboolean normalized = GL_FALSE;
+	static const size_t bytes = (Components * sizeof(uint16_t) + 3) & ~(size_t)3;
+	static void encode(const float* in, unsigned char* out, const VertexQuantization&)
+	{
+		uint16_t halves[4] = {};
+		for (int i = 0; i < Components; i++)
+			halves[i] = floatToHalf(in[i]);
+		std::memcpy(out, halves, bytes);
+	}
+};
+
+// A unit vector in 2_10_10_10, normalized to -1..1 by gl. Sources of 4 floats keep the sign
+// of the 4th, such as a tangent's bitangent sign, in the 2 bit w.
+template <int SourceComponents>
+struct PackedNormalAttribute
+{
+	static const int components = 4;
+	static const GLenum type = GL_INT_2_10_10_10_REV;
+	static const GLboolean normalized = GL_TRUE;
+	static const size_t bytes = 4;
+	static void encode(const float* in, unsigned char* out, const VertexQuantization&)
+	{
+		glm::vec3 v(in[0], in[1], in[2]);
+		float length = glm::length(v);
+		v = length > 0.0f ? v / length : glm::vec3(0.0f);
+		auto pack = [](float x) { return (uint32_t)(int32_t)std::lround(glm::clamp(x, -1.0f, 1.0f) * 511.0f) & 0x3FF; };
+		uint32_t w = SourceComponents > 3 && in[SourceComponents - 1] < 0.0f ? 3u : 1u; // -1 or 1 in 2 bits
+		uint32_t packed = pack(v.x) | pack(v.y) << 10 | pack(v.z) << 20 | w << 30;
+		std::memcpy(out, &packed, sizeof(packed));
+	}
+};
+
+// a position as three 16 bit fractions of the quantization bounds, padded to 8 bytes
+struct QuantizedPositionAttribute
+{
+	static const int components = 3;
+	static const GLenum type = GL_UNSIGNED_SHORT;
+	static const GLboolean normalized = GL_TRUE;
+	static const size_t bytes = 8;
+	static void encode(const float* in, unsigned char* out, const VertexQuantization& quantization)
+	{
+		uint16_t q[4] = {};
+		for (int i = 0; i < 3; i++) {
+			float t = (in[i] - quantization.offset[i]) / quantization.scale[i];
+			q[i] = (uint16_t)std::lround(glm::clamp(t, 0.0f, 1.0f) * 65535.0f);
+		}
+		std::memcpy(out, q, bytes);
+	}
+};
+
+// a small integer such as a bone index, read by the shader as a float
+struct ByteAttribute
+{
+	static const int components = 1;
+	static const GLenum type = GL_UNSIGNED_BYTE;
+	static const GLboolean normalized = GL_FALSE;
+	static const size_t bytes = 4;
+	static void encode(const float* in, unsigned char* out, const VertexQuantization&)
+	{
+		unsigned char value[4] = { (unsigned char)glm::clamp(in[0], 0.0f, 255.0f), 0, 0, 0 };
+		std::memcpy(out, value, bytes);
+	}
+};
+
+// shader location Location, encoded with Encoding from the float at Source onwards
+template <GLuint Location, class Encoding, int Source>
+struct VertexAttribute
+{
+	typedef Encoding encoding;
+	static const GLuint location = Location;
+	static const int source = Source;
+};
+
+template <size_t Offset, class... Attributes>
+struct VertexAttributeList
+{
+	static const size_t end = Offset;
+	static void setup(GLsizei) {}
+	static void encode(const float*, unsigned char*, const VertexQuantization&) {}
+};
+
+template <size_t Offset, class First, class... Rest>
+struct VertexAttributeList<Offset, First, Rest...>
+{
+	typedef typename First::encoding Encoding;
+	typedef VertexAttributeList<Offset + Encoding::bytes, Rest...> Next;
+	static const size_t end = Next::end;
+
+	static void setup(GLsizei stride)
+	{
+		glEnableVertexAttribArray(First::location);
+		glVertexAttribPointer(First::location, Encoding::components, Encoding::type, Encoding::normalized, stride, (void*)Offset);
+		Next::setup(stride);
+	}
+
+	static void encode(const float* in, unsigned char* out, const VertexQuantization& quantization)
+	{
+		Encoding::encode(in + First::source, out + Offset, quantization);
+		Next::encode(in, out, quantization);
+	}
+};
+
+// An interleaved vertex layout fixed at compile time. The attribute offsets and stride are
+// worked out from the list, setup points the bound VAO at them and encode packs float
+// vertices into it.
+template <class... Attributes>
+struct VertexFormat
+{
+	typedef VertexAttributeList<0, Attributes...> List;
+	static const size_t stride = List::end;
+
+	// attribute pointers into the bound GL_ARRAY_BUFFER for the bound VAO
+	static void setup() { List::setup((GLsizei)stride); }
+
+	static std::vector<unsigned char> encode(const float* vertices, size_t vertexCount, int vertexFloats,
+		const VertexQuantization& quantization = VertexQuantization())
+	{
+		std::vector<unsigned char> out(vertexCount * stride);
+		for (size_t v = 0; v < vertexCount; v++)
+			List::encode(vertices + v * vertexFloats, out.data() + v * stride, quantization);
+		return out;
+	}
+};
+
+// the float layouts meshes are built in, 32 bytes and 48 bytes with a tangent (cooked meshes)
+typedef VertexFormat<VertexAttribute<0, FloatAttribute<3>, 0>, VertexAttribute<1, FloatAttribute<3>, 3>,
+	VertexAttribute<2, FloatAttribute<2>, 6>> MeshVertexFormat;
+typedef VertexFormat<VertexAttribute<0, FloatAttribute<3>, 0>, VertexAttribute<1, FloatAttribute<3>, 3>,
+	VertexAttribute<2, FloatAttribute<2>, 6>, VertexAttribute<4, FloatAttribute<4>, 8>> CookedVertexFormat;
+
+// float position, 2_10_10_10 normal and half texture coords, 20 bytes
+typedef VertexFormat<VertexAttribute<0, FloatAttribute<3>, 0>, VertexAttribute<1, PackedNormalAttribute<3>, 3>,
+	VertexAttribute<2, HalfAttribute<2>, 6>> CompactVertexFormat;
+
+// the cooked layout compacted, 24 bytes, and with quantized positions, 20 bytes
+typedef VertexFormat<VertexAttribute<0, FloatAttribute<3>, 0>, VertexAttribute<1, PackedNormalAttribute<3>, 3>,
+	VertexAttribute<2, HalfAttribute<2>, 6>, VertexAttribute<4, PackedNormalAttribute<4>, 8>> CompactCookedVertexFormat;
+typedef VertexFormat<VertexAttribute<0, QuantizedPositionAttribute, 0>, VertexAttribute<1, PackedNormalAttribute<3>, 3>,
+	VertexAttribute<2, HalfAttribute<2>, 6>, VertexAttribute<4, PackedNormalAttribute<4>, 8>> QuantizedCookedVertexFormat;
+
+// positions only, the skybox
+typedef VertexFormat<VertexAttribute<0, FloatAttribute<3>, 0>> PositionVertexFormat;
+#endif